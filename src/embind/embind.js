@@ -13,8 +13,9 @@
 /*global typeDependencies, flushPendingDeletes, getTypeName, getBasestPointer, throwBindingError, UnboundTypeError, _embind_repr, registeredInstances, registeredTypes, getShiftFromSize*/
 /*global ensureOverloadTable, requireFunction, awaitingDependencies, makeLegalFunctionName, embind_charCodes:true, registerType, createNamedFunction, RegisteredPointer, throwInternalError*/
 /*global simpleReadValueFromPointer, floatReadValueFromPointer, integerReadValueFromPointer, enumReadValueFromPointer, replacePublicSymbol, craftInvokerFunction, tupleRegistrations*/
+/*global getDirectFieldAccessors, makeValueTypeAllocator, CommandBuffer, batchedCallDispatcher:true, makeBatchedCallRecorder*/
 /*global ClassHandle, makeClassHandle, structRegistrations, whenDependentTypesAreResolved, BindingError, deletionQueue, delayFunction:true, upcastPointer*/
-/*global exposePublicSymbol, heap32VectorToArray, new_, RegisteredPointer_getPointee, RegisteredPointer_destructor, RegisteredPointer_deleteObject, char_0, char_9*/
+/*global exposePublicSymbol, heap32VectorToArray, dynCallerFactories, new_, RegisteredPointer_getPointee, RegisteredPointer_destructor, RegisteredPointer_deleteObject, char_0, char_9*/
 /*global getInheritedInstanceCount, getLiveInheritedInstances, setDelayFunction, InternalError, runDestructors*/
 /*global requireRegisteredType, unregisterInheritedInstance, registerInheritedInstance, PureVirtualError, throwUnboundTypeError*/
 /*global assert, validateThis, downcastPointer, registeredPointers, RegisteredClass, getInheritedInstance, ClassHandle_isAliasOf, ClassHandle_clone, ClassHandle_isDeleted, ClassHandle_deleteLater*/
@@ -910,22 +911,32 @@ var LibraryEmbind = {
     return invokerFunction;
   },
 
-  $requireFunction__deps: ['$readLatin1String', '$throwBindingError'],
+  // signature -> function(dynCall, rawFunction) returning a dynCall wrapper.
+  // Compiling one per signature rather than per registered function keeps
+  // startup cheap for large bindings.
+  $dynCallerFactories: {},
+
+  $requireFunction__deps: ['$dynCallerFactories', '$readLatin1String', '$throwBindingError'],
   $requireFunction: function(signature, rawFunction) {
     signature = readLatin1String(signature);
 
     function makeDynCaller(dynCall) {
-        var args = [];
-        for (var i = 1; i < signature.length; ++i) {
-            args.push('a' + i);
-        }
+        var factory = dynCallerFactories[signature];
+        if (factory === undefined) {
+            var args = [];
+            for (var i = 1; i < signature.length; ++i) {
+                args.push('a' + i);
+            }
 
-        var name = 'dynCall_' + signature + '_' + rawFunction;
-        var body = 'return function ' + name + '(' + args.join(', ') + ') {\n';
-        body    += '    return dynCall(rawFunction' + (args.length ? ', ' : '') + args.join(', ') + ');\n';
-        body    += '};\n';
+            var name = 'dynCall_' + signature;
+            var body = 'return function ' + name + '(' + args.join(', ') + ') {\n';
+            body    += '    return dynCall(rawFunction' + (args.length ? ', ' : '') + args.join(', ') + ');\n';
+            body    += '};\n';
 
-        return (new Function('dynCall', 'rawFunction', body))(dynCall, rawFunction);
+            factory = new Function('dynCall', 'rawFunction', body);
+            dynCallerFactories[signature] = factory;
+        }
+        return factory(dynCall, rawFunction);
     }
 
     var fp;
@@ -984,6 +995,216 @@ var LibraryEmbind = {
     });
   },
 
+  $batchedCallDispatcher: undefined,
+
+  $init_CommandBuffer__deps: ['$batchedCallDispatcher', '$runDestructors', '$throwBindingError', 'free'],
+  $init_CommandBuffer: function() {
+    CommandBuffer.prototype['flush'] = function flush() {
+        if (this.flushing) {
+            throwBindingError('Cannot flush a CommandBuffer from a call it is running');
+        }
+        if (this.cursor !== this.begin) {
+            // The records are executed in place, so nothing may be recorded
+            // into this buffer until they have all run.
+            this.flushing = true;
+            try {
+                batchedCallDispatcher(this.begin, this.cursor);
+            } finally {
+                this.flushing = false;
+                this.cursor = this.begin;
+            }
+        }
+        runDestructors(this.destructors);
+    };
+    CommandBuffer.prototype['delete'] = function() {
+        this['flush']();
+        _free(this.begin);
+        this.begin = this.end = this.cursor = 0;
+    };
+    CommandBuffer.prototype['getPendingBytes'] = function() {
+        return this.cursor - this.begin;
+    };
+    Module['CommandBuffer'] = CommandBuffer;
+  },
+
+  // Heap-resident buffer of recorded calls to functions registered with
+  // emscripten::batched_function.  Each batched function appears as a
+  // method of the same name that records the call; flush() (or running
+  // out of space) executes every recorded call with one call into C++.
+  $CommandBuffer__deps: ['$init_CommandBuffer', '$throwBindingError', 'malloc'],
+  $CommandBuffer__postset: 'init_CommandBuffer()',
+  $CommandBuffer: function(byteSize) {
+    if (byteSize === undefined) {
+        byteSize = 65536;
+    }
+    byteSize &= ~7;
+    if (byteSize < 16) {
+        throwBindingError('CommandBuffer must be at least 16 bytes');
+    }
+    this.begin = _malloc(byteSize); // malloc'ed memory is 8-byte aligned
+    this.end = this.begin + byteSize;
+    this.cursor = this.begin;
+    this.destructors = [];
+    this.flushing = false;
+  },
+
+  $makeBatchedCallRecorder__deps: ['$throwBindingError'],
+  $makeBatchedCallRecorder: function(humanName, argTypes, argumentLayout, rawInvoker, fn) {
+    // argTypes[0] is the (void) return type.
+    var argCount = argTypes.length - 1;
+    var recordSize = 8 * (argCount + 1);
+
+    var writers = new Array(argCount);
+    for (var i = 0; i < argCount; ++i) {
+        switch (argumentLayout[i]) {
+            case 'f':
+                writers[i] = function(ptr, wt) { HEAPF32[ptr >> 2] = wt; };
+                break;
+            case 'd':
+                writers[i] = function(ptr, wt) { HEAPF64[ptr >> 3] = wt; };
+                break;
+            default:
+                writers[i] = function(ptr, wt) { HEAP32[ptr >> 2] = wt; };
+        }
+    }
+
+    return function() {
+        if (arguments.length !== argCount) {
+            throwBindingError('function ' + humanName + ' called with ' + arguments.length + ' arguments, expected ' + argCount + ' args!');
+        }
+        if (this.flushing) {
+            throwBindingError('Cannot record ' + humanName + ' into a CommandBuffer while it is being flushed');
+        }
+        if (this.cursor + recordSize > this.end) {
+            if (recordSize > this.end - this.begin) {
+                throwBindingError('CommandBuffer is too small to record ' + humanName);
+            }
+            this['flush']();
+        }
+        var ptr = this.cursor;
+        HEAP32[ptr >> 2] = rawInvoker;
+        HEAP32[(ptr >> 2) + 1] = fn;
+        for (var i = 0; i < argCount; ++i) {
+            writers[i](ptr + 8 * (i + 1), argTypes[i + 1]['toWireType'](this.destructors, arguments[i]));
+        }
+        this.cursor = ptr + recordSize;
+    };
+  },
+
+  _embind_register_batched_function__deps: [
+    '$CommandBuffer', '$batchedCallDispatcher', '$heap32VectorToArray',
+    '$makeBatchedCallRecorder', '$readLatin1String', '$requireFunction',
+    '$throwBindingError', '$throwUnboundTypeError', '$whenDependentTypesAreResolved'],
+  _embind_register_batched_function: function(
+    name,
+    argCount,
+    rawArgTypesAddr,
+    argumentLayout,
+    rawInvoker,
+    fn,
+    dispatcherSignature,
+    rawDispatcher
+  ) {
+    var argTypes = heap32VectorToArray(argCount, rawArgTypesAddr);
+    name = readLatin1String(name);
+    // Skip the return type; the rest is one code per argument slot.
+    argumentLayout = readLatin1String(argumentLayout).slice(1);
+
+    if (!batchedCallDispatcher) {
+        batchedCallDispatcher = requireFunction(dispatcherSignature, rawDispatcher);
+    }
+
+    var proto = CommandBuffer.prototype;
+    if (proto.hasOwnProperty(name)) {
+        throwBindingError("Cannot register batched function '" + name + "' twice");
+    }
+    proto[name] = function() {
+        throwUnboundTypeError('Cannot record ' + name + ' due to unbound types', argTypes);
+    };
+
+    whenDependentTypesAreResolved([], argTypes, function(argTypes) {
+        proto[name] = makeBatchedCallRecorder(name, argTypes, argumentLayout, rawInvoker, fn);
+        return [];
+    });
+  },
+
+  // Heap accessors for members of trivially copyable value types, keyed by
+  // the layout code bind.h emits for each direct field (see DirectFieldLayout).
+  $getDirectFieldAccessors__deps: ['$throwInternalError'],
+  $getDirectFieldAccessors: function(layout, offset) {
+    switch (String.fromCharCode(layout)) {
+        case 'b': return {
+            size: 1,
+            read: function(ptr) { return HEAP8[ptr + offset]; },
+            write: function(ptr, v) { HEAP8[ptr + offset] = v; },
+        };
+        case 'B': return {
+            size: 1,
+            read: function(ptr) { return HEAPU8[ptr + offset]; },
+            write: function(ptr, v) { HEAPU8[ptr + offset] = v; },
+        };
+        case 'h': return {
+            size: 2,
+            read: function(ptr) { return HEAP16[(ptr + offset) >> 1]; },
+            write: function(ptr, v) { HEAP16[(ptr + offset) >> 1] = v; },
+        };
+        case 'H': return {
+            size: 2,
+            read: function(ptr) { return HEAPU16[(ptr + offset) >> 1]; },
+            write: function(ptr, v) { HEAPU16[(ptr + offset) >> 1] = v; },
+        };
+        case 'i': return {
+            size: 4,
+            read: function(ptr) { return HEAP32[(ptr + offset) >> 2]; },
+            write: function(ptr, v) { HEAP32[(ptr + offset) >> 2] = v; },
+        };
+        case 'I': return {
+            size: 4,
+            read: function(ptr) { return HEAPU32[(ptr + offset) >> 2]; },
+            write: function(ptr, v) { HEAPU32[(ptr + offset) >> 2] = v; },
+        };
+        case 'f': return {
+            size: 4,
+            read: function(ptr) { return HEAPF32[(ptr + offset) >> 2]; },
+            write: function(ptr, v) { HEAPF32[(ptr + offset) >> 2] = v; },
+        };
+        case 'd': return {
+            size: 8,
+            read: function(ptr) { return HEAPF64[(ptr + offset) >> 3]; },
+            write: function(ptr, v) { HEAPF64[(ptr + offset) >> 3] = v; },
+        };
+        default:
+            throwInternalError('Unknown direct field layout: ' + layout);
+    }
+  },
+
+  // Value types are passed over the wire as heap-allocated copies.  When every
+  // byte of a trivially copyable value type is covered by direct fields, its
+  // wire buffers are fully rewritten on each use and can be recycled instead
+  // of calling into operator new/delete for every conversion.
+  $makeValueTypeAllocator: function(rawConstructor, rawDestructor, recyclable) {
+    if (!recyclable) {
+        return {
+            allocate: rawConstructor,
+            release: rawDestructor,
+        };
+    }
+    var maxPooled = 16;
+    var pool = [];
+    return {
+        allocate: function() {
+            return pool.length ? pool.pop() : rawConstructor();
+        },
+        release: function(ptr) {
+            if (pool.length < maxPooled) {
+                pool.push(ptr);
+            } else {
+                rawDestructor(ptr);
+            }
+        },
+    };
+  },
+
   $tupleRegistrations: {},
 
   _embind_register_value_array__deps: [
@@ -1001,6 +1222,8 @@ var LibraryEmbind = {
         rawConstructor: requireFunction(constructorSignature, rawConstructor),
         rawDestructor: requireFunction(destructorSignature, rawDestructor),
         elements: [],
+        directBytes: 0,
+        size: 0,
     };
   },
 
@@ -1027,8 +1250,28 @@ var LibraryEmbind = {
     });
   },
 
+  _embind_register_value_array_direct_element__deps: [
+    '$tupleRegistrations', '$getDirectFieldAccessors'],
+  _embind_register_value_array_direct_element: function(
+    rawTupleType,
+    elementType,
+    elementLayout,
+    elementOffset,
+    tupleSize
+  ) {
+    var reg = tupleRegistrations[rawTupleType];
+    var direct = getDirectFieldAccessors(elementLayout, elementOffset);
+    reg.directBytes += direct.size;
+    reg.size = tupleSize;
+    reg.elements.push({
+        getterReturnType: elementType,
+        setterArgumentType: elementType,
+        direct: direct,
+    });
+  },
+
   _embind_finalize_value_array__deps: [
-    '$tupleRegistrations', '$runDestructors',
+    '$tupleRegistrations', '$runDestructors', '$makeValueTypeAllocator',
     '$simpleReadValueFromPointer', '$whenDependentTypesAreResolved'],
   _embind_finalize_value_array: function(rawTupleType) {
     var reg = tupleRegistrations[rawTupleType];
@@ -1038,15 +1281,28 @@ var LibraryEmbind = {
     var elementTypes = elements.map(function(elt) { return elt.getterReturnType; }).
                 concat(elements.map(function(elt) { return elt.setterArgumentType; }));
 
-    var rawConstructor = reg.rawConstructor;
-    var rawDestructor = reg.rawDestructor;
+    var allocator = makeValueTypeAllocator(
+        reg.rawConstructor, reg.rawDestructor,
+        elements.every(function(elt) { return elt.direct; }) && reg.directBytes === reg.size);
+    var allocate = allocator.allocate;
+    var release = allocator.release;
 
     whenDependentTypesAreResolved([rawTupleType], elementTypes, function(elementTypes) {
         elements.forEach(function(elt, i) {
             var getterReturnType = elementTypes[i];
+            var setterArgumentType = elementTypes[i + elementsLength];
+            var direct = elt.direct;
+            if (direct) {
+                elt.read = function(ptr) {
+                    return getterReturnType['fromWireType'](direct.read(ptr));
+                };
+                elt.write = function(ptr, o) {
+                    direct.write(ptr, setterArgumentType['toWireType'](null, o));
+                };
+                return;
+            }
             var getter = elt.getter;
             var getterContext = elt.getterContext;
-            var setterArgumentType = elementTypes[i + elementsLength];
             var setter = elt.setter;
             var setterContext = elt.setterContext;
             elt.read = function(ptr) {
@@ -1066,25 +1322,25 @@ var LibraryEmbind = {
                 for (var i = 0; i < elementsLength; ++i) {
                     rv[i] = elements[i].read(ptr);
                 }
-                rawDestructor(ptr);
+                release(ptr);
                 return rv;
             },
             'toWireType': function(destructors, o) {
                 if (elementsLength !== o.length) {
                     throw new TypeError("Incorrect number of tuple elements for " + reg.name + ": expected=" + elementsLength + ", actual=" + o.length);
                 }
-                var ptr = rawConstructor();
+                var ptr = allocate();
                 for (var i = 0; i < elementsLength; ++i) {
                     elements[i].write(ptr, o[i]);
                 }
                 if (destructors !== null) {
-                    destructors.push(rawDestructor, ptr);
+                    destructors.push(release, ptr);
                 }
                 return ptr;
             },
             'argPackAdvance': 8,
             'readValueFromPointer': simpleReadValueFromPointer,
-            destructorFunction: rawDestructor,
+            destructorFunction: release,
         }];
     });
   },
@@ -1106,6 +1362,8 @@ var LibraryEmbind = {
         rawConstructor: requireFunction(constructorSignature, rawConstructor),
         rawDestructor: requireFunction(destructorSignature, rawDestructor),
         fields: [],
+        directBytes: 0,
+        size: 0,
     };
   },
 
@@ -1134,26 +1392,65 @@ var LibraryEmbind = {
     });
   },
 
+  _embind_register_value_object_direct_field__deps: [
+    '$structRegistrations', '$readLatin1String', '$getDirectFieldAccessors'],
+  _embind_register_value_object_direct_field: function(
+    structType,
+    fieldName,
+    fieldType,
+    fieldLayout,
+    fieldOffset,
+    structSize
+  ) {
+    var reg = structRegistrations[structType];
+    var direct = getDirectFieldAccessors(fieldLayout, fieldOffset);
+    reg.directBytes += direct.size;
+    reg.size = structSize;
+    reg.fields.push({
+        fieldName: readLatin1String(fieldName),
+        getterReturnType: fieldType,
+        setterArgumentType: fieldType,
+        direct: direct,
+    });
+  },
+
   _embind_finalize_value_object__deps: [
-    '$structRegistrations', '$runDestructors',
+    '$structRegistrations', '$runDestructors', '$makeValueTypeAllocator',
     '$simpleReadValueFromPointer', '$whenDependentTypesAreResolved'],
   _embind_finalize_value_object: function(structType) {
     var reg = structRegistrations[structType];
     delete structRegistrations[structType];
 
-    var rawConstructor = reg.rawConstructor;
-    var rawDestructor = reg.rawDestructor;
     var fieldRecords = reg.fields;
     var fieldTypes = fieldRecords.map(function(field) { return field.getterReturnType; }).
               concat(fieldRecords.map(function(field) { return field.setterArgumentType; }));
+
+    var allocator = makeValueTypeAllocator(
+        reg.rawConstructor, reg.rawDestructor,
+        fieldRecords.every(function(field) { return field.direct; }) && reg.directBytes === reg.size);
+    var allocate = allocator.allocate;
+    var release = allocator.release;
+
     whenDependentTypesAreResolved([structType], fieldTypes, function(fieldTypes) {
         var fields = {};
         fieldRecords.forEach(function(field, i) {
             var fieldName = field.fieldName;
             var getterReturnType = fieldTypes[i];
+            var setterArgumentType = fieldTypes[i + fieldRecords.length];
+            var direct = field.direct;
+            if (direct) {
+                fields[fieldName] = {
+                    read: function(ptr) {
+                        return getterReturnType['fromWireType'](direct.read(ptr));
+                    },
+                    write: function(ptr, o) {
+                        direct.write(ptr, setterArgumentType['toWireType'](null, o));
+                    }
+                };
+                return;
+            }
             var getter = field.getter;
             var getterContext = field.getterContext;
-            var setterArgumentType = fieldTypes[i + fieldRecords.length];
             var setter = field.setter;
             var setterContext = field.setterContext;
             fields[fieldName] = {
@@ -1176,7 +1473,7 @@ var LibraryEmbind = {
                 for (var i in fields) {
                     rv[i] = fields[i].read(ptr);
                 }
-                rawDestructor(ptr);
+                release(ptr);
                 return rv;
             },
             'toWireType': function(destructors, o) {
@@ -1187,18 +1484,18 @@ var LibraryEmbind = {
                         throw new TypeError('Missing field');
                     }
                 }
-                var ptr = rawConstructor();
+                var ptr = allocate();
                 for (fieldName in fields) {
                     fields[fieldName].write(ptr, o[fieldName]);
                 }
                 if (destructors !== null) {
-                    destructors.push(rawDestructor, ptr);
+                    destructors.push(release, ptr);
                 }
                 return ptr;
             },
             'argPackAdvance': 8,
             'readValueFromPointer': simpleReadValueFromPointer,
-            destructorFunction: rawDestructor,
+            destructorFunction: release,
         }];
     });
   },
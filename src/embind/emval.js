@@ -9,7 +9,7 @@
 // -- jshint doesn't understand library syntax, so we need to mark the symbols exposed here
 /*global getStringOrSymbol, emval_handle_array, __emval_register, __emval_unregister, requireHandle, count_emval_handles, emval_symbols, emval_free_list, get_first_emval, __emval_decref, emval_newers*/
 /*global craftEmvalAllocator, __emval_addMethodCaller, emval_methodCallers, LibraryManager, mergeInto, __emval_allocateDestructors, global, __emval_lookupTypes, makeLegalFunctionName*/
-/*global emval_get_global*/
+/*global emval_get_global, emval_lookupDispatchedMethod*/
 
 var LibraryEmVal = {
   $emval_handle_array: [{},
@@ -303,9 +303,11 @@ var LibraryEmVal = {
         args.push(types[1 + i]);
     }
 
+    // Callers receive the method itself so that they serve both named
+    // lookups and functions cached in dispatch tables.
     var functionName = makeLegalFunctionName("methodCaller_" + signatureName);
     var functionBody =
-        "return function " + functionName + "(handle, name, destructors, args) {\n";
+        "return function " + functionName + "(handle, method, destructors, args) {\n";
 
     var offset = 0;
     for (var i = 0; i < argCount - 1; ++i) {
@@ -314,7 +316,7 @@ var LibraryEmVal = {
         offset += types[i + 1]['argPackAdvance'];
     }
     functionBody +=
-        "    var rv = handle[name](" + argsList + ");\n";
+        "    var rv = method.call(handle" + (argsList ? ", " + argsList : "") + ");\n";
     for (var i = 0; i < argCount - 1; ++i) {
         if (types[i + 1]['deleteObject']) {
             functionBody +=
@@ -338,7 +340,7 @@ var LibraryEmVal = {
     caller = emval_methodCallers[caller];
     handle = requireHandle(handle);
     methodName = getStringOrSymbol(methodName);
-    return caller(handle, methodName, __emval_allocateDestructors(destructorsRef), args);
+    return caller(handle, handle[methodName], __emval_allocateDestructors(destructorsRef), args);
   },
 
   _emval_call_void_method__deps: ['_emval_allocateDestructors', '$getStringOrSymbol', '$emval_methodCallers', '$requireHandle'],
@@ -346,7 +348,62 @@ var LibraryEmVal = {
     caller = emval_methodCallers[caller];
     handle = requireHandle(handle);
     methodName = getStringOrSymbol(methodName);
-    caller(handle, methodName, null, args);
+    caller(handle, handle[methodName], null, args);
+  },
+
+  _emval_create_dispatch_table__deps: ['_emval_register', '$requireHandle'],
+  _emval_create_dispatch_table: function(handle) {
+    return __emval_register({
+        target: requireHandle(handle),
+        methods: {}, // method name address -> {name, isSymbol, method}
+    });
+  },
+
+  // Method names are usually string literals or registered symbols, so the
+  // function found for an address is cached.  Names in other memory may
+  // change under the same address; those are compared before reuse.
+  $emval_lookupDispatchedMethod__deps: ['$emval_symbols', '$readLatin1String'],
+  $emval_lookupDispatchedMethod: function(table, address) {
+    var entry = table.methods[address];
+    var name;
+    if (entry !== undefined) {
+        if (entry.isSymbol) {
+            return entry.method;
+        }
+        name = entry.name;
+        var length = name.length;
+        var i = 0;
+        while (i < length && HEAPU8[address + i] === name.charCodeAt(i)) {
+            ++i;
+        }
+        if (i === length && HEAPU8[address + length] === 0) {
+            return entry.method;
+        }
+    }
+
+    var symbol = emval_symbols[address];
+    name = (symbol === undefined) ? readLatin1String(address) : symbol;
+    entry = {
+        name: name,
+        isSymbol: symbol !== undefined,
+        method: table.target[name],
+    };
+    table.methods[address] = entry;
+    return entry.method;
+  },
+
+  _emval_dispatch_method__deps: ['_emval_allocateDestructors', '$emval_lookupDispatchedMethod', '$emval_methodCallers', '$requireHandle'],
+  _emval_dispatch_method: function(caller, table, methodName, destructorsRef, args) {
+    caller = emval_methodCallers[caller];
+    table = requireHandle(table);
+    return caller(table.target, emval_lookupDispatchedMethod(table, methodName), __emval_allocateDestructors(destructorsRef), args);
+  },
+
+  _emval_dispatch_void_method__deps: ['$emval_lookupDispatchedMethod', '$emval_methodCallers', '$requireHandle'],
+  _emval_dispatch_void_method: function(caller, table, methodName, args) {
+    caller = emval_methodCallers[caller];
+    table = requireHandle(table);
+    caller(table.target, emval_lookupDispatchedMethod(table, methodName), null, args);
   },
 
   _emval_typeof__deps: ['_emval_register', '$requireHandle'],
@@ -423,6 +423,10 @@ function headlessCanvas() {
             BROWSER_DEFAULT_WEBGL          : 0x9244,
 
             items: {},
+            calls: {}, // Number of calls to the state changing functions, so that tests can check what reached the context.
+            countCall: function(name) {
+              this.calls[name] = (this.calls[name] || 0) + 1;
+            },
             id: 0,
             getExtension: function() { return 1 },
             createBuffer: function() {
@@ -433,7 +437,7 @@ function headlessCanvas() {
               return id;
             },
             deleteBuffer: function(){},
-            bindBuffer: function(){},
+            bindBuffer: function() { this.countCall('bindBuffer') },
             bufferData: function(){},
             getParameter: function(pname) {
               switch(pname) {
@@ -498,8 +502,8 @@ function headlessCanvas() {
             clearColor: function(){},
             clearDepth: function(){},
             depthFunc: function(){},
-            enable: function(){},
-            disable: function(){},
+            enable: function() { this.countCall('enable') },
+            disable: function() { this.countCall('disable') },
             frontFace: function(){},
             cullFace: function(){},
             activeTexture: function(){},
@@ -519,7 +523,7 @@ function headlessCanvas() {
             pixelStorei: function(){},
             texImage2D: function(){},
             compressedTexImage2D: function(){},
-            useProgram: function(){},
+            useProgram: function() { this.countCall('useProgram') },
             getUniformLocation: function() {
               return null;
             },
@@ -531,8 +535,25 @@ function headlessCanvas() {
               };
             },
             clear: function(){},
-            uniform4fv: function(){},
-            uniform1i: function(){},
+            uniform1f: function() { this.countCall('uniform') },
+            uniform2f: function() { this.countCall('uniform') },
+            uniform3f: function() { this.countCall('uniform') },
+            uniform4f: function() { this.countCall('uniform') },
+            uniform1i: function() { this.countCall('uniform') },
+            uniform2i: function() { this.countCall('uniform') },
+            uniform3i: function() { this.countCall('uniform') },
+            uniform4i: function() { this.countCall('uniform') },
+            uniform1fv: function() { this.countCall('uniform') },
+            uniform2fv: function() { this.countCall('uniform') },
+            uniform3fv: function() { this.countCall('uniform') },
+            uniform4fv: function() { this.countCall('uniform') },
+            uniform1iv: function() { this.countCall('uniform') },
+            uniform2iv: function() { this.countCall('uniform') },
+            uniform3iv: function() { this.countCall('uniform') },
+            uniform4iv: function() { this.countCall('uniform') },
+            uniformMatrix2fv: function() { this.countCall('uniform') },
+            uniformMatrix3fv: function() { this.countCall('uniform') },
+            uniformMatrix4fv: function() { this.countCall('uniform') },
             getAttribLocation: function() { return 1 },
             vertexAttribPointer: function(){},
             enableVertexAttribArray: function(){},
@@ -570,6 +570,30 @@ LibraryManager.library = {
     }
     {{{ makeSetValue('envPtr', 'strings.length * ptrSize', '0', 'i8*') }}};
   },
+  // Decodes a line of stdout or stderr output, a Uint8Array or an array of bytes, for printing. Uses TextDecoder when
+  // available, which is much faster for long lines, but only for valid UTF-8: invalid sequences are decoded by
+  // UTF8ArrayToString as usual, rather than turned into U+FFFD, so lines print the same either way.
+  $UTF8LineToString: function(bytes) {
+    if (UTF8LineToString.decoder === undefined) {
+      UTF8LineToString.decoder = typeof TextDecoder !== 'undefined' ? new TextDecoder('utf8', { fatal: true, ignoreBOM: true }) : null;
+    }
+    var decoder = UTF8LineToString.decoder;
+    if (!decoder) return UTF8ArrayToString(bytes, 0);
+    if (!bytes.subarray) {
+      bytes = new Uint8Array(bytes);
+    }
+#if USE_PTHREADS
+    else if (typeof SharedArrayBuffer !== 'undefined' && bytes.buffer instanceof SharedArrayBuffer) {
+      bytes = bytes.slice(0); // TextDecoder cannot decode views of shared memory
+    }
+#endif
+    try {
+      return decoder.decode(bytes);
+    } catch (e) {
+      return UTF8ArrayToString(bytes, 0);
+    }
+  },
+
   $ENV__deps: ['__buildEnvironment'],
 #if USE_PTHREADS
   $ENV__postset: 'if (!ENVIRONMENT_IS_PTHREAD) ___buildEnvironment(ENV);',
@@ -990,7 +990,7 @@ mergeInto(LibraryManager.library, {
     FS.createPreloadedFile(
       PATH.dirname(_file),
       PATH.basename(_file),
-      new Uint8Array(data.object.contents), true, true,
+      new Uint8Array(MEMFS.getFileDataAsTypedArray(data.object)), true, true,
       function() {
         if (onload) Runtime.dynCall('vi', onload, [file]);
       },
@@ -1156,6 +1156,12 @@ mergeInto(LibraryManager.library, {
 #if USES_GL_EMULATION
       GL.newRenderingFrameStarted();
 #endif
+#if GL_STATE_CACHE
+      if (typeof GL === 'object') GL.stateCacheFrameStarted();
+#endif
+#if GL_PROFILE
+      if (typeof GL === 'object') GL.profileEndFrame();
+#endif
 
       if (Browser.mainLoop.method === 'timeout' && Module.ctx) {
         Module.printErr('Looks like you are rendering without using requestAnimationFrame for the main loop. You should use 0 for the frame rate in emscripten_set_main_loop in order to use requestAnimationFrame, as that can greatly improve your frame rates!');
@@ -12,7 +12,11 @@ mergeInto(LibraryManager.library, {
     devices: [null],
     streams: [],
     nextInode: 1,
-    nameTable: null,
+    // Recently resolved paths, see lookupPath. Cleared whenever a node is removed or renamed, or anything else
+    // happens that could make a path resolve differently.
+    pathCache: [],
+    pathCacheSize: 0,
+    pathCacheLimit: 4096,
     currentPath: '/',
     initialized: false,
     // Whether we are currently ignoring permissions. Useful when preparing the
@@ -59,6 +63,15 @@ mergeInto(LibraryManager.library, {
         throw new FS.ErrnoError(ERRNO_CODES.ELOOP);
       }
 
+      // paths are cached separately for each combination of options. permission checks are skipped for cached
+      // paths, so whether they are being ignored is part of that.
+      var cacheKind = (opts.parent ? 1 : 0) | (opts.follow ? 2 : 0) | (opts.follow_mount ? 4 : 0) | (FS.ignorePermissions ? 8 : 0);
+      var cache = FS.pathCache[cacheKind];
+      var cached = cache && cache[path];
+      if (cached) {
+        return { path: cached.path, node: cached.node };
+      }
+
       // split the path
       var parts = PATH.normalizeArray(path.split('/').filter(function(p) {
         return !!p;
@@ -103,8 +116,22 @@ mergeInto(LibraryManager.library, {
         }
       }
 
+      if (FS.pathCacheSize >= FS.pathCacheLimit) {
+        FS.invalidatePathCache();
+      }
+      cache = FS.pathCache[cacheKind];
+      if (!cache) cache = FS.pathCache[cacheKind] = {};
+      cache[path] = { path: current_path, node: current };
+      FS.pathCacheSize++;
+
       return { path: current_path, node: current };
     },
+    invalidatePathCache: function() {
+      if (FS.pathCacheSize) {
+        FS.pathCache = [];
+        FS.pathCacheSize = 0;
+      }
+    },
     getPath: function(node) {
       var path;
       while (true) {
@@ -121,55 +148,37 @@ mergeInto(LibraryManager.library, {
     //
     // nodes
     //
-    hashName: function(parentid, name) {
-      var hash = 0;
-
+    // Each directory node indexes the nodes that were created in it by name, in name_index. The key is prefixed so
+    // that names like __proto__ can't clash with the properties of a plain object.
+    hashKey: function(name) {
 #if CASE_INSENSITIVE_FS
       name = name.toLowerCase();
 #endif
-
-      for (var i = 0; i < name.length; i++) {
-        hash = ((hash << 5) - hash + name.charCodeAt(i)) | 0;
-      }
-      return ((parentid + hash) >>> 0) % FS.nameTable.length;
+      return '$' + name;
     },
     hashAddNode: function(node) {
-      var hash = FS.hashName(node.parent.id, node.name);
-      node.name_next = FS.nameTable[hash];
-      FS.nameTable[hash] = node;
+      var parent = node.parent;
+      if (!parent.name_index) parent.name_index = {};
+      parent.name_index[FS.hashKey(node.name)] = node;
     },
     hashRemoveNode: function(node) {
-      var hash = FS.hashName(node.parent.id, node.name);
-      if (FS.nameTable[hash] === node) {
-        FS.nameTable[hash] = node.name_next;
-      } else {
-        var current = FS.nameTable[hash];
-        while (current) {
-          if (current.name_next === node) {
-            current.name_next = node.name_next;
-            break;
-          }
-          current = current.name_next;
-        }
+      var index = node.parent.name_index;
+      var key = FS.hashKey(node.name);
+      // a node that was replaced by a rename is no longer indexed, leave its replacement alone
+      if (index && index[key] === node) {
+        delete index[key];
       }
+      FS.invalidatePathCache();
     },
     lookupNode: function(parent, name) {
       var err = FS.mayLookup(parent);
       if (err) {
         throw new FS.ErrnoError(err, parent);
       }
-      var hash = FS.hashName(parent.id, name);
-#if CASE_INSENSITIVE_FS
-      name = name.toLowerCase();
-#endif
-      for (var node = FS.nameTable[hash]; node; node = node.name_next) {
-        var nodeName = node.name;
-#if CASE_INSENSITIVE_FS
-        nodeName = nodeName.toLowerCase();
-#endif
-        if (node.parent.id === parent.id && nodeName === name) {
-          return node;
-        }
+      var index = parent.name_index;
+      var node = index && index[FS.hashKey(name)];
+      if (node && node !== parent) {
+        return node;
       }
       // if we failed to find it in the cache, call into the VFS
       return FS.lookup(parent, name);
@@ -539,6 +548,7 @@ mergeInto(LibraryManager.library, {
       } else if (node) {
         // set as a mountpoint
         node.mounted = mount;
+        FS.invalidatePathCache();
 
         // add the new mount to the current mount's children
         if (node.mount) {
@@ -560,22 +570,24 @@ mergeInto(LibraryManager.library, {
       var mount = node.mounted;
       var mounts = FS.getMounts(mount);
 
-      Object.keys(FS.nameTable).forEach(function (hash) {
-        var current = FS.nameTable[hash];
-
-        while (current) {
-          var next = current.name_next;
-
-          if (mounts.indexOf(current.mount) !== -1) {
-            FS.destroyNode(current);
-          }
-
-          current = next;
-        }
+      function destroyTree(dir) {
+        var index = dir.name_index;
+        if (!index) return;
+        Object.keys(index).forEach(function(key) {
+          var current = index[key];
+          if (current === dir) return; // a mount root is its own parent
+          destroyTree(current);
+          FS.destroyNode(current);
+        });
+      }
+      mounts.forEach(function(m) {
+        destroyTree(m.root);
+        FS.destroyNode(m.root);
       });
 
       // no longer a mountpoint
       node.mounted = null;
+      FS.invalidatePathCache();
 
       // remove this mount from the child mounts
       var idx = node.mount.mounts.indexOf(mount);
@@ -847,6 +859,10 @@ mergeInto(LibraryManager.library, {
         mode: (mode & {{{ cDefine('S_IALLUGO') }}}) | (node.mode & ~{{{ cDefine('S_IALLUGO') }}}),
         timestamp: Date.now()
       });
+      if (FS.isDir(node.mode)) {
+        // cached paths through this directory skipped its search permission check
+        FS.invalidatePathCache();
+      }
     },
     lchmod: function(path, mode) {
       FS.chmod(path, mode, true);
@@ -1341,8 +1357,6 @@ mergeInto(LibraryManager.library, {
     staticInit: function() {
       FS.ensureErrnoError();
 
-      FS.nameTable = new Array(4096);
-
       FS.mount(MEMFS, {}, '/');
 
       FS.createDefaultDirectories();
@@ -1545,9 +1559,10 @@ mergeInto(LibraryManager.library, {
       return FS.symlink(target, path);
     },
     // Makes sure a file's contents are loaded. Returns whether the file has
-    // been loaded successfully. No-op for files that have been loaded already.
+    // been loaded successfully. No-op for files that have been loaded already,
+    // including MEMFS files whose data is in pages (see MEMFS_PAGE_SIZE).
     forceLoadFile: function(obj) {
-      if (obj.isDevice || obj.isFolder || obj.link || obj.contents) return true;
+      if (obj.isDevice || obj.isFolder || obj.link || obj.contents || obj.pages) return true;
       var success = true;
       if (typeof XMLHttpRequest !== 'undefined') {
         throw new Error("Lazy loading should have been performed (contents set) in createLazyFile, but it was not. Lazy loading only works in web workers. Use --embed-file or --preload-file in emcc on the main thread.");
@@ -1806,7 +1821,7 @@ mergeInto(LibraryManager.library, {
           if (fail == 0) onload(); else onerror();
         }
         paths.forEach(function(path) {
-          var putRequest = files.put(FS.analyzePath(path).object.contents, path);
+          var putRequest = files.put(MEMFS.getFileDataAsTypedArray(FS.analyzePath(path).object), path);
           putRequest.onsuccess = function putRequest_onsuccess() { ok++; if (ok + fail == total) finish() };
           putRequest.onerror = function putRequest_onerror() { fail++; if (ok + fail == total) finish() };
         });
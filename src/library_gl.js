@@ -5,6 +5,9 @@
 
 var LibraryGL = {
   $GL__postset: 'var GLctx; GL.init()',
+#if GL_PROFILE
+  $GL__deps: ['emscripten_get_now'],
+#endif
   $GL: {
 #if GL_DEBUG
     debug: true,
@@ -224,6 +227,163 @@ var LibraryGL = {
       for(var i = 0; i <= largestIndex; ++i) {
         GL.currentContext.tempVertexBufferCounters1[i] = 0;
       }
+#if FULL_ES2
+      if (GL.currentContext.streamingVertexBufferOffset) GL.currentContext.streamingVertexBufferOrphan = true;
+#endif
+    },
+#endif
+
+#if GL_STATE_CACHE
+    // The state cache keeps a shadow copy of the GL state that applications change most often, so that calls that
+    // would set the state to the value it already has can return early instead of going through WebGL validation.
+    // Each context has its own cache. Only the GL functions of this library update it, so JS code that changes the
+    // same state through GLctx directly must invalidate it afterwards.
+    initStateCache: function(context) {
+      context.stateCache = {
+        issued: 0, // State changing calls forwarded to WebGL during this frame.
+        filtered: 0, // State changing calls skipped during this frame.
+        issuedLastFrame: 0,
+        filteredLastFrame: 0,
+        totalIssued: 0, // Sums of the counters of all finished frames.
+        totalFiltered: 0
+      };
+      GL.invalidateStateCache(context);
+    },
+
+    invalidateStateCache: function(context) {
+      var cache = context.stateCache;
+      cache.caps = {}; // Maps a capability enum to whether it is enabled, undefined if not known.
+      cache.buffers = {}; // Maps a buffer binding target enum to the id of the bound buffer, undefined if not known.
+      cache.program = -1; // Id of the program in use, -1 if not known.
+      cache.uniforms = []; // Maps a uniform location id to an array of the values last set to it.
+    },
+
+    // Called at the start of each main loop iteration, rolls the per frame counters of all contexts.
+    stateCacheFrameStarted: function() {
+      for (var i = 0; i < GL.contexts.length; ++i) {
+        if (!GL.contexts[i]) continue;
+        var cache = GL.contexts[i].stateCache;
+        cache.totalIssued += cache.issued;
+        cache.totalFiltered += cache.filtered;
+        cache.issuedLastFrame = cache.issued;
+        cache.filteredLastFrame = cache.filtered;
+        cache.issued = cache.filtered = 0;
+      }
+    },
+
+    // Returns true if the uniform at the given location already has the given values, otherwise records them.
+    // Components that the uniform type does not have are passed in as undefined. The type is 'i' or 'f' for the
+    // integer and float functions; a value set through one does not match the same numbers set through the other,
+    // so that calls with the wrong type for the uniform always reach WebGL and raise its error.
+    stateCacheUniform: function(location, type, v0, v1, v2, v3) {
+      var cache = GL.currentContext.stateCache;
+      var u = cache.uniforms[location];
+      if (u && u.type === type && u[0] === v0 && u[1] === v1 && u[2] === v2 && u[3] === v3) {
+        ++cache.filtered;
+        return true;
+      }
+      if (!u) u = cache.uniforms[location] = [];
+      u.type = type;
+      u[0] = v0; u[1] = v1; u[2] = v2; u[3] = v3;
+      ++cache.issued;
+      return false;
+    },
+
+    // As above, for the glUniform*v functions, which set count uniforms of size components each from heap[index].
+    // The matrix functions pass 'm', or 'mt' when transposing, so that a transposed matrix never matches one that is
+    // not. Setting more than one element of a uniform array is always forwarded, and forgets the cached values of the
+    // elements it overwrites, since each array element has a location id of its own.
+    stateCacheUniformv: function(location, type, count, size, heap, index) {
+      var cache = GL.currentContext.stateCache;
+      if (count != 1) {
+        for (var i = 0; i < count; ++i) cache.uniforms[location + i] = null;
+        ++cache.issued;
+        return false;
+      }
+      var u = cache.uniforms[location];
+      var i = 0;
+      if (u && u.type === type && u.length == size) {
+        while (i < size && u[i] === heap[index + i]) ++i;
+        if (i == size) {
+          ++cache.filtered;
+          return true;
+        }
+      } else {
+        u = cache.uniforms[location] = new Array(size);
+        u.type = type;
+      }
+      for (; i < size; ++i) u[i] = heap[index + i];
+      ++cache.issued;
+      return false;
+    },
+#endif
+
+#if GL_PROFILE
+    // With GL_PROFILE, each GL function is wrapped to count its calls and time (see the end of this file). The
+    // statistics are kept in the heap, in one emscripten_gl_profile_entry per GL function.
+    profileNames: [], // Names of the profiled functions, indexed by profile id. Filled in at compile time.
+    profileTable: 0, // Entries of the frame in progress.
+    profileLastFrame: 0, // Entries of the last finished frame.
+    profileCurrent: -1, // Profile id of the innermost GL function being executed, which uploads are attributed to.
+
+    initProfile: function() {
+      var size = GL.profileNames.length * {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}};
+      GL.profileTable = allocate(size, 'i8', ALLOC_NORMAL);
+      GL.profileLastFrame = allocate(size, 'i8', ALLOC_NORMAL);
+      for (var i = 0; i < GL.profileNames.length; ++i) {
+        var name = allocate(intArrayFromString(GL.profileNames[i]), 'i8', ALLOC_NORMAL);
+        {{{ makeSetValue('GL.profileTable', 'i*' + C_STRUCTS.emscripten_gl_profile_entry.__size__ + '+' + C_STRUCTS.emscripten_gl_profile_entry.name, 'name', 'i8*') }}};
+        {{{ makeSetValue('GL.profileLastFrame', 'i*' + C_STRUCTS.emscripten_gl_profile_entry.__size__ + '+' + C_STRUCTS.emscripten_gl_profile_entry.name, 'name', 'i8*') }}};
+      }
+    },
+
+    // Called on entry to the GL function with the given profile id. Returns the start time of the call.
+    profileEnter: function(id) {
+      if (!GL.profileTable) GL.initProfile();
+      GL.profileCurrent = id;
+      return _emscripten_get_now();
+    },
+
+    // Called when the GL function with the given profile id returns, prev is the id of the function it was called from.
+    profileExit: function(id, prev, start) {
+      var msecs = _emscripten_get_now() - start;
+      GL.profileCurrent = prev;
+      var entry = GL.profileTable + id * {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}};
+      var calls = {{{ makeGetValue('entry', C_STRUCTS.emscripten_gl_profile_entry.calls, 'i32') }}};
+      {{{ makeSetValue('entry', C_STRUCTS.emscripten_gl_profile_entry.calls, 'calls + 1', 'i32') }}};
+      var total = {{{ makeGetValue('entry', C_STRUCTS.emscripten_gl_profile_entry.msecs, 'double') }}};
+      {{{ makeSetValue('entry', C_STRUCTS.emscripten_gl_profile_entry.msecs, 'total + msecs', 'double') }}};
+      var bucket = 0;
+      for (var limit = 0.001; bucket < {{{ cDefine('EMSCRIPTEN_GL_PROFILE_HISTOGRAM_BUCKETS') }}} - 1 && msecs >= limit; limit *= 4) ++bucket;
+      var slot = entry + {{{ C_STRUCTS.emscripten_gl_profile_entry.histogram }}} + bucket * 4;
+      var count = {{{ makeGetValue('slot', 0, 'i32') }}};
+      {{{ makeSetValue('slot', 0, 'count + 1', 'i32') }}};
+    },
+
+    // Attributes the given number of bytes sent to the GPU to the GL function being executed.
+    profileUpload: function(bytes) {
+      if (GL.profileCurrent < 0) return;
+      var entry = GL.profileTable + GL.profileCurrent * {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}};
+      var total = {{{ makeGetValue('entry', C_STRUCTS.emscripten_gl_profile_entry.bytesUploaded, 'double') }}};
+      {{{ makeSetValue('entry', C_STRUCTS.emscripten_gl_profile_entry.bytesUploaded, 'total + bytes', 'double') }}};
+    },
+
+    // Moves the statistics of the frame in progress to the last frame, and starts a new one.
+    profileEndFrame: function() {
+      if (!GL.profileTable) return;
+      var size = GL.profileNames.length * {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}};
+      HEAPU8.set(HEAPU8.subarray(GL.profileTable, GL.profileTable + size), GL.profileLastFrame);
+      GL.profileClear(GL.profileTable);
+    },
+
+    profileClear: function(table) {
+      for (var i = 0; i < GL.profileNames.length; ++i) {
+        var entry = table + i * {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}};
+        // Everything after the name is zeroed.
+        for (var p = entry + {{{ C_STRUCTS.emscripten_gl_profile_entry.calls }}}; p < entry + {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}}; p += 4) {
+          {{{ makeSetValue('p', 0, 0, 'i32') }}};
+        }
+      }
     },
 #endif
 
@@ -319,29 +479,154 @@ var LibraryGL = {
       return size * typeSize * count;
     },
 
-    usedTempBuffers: [],
+    // Client side vertex arrays are streamed to the GPU through a single large buffer per context. Each draw call
+    // suballocates space for the client memory it reads from the end of the previously used space, and the buffer
+    // is orphaned with bufferData() at the start of each frame and whenever it fills up, so that new uploads never
+    // have to wait for the GPU to finish with data that earlier draw calls are still using.
+    // The ranges of client memory that the enabled attributes read are merged first, so that interleaved
+    // attributes are uploaded once, and all ranges of a draw call go to the GPU with a single bufferSubData().
+    // A CPU side mirror of the buffer contents lets a draw call reuse the data uploaded for the previous draw call
+    // if it reads the same, unmodified memory, which is common when a vertex array is drawn in several pieces, so
+    // that only the vertices that the previous draw call did not read need to be uploaded.
+    clientAttribs: [], // Indices of the client side attributes of the current draw call, sorted by address.
+
+    growStreamingVertexBuffer: function growStreamingVertexBuffer(context, minSize) {
+      var size = Math.max(context.streamingVertexBufferSize, GL.MAX_TEMP_BUFFER_SIZE);
+      while (size < minSize) size <<= 1;
+      if (!context.streamingVertexBuffer) context.streamingVertexBuffer = GLctx.createBuffer();
+      context.streamingVertexBufferSize = size;
+      context.streamingVertexBufferMirror = new Int32Array(size >> 2);
+    },
 
-    preDrawHandleClientVertexAttribBindings: function preDrawHandleClientVertexAttribBindings(count) {
-      GL.resetBufferBinding = false;
+    // Gives the streaming vertex buffer fresh storage. The GPU keeps the old storage alive for as long as draw calls
+    // issued earlier need it.
+    orphanStreamingVertexBuffer: function orphanStreamingVertexBuffer(context) {
+      GLctx.bindBuffer(GLctx.ARRAY_BUFFER, context.streamingVertexBuffer);
+      GLctx.bufferData(GLctx.ARRAY_BUFFER, context.streamingVertexBufferSize, GLctx.STREAM_DRAW);
+      context.streamingVertexBufferOffset = 0;
+      context.streamingVertexBufferOrphan = false;
+      context.numPrevStreamingRanges = 0;
+    },
+
+    // Checks whether the previous draw call uploaded the given range of client memory, and the memory has not been
+    // modified since. If so, points range.offset at the data in the streaming vertex buffer. The data can also cover
+    // just the beginning of the range, if it is the last data in the buffer, in which case the rest can be appended
+    // to it. Sets range.uploadFrom to the address from which on the range still needs to be uploaded.
+    findStreamedRange: function findStreamedRange(context, range) {
+      var prevRanges = context.prevStreamingRanges;
+      range.offset = -1;
+      range.uploadFrom = range.start;
+      for (var i = 0; i < context.numPrevStreamingRanges; ++i) {
+        var prev = prevRanges[i];
+        if (prev.start > range.start || prev.end <= range.start) continue;
+        var end = Math.min(prev.end, range.end);
+        if (end < range.end && prev.offset + prev.end - prev.start != context.streamingVertexBufferOffset) return;
+        var offset = prev.offset + range.start - prev.start;
+        var mirror = context.streamingVertexBufferMirror;
+        var m = offset >> 2, h = range.start >> 2, hEnd = end >> 2;
+        while (h < hEnd && mirror[m] === HEAP32[h]) { ++m; ++h; }
+        if (h == hEnd) {
+          range.offset = offset;
+          range.uploadFrom = end;
+        }
+        return;
+      }
+    },
 
-      // TODO: initial pass to detect ranges we need to upload, might not need an upload per attrib
-      for (var i = 0; i < GL.currentContext.maxVertexAttribs; ++i) {
-        var cb = GL.currentContext.clientBuffers[i];
+    preDrawHandleClientVertexAttribBindings: function preDrawHandleClientVertexAttribBindings(count) {
+      var context = GL.currentContext;
+      var clientBuffers = context.clientBuffers;
+      var attribs = GL.clientAttribs;
+      attribs.length = 0;
+      for (var i = 0; i < context.maxVertexAttribs; ++i) {
+        var cb = clientBuffers[i];
         if (!cb.clientside || !cb.enabled) continue;
+        // Work in whole 32-bit words, so that the data keeps its alignment in the buffer.
+        cb.start = cb.ptr & ~3;
+        cb.end = Math.min((cb.ptr + GL.calcBufLength(cb.size, cb.type, cb.stride, count) + 3) & ~3, HEAPU8.length);
+        attribs.push(i);
+      }
+      GL.resetBufferBinding = attribs.length > 0;
+      if (!attribs.length) return;
+
+      // Merge the memory ranges of the attributes that overlap.
+      attribs.sort(function(a, b) { return clientBuffers[a].start - clientBuffers[b].start; });
+      var ranges = context.streamingRanges;
+      var numRanges = 0;
+      var range = null;
+      for (var i = 0; i < attribs.length; ++i) {
+        var cb = clientBuffers[attribs[i]];
+        if (range && cb.start <= range.end) {
+          range.end = Math.max(range.end, cb.end);
+        } else {
+          range = ranges[numRanges] || (ranges[numRanges] = {});
+          ++numRanges;
+          range.start = cb.start;
+          range.end = cb.end;
+        }
+        cb.range = range;
+      }
 
-        GL.resetBufferBinding = true;
+      // Look for ranges that are already in the buffer, and count the space that the rest need.
+      if (context.streamingVertexBufferOrphan) GL.orphanStreamingVertexBuffer(context);
+      var uploadSize = 0;
+      var totalSize = 0;
+      var extendedRange = null;
+      for (var i = 0; i < numRanges; ++i) {
+        range = ranges[i];
+        GL.findStreamedRange(context, range);
+        if (range.offset >= 0 && range.uploadFrom < range.end) extendedRange = range;
+        uploadSize += range.end - range.uploadFrom;
+        totalSize += range.end - range.start;
+      }
 
-        var size = GL.calcBufLength(cb.size, cb.type, cb.stride, count);
-        var buf = GL.getTempVertexBuffer(size);
-        GLctx.bindBuffer(GLctx.ARRAY_BUFFER, buf);
-        GLctx.bufferSubData(GLctx.ARRAY_BUFFER,
-                                 0,
-                                 HEAPU8.subarray(cb.ptr, cb.ptr + size));
+      if (context.streamingVertexBufferOffset + uploadSize > context.streamingVertexBufferSize) {
+        // Starting over in fresh storage, where none of the previous ranges are present.
+        if (totalSize > context.streamingVertexBufferSize) GL.growStreamingVertexBuffer(context, totalSize);
+        GL.orphanStreamingVertexBuffer(context);
+        for (var i = 0; i < numRanges; ++i) {
+          ranges[i].offset = -1;
+          ranges[i].uploadFrom = ranges[i].start;
+        }
+        extendedRange = null;
+        uploadSize = totalSize;
+      } else {
+        GLctx.bindBuffer(GLctx.ARRAY_BUFFER, context.streamingVertexBuffer);
+      }
+
+      if (uploadSize) {
+        var mirror = context.streamingVertexBufferMirror;
+        var uploadStart = context.streamingVertexBufferOffset;
+        // The tail of an extended range has to go right after its beginning, which is at the end of the used space.
+        if (extendedRange) {
+          mirror.set(HEAP32.subarray(extendedRange.uploadFrom >> 2, extendedRange.end >> 2), context.streamingVertexBufferOffset >> 2);
+          context.streamingVertexBufferOffset += extendedRange.end - extendedRange.uploadFrom;
+        }
+        for (var i = 0; i < numRanges; ++i) {
+          range = ranges[i];
+          if (range.offset >= 0) continue;
+          range.offset = context.streamingVertexBufferOffset;
+          mirror.set(HEAP32.subarray(range.start >> 2, range.end >> 2), range.offset >> 2);
+          context.streamingVertexBufferOffset += range.end - range.start;
+        }
+        GLctx.bufferSubData(GLctx.ARRAY_BUFFER, uploadStart, mirror.subarray(uploadStart >> 2, context.streamingVertexBufferOffset >> 2));
+#if GL_PROFILE
+        GL.profileUpload(context.streamingVertexBufferOffset - uploadStart);
+#endif
+      }
+
+      for (var i = 0; i < attribs.length; ++i) {
+        var cb = clientBuffers[attribs[i]];
+        var offset = cb.range.offset + cb.ptr - cb.range.start;
 #if GL_ASSERTIONS
-        GL.validateVertexAttribPointer(cb.size, cb.type, cb.stride, 0);
+        GL.validateVertexAttribPointer(cb.size, cb.type, cb.stride, offset);
 #endif
-        GLctx.vertexAttribPointer(i, cb.size, cb.type, cb.normalized, cb.stride, 0);
+        GLctx.vertexAttribPointer(attribs[i], cb.size, cb.type, cb.normalized, cb.stride, offset);
       }
+
+      context.streamingRanges = context.prevStreamingRanges;
+      context.prevStreamingRanges = ranges;
+      context.numPrevStreamingRanges = numRanges;
     },
 
     postDrawHandleClientVertexAttribBindings: function postDrawHandleClientVertexAttribBindings() {
@@ -534,6 +819,9 @@ var LibraryGL = {
       // Store the created context object so that we can access the context given a canvas without having to pass the parameters again.
       if (ctx.canvas) ctx.canvas.GLctxObject = context;
       GL.contexts[handle] = context;
+#if GL_STATE_CACHE
+      GL.initStateCache(context);
+#endif
       if (typeof webGLContextAttributes['enableExtensionsByDefault'] === 'undefined' || webGLContextAttributes.enableExtensionsByDefault) {
         GL.initExtensions(context);
       }
@@ -575,10 +863,19 @@ var LibraryGL = {
 #if FULL_ES2
       context.clientBuffers = [];
       for (var i = 0; i < context.maxVertexAttribs; i++) {
-        context.clientBuffers[i] = { enabled: false, clientside: false, size: 0, type: 0, normalized: 0, stride: 0, ptr: 0 };
+        context.clientBuffers[i] = { enabled: false, clientside: false, size: 0, type: 0, normalized: 0, stride: 0, ptr: 0, start: 0, end: 0, range: null };
       }
 
       GL.generateTempBuffers(false, context);
+
+      context.streamingVertexBuffer = null; // Created on-demand
+      context.streamingVertexBufferSize = 0;
+      context.streamingVertexBufferOffset = 0; // First free byte in the streaming vertex buffer.
+      context.streamingVertexBufferMirror = null; // Int32Array holding a CPU side copy of the streaming vertex buffer contents.
+      context.streamingVertexBufferOrphan = false;
+      context.streamingRanges = []; // Ranges of client memory uploaded for the current draw call
+      context.prevStreamingRanges = []; // and the previous one, each an object { start, end, offset }.
+      context.numStreamingRanges = context.numPrevStreamingRanges = 0;
 #endif
 
       // Detect the presence of a few extensions manually, this GL interop layer itself will need to know if they exist. 
@@ -984,6 +1281,9 @@ var LibraryGL = {
     var heapView;
     if (data) {
       heapView = {{{ makeHEAPView('U8', 'data', 'data+imageSize') }}};
+#if GL_PROFILE
+      GL.profileUpload(imageSize);
+#endif
     } else {
       heapView = null;
     }
@@ -996,6 +1296,9 @@ var LibraryGL = {
     var heapView;
     if (data) {
       heapView = {{{ makeHEAPView('U8', 'data', 'data+imageSize') }}};
+#if GL_PROFILE
+      GL.profileUpload(imageSize);
+#endif
     } else {
       heapView = null;
     }
@@ -1008,6 +1311,9 @@ var LibraryGL = {
     var heapView;
     if (data) {
       heapView = {{{ makeHEAPView('U8', 'data', 'data+imageSize') }}};
+#if GL_PROFILE
+      GL.profileUpload(imageSize);
+#endif
     } else {
       heapView = null;
     }
@@ -1020,6 +1326,9 @@ var LibraryGL = {
     var heapView;
     if (data) {
       heapView = {{{ makeHEAPView('U8', 'data', 'data+imageSize') }}};
+#if GL_PROFILE
+      GL.profileUpload(imageSize);
+#endif
     } else {
       heapView = null;
     }
@@ -1127,6 +1436,9 @@ var LibraryGL = {
       var data = emscriptenWebGLGetTexPixelData(type, format, width, height, pixels, internalFormat);
       pixelData = data.pixels;
       internalFormat = data.internalFormat;
+#if GL_PROFILE
+      if (pixelData) GL.profileUpload(pixelData.byteLength);
+#endif
     } else {
       pixelData = null;
     }
@@ -1139,6 +1451,9 @@ var LibraryGL = {
     var pixelData;
     if (pixels) {
       pixelData = emscriptenWebGLGetTexPixelData(type, format, width, height, pixels, -1).pixels;
+#if GL_PROFILE
+      if (pixelData) GL.profileUpload(pixelData.byteLength);
+#endif
     } else {
       pixelData = null;
     }
@@ -1249,6 +1564,13 @@ var LibraryGL = {
 
       if (id == GL.currArrayBuffer) GL.currArrayBuffer = 0;
       if (id == GL.currElementArrayBuffer) GL.currElementArrayBuffer = 0;
+#if GL_STATE_CACHE
+      // Deleting a buffer unbinds it from all targets it is bound to.
+      var cachedBuffers = GL.currentContext.stateCache.buffers;
+      for (var target in cachedBuffers) {
+        if (cachedBuffers[target] === id) cachedBuffers[target] = 0;
+      }
+#endif
     }
   },
 
@@ -1301,12 +1623,18 @@ var LibraryGL = {
     if (!data) {
       GLctx.bufferData(target, size, usage);
     } else {
+#if GL_PROFILE
+      GL.profileUpload(size);
+#endif
       GLctx.bufferData(target, HEAPU8.subarray(data, data+size), usage);
     }
   },
 
   glBufferSubData__sig: 'viiii',
   glBufferSubData: function(target, offset, size, data) {
+#if GL_PROFILE
+    GL.profileUpload(size);
+#endif
     GLctx.bufferSubData(target, offset, HEAPU8.subarray(data, data+size));
   },
 
@@ -1841,6 +2169,9 @@ var LibraryGL = {
     GL.validateGLObjectID(GL.buffers, buffer, 'glBindBufferBase', 'buffer');
 #endif
     var bufferObj = buffer ? GL.buffers[buffer] : null;
+#if GL_STATE_CACHE
+    delete GL.currentContext.stateCache.buffers[target]; // Also binds the buffer to the generic binding point of target.
+#endif
     GLctx['bindBufferBase'](target, index, bufferObj);
   },
 
@@ -1850,6 +2181,9 @@ var LibraryGL = {
     GL.validateGLObjectID(GL.buffers, buffer, 'glBindBufferRange', 'buffer');
 #endif
     var bufferObj = buffer ? GL.buffers[buffer] : null;
+#if GL_STATE_CACHE
+    delete GL.currentContext.stateCache.buffers[target]; // Also binds the buffer to the generic binding point of target.
+#endif
     GLctx['bindBufferRange'](target, index, bufferObj, offset, ptrsize);
   },
 
@@ -2388,6 +2722,9 @@ var LibraryGL = {
   glUniform1f: function(location, v0) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform1f', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniform(location, 'f', v0)) return;
 #endif
     location = GL.uniforms[location];
     GLctx.uniform1f(location, v0);
@@ -2397,6 +2734,9 @@ var LibraryGL = {
   glUniform2f: function(location, v0, v1) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform2f', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniform(location, 'f', v0, v1)) return;
 #endif
     location = GL.uniforms[location];
     GLctx.uniform2f(location, v0, v1);
@@ -2406,6 +2746,9 @@ var LibraryGL = {
   glUniform3f: function(location, v0, v1, v2) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform3f', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniform(location, 'f', v0, v1, v2)) return;
 #endif
     location = GL.uniforms[location];
     GLctx.uniform3f(location, v0, v1, v2);
@@ -2415,6 +2758,9 @@ var LibraryGL = {
   glUniform4f: function(location, v0, v1, v2, v3) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform4f', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniform(location, 'f', v0, v1, v2, v3)) return;
 #endif
     location = GL.uniforms[location];
     GLctx.uniform4f(location, v0, v1, v2, v3);
@@ -2424,6 +2770,9 @@ var LibraryGL = {
   glUniform1i: function(location, v0) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform1i', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniform(location, 'i', v0)) return;
 #endif
     location = GL.uniforms[location];
     GLctx.uniform1i(location, v0);
@@ -2433,6 +2782,9 @@ var LibraryGL = {
   glUniform2i: function(location, v0, v1) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform2i', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniform(location, 'i', v0, v1)) return;
 #endif
     location = GL.uniforms[location];
     GLctx.uniform2i(location, v0, v1);
@@ -2442,6 +2794,9 @@ var LibraryGL = {
   glUniform3i: function(location, v0, v1, v2) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform3i', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniform(location, 'i', v0, v1, v2)) return;
 #endif
     location = GL.uniforms[location];
     GLctx.uniform3i(location, v0, v1, v2);
@@ -2451,6 +2806,9 @@ var LibraryGL = {
   glUniform4i: function(location, v0, v1, v2, v3) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform4i', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniform(location, 'i', v0, v1, v2, v3)) return;
 #endif
     location = GL.uniforms[location];
     GLctx.uniform4i(location, v0, v1, v2, v3);
@@ -2460,6 +2818,9 @@ var LibraryGL = {
   glUniform1iv: function(location, count, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform1iv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, 'i', count, 1, HEAP32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     value = {{{ makeHEAPView('32', 'value', 'value+count*4') }}};
@@ -2474,6 +2835,9 @@ var LibraryGL = {
   glUniform2iv: function(location, count, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform2iv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, 'i', count, 2, HEAP32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     count *= 2;
@@ -2489,6 +2853,9 @@ var LibraryGL = {
   glUniform3iv: function(location, count, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform3iv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, 'i', count, 3, HEAP32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     count *= 3;
@@ -2504,6 +2871,9 @@ var LibraryGL = {
   glUniform4iv: function(location, count, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform4iv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, 'i', count, 4, HEAP32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     count *= 4;
@@ -2519,6 +2889,9 @@ var LibraryGL = {
   glUniform1fv: function(location, count, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform1fv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, 'f', count, 1, HEAPF32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     var view;
@@ -2540,6 +2913,9 @@ var LibraryGL = {
   glUniform2fv: function(location, count, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform2fv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, 'f', count, 2, HEAPF32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     var view;
@@ -2562,6 +2938,9 @@ var LibraryGL = {
   glUniform3fv: function(location, count, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform3fv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, 'f', count, 3, HEAPF32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     var view;
@@ -2585,6 +2964,9 @@ var LibraryGL = {
   glUniform4fv: function(location, count, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniform4fv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, 'f', count, 4, HEAPF32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     var view;
@@ -2706,6 +3088,9 @@ var LibraryGL = {
   glUniformMatrix2fv: function(location, count, transpose, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniformMatrix2fv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, transpose ? 'mt' : 'm', count, 4, HEAPF32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     var view;
@@ -2729,6 +3114,9 @@ var LibraryGL = {
   glUniformMatrix3fv: function(location, count, transpose, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniformMatrix3fv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, transpose ? 'mt' : 'm', count, 9, HEAPF32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     var view;
@@ -2752,6 +3140,9 @@ var LibraryGL = {
   glUniformMatrix4fv: function(location, count, transpose, value) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.uniforms, location, 'glUniformMatrix4fv', 'location');
+#endif
+#if GL_STATE_CACHE
+    if (GL.stateCacheUniformv(location, transpose ? 'mt' : 'm', count, 16, HEAPF32, value >> 2)) return;
 #endif
     location = GL.uniforms[location];
     var view;
@@ -2915,6 +3306,15 @@ var LibraryGL = {
   glBindBuffer: function(target, buffer) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.buffers, buffer, 'glBindBuffer', 'buffer');
+#endif
+#if GL_STATE_CACHE
+    var cache = GL.currentContext.stateCache;
+    if (cache.buffers[target] === buffer) {
+      ++cache.filtered;
+      return;
+    }
+    cache.buffers[target] = buffer;
+    ++cache.issued;
 #endif
     var bufferObj = buffer ? GL.buffers[buffer] : null;
 
@@ -3285,6 +3685,15 @@ var LibraryGL = {
   glUseProgram: function(program) {
 #if GL_ASSERTIONS
     GL.validateGLObjectID(GL.programs, program, 'glUseProgram', 'program');
+#endif
+#if GL_STATE_CACHE
+    var cache = GL.currentContext.stateCache;
+    if (cache.program === program) {
+      ++cache.filtered;
+      return;
+    }
+    cache.program = program;
+    ++cache.issued;
 #endif
     GLctx.useProgram(program ? GL.programs[program] : null);
   },
@@ -3455,6 +3864,10 @@ var LibraryGL = {
       GLctx['deleteVertexArray'](GL.vaos[id]);
       GL.vaos[id] = null;
     }
+#if GL_STATE_CACHE
+    // Deleting the bound vertex array object reverts to the default one, which has a different element array buffer.
+    delete GL.currentContext.stateCache.buffers[0x8893 /*GL_ELEMENT_ARRAY_BUFFER*/];
+#endif
 #endif
   },
   
@@ -3470,6 +3883,10 @@ var LibraryGL = {
     assert(GLctx['bindVertexArray'], 'Must have WebGL2 or OES_vertex_array_object to use vao');
 #endif
     GLctx['bindVertexArray'](GL.vaos[vao]);
+#if GL_STATE_CACHE
+    // The element array buffer binding is part of the vertex array object state.
+    delete GL.currentContext.stateCache.buffers[0x8893 /*GL_ELEMENT_ARRAY_BUFFER*/];
+#endif
 #endif
   },
 
@@ -6982,6 +7399,9 @@ var LibraryGL = {
       GLctx.bufferSubData(GLctx.ELEMENT_ARRAY_BUFFER,
                                0,
                                HEAPU8.subarray(indices, indices + size));
+#if GL_PROFILE
+      GL.profileUpload(size);
+#endif
       // the index is now 0
       indices = 0;
     }
@@ -7025,6 +7445,71 @@ var LibraryGL = {
     // NOP (as allowed by GLES 2.0 spec)
   },
 
+  glEnable__sig: 'vi',
+  glEnable: function(cap) {
+#if GL_STATE_CACHE
+    var cache = GL.currentContext.stateCache;
+    if (cache.caps[cap] === true) {
+      ++cache.filtered;
+      return;
+    }
+    cache.caps[cap] = true;
+    ++cache.issued;
+#endif
+    GLctx.enable(cap);
+  },
+
+  glDisable__sig: 'vi',
+  glDisable: function(cap) {
+#if GL_STATE_CACHE
+    var cache = GL.currentContext.stateCache;
+    if (cache.caps[cap] === false) {
+      ++cache.filtered;
+      return;
+    }
+    cache.caps[cap] = false;
+    ++cache.issued;
+#endif
+    GLctx.disable(cap);
+  },
+
+  emscripten_gl_profile_end_frame: function() {
+#if GL_PROFILE
+    GL.profileEndFrame();
+#endif
+  },
+
+  emscripten_gl_profile_get_frame: function(entries, maxEntries) {
+#if GL_PROFILE
+    if (!GL.profileLastFrame) return 0;
+    var ids = [];
+    for (var i = 0; i < GL.profileNames.length; ++i) {
+      var entry = GL.profileLastFrame + i * {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}};
+      if ({{{ makeGetValue('entry', C_STRUCTS.emscripten_gl_profile_entry.calls, 'i32') }}}) ids.push(i);
+    }
+    function msecs(id) {
+      return {{{ makeGetValue('GL.profileLastFrame + id * ' + C_STRUCTS.emscripten_gl_profile_entry.__size__, C_STRUCTS.emscripten_gl_profile_entry.msecs, 'double') }}};
+    }
+    ids.sort(function(a, b) { return msecs(b) - msecs(a); });
+    var n = Math.min(ids.length, maxEntries);
+    for (var i = 0; i < n; ++i) {
+      var src = GL.profileLastFrame + ids[i] * {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}};
+      HEAPU8.set(HEAPU8.subarray(src, src + {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}}), entries + i * {{{ C_STRUCTS.emscripten_gl_profile_entry.__size__ }}});
+    }
+    return n;
+#else
+    return -1;
+#endif
+  },
+
+  emscripten_gl_profile_reset: function() {
+#if GL_PROFILE
+    if (!GL.profileTable) return;
+    GL.profileClear(GL.profileTable);
+    GL.profileClear(GL.profileLastFrame);
+#endif
+  },
+
   glGetError__sig: 'i',
   glGetError: function() {
     // First return any GL error generated by the emscripten library_gl.js interop layer.
@@ -7153,7 +7638,7 @@ var LibraryGL = {
 
 // Simple pass-through functions. Starred ones have return values. [X] ones have X in the C name but not in the JS name
 var glFuncs = [[0, 'finish flush'],
- [1, 'clearDepth clearDepth[f] depthFunc enable disable frontFace cullFace clear lineWidth clearStencil depthMask stencilMask checkFramebufferStatus* generateMipmap activeTexture blendEquation isEnabled*'],
+ [1, 'clearDepth clearDepth[f] depthFunc frontFace cullFace clear lineWidth clearStencil depthMask stencilMask checkFramebufferStatus* generateMipmap activeTexture blendEquation isEnabled*'],
  [2, 'blendFunc blendEquationSeparate depthRange depthRange[f] stencilMaskSeparate hint polygonOffset vertexAttrib1f sampleCoverage'],
  [3, 'texParameteri texParameterf vertexAttrib2f stencilFunc stencilOp'],
  [4, 'viewport clearColor scissor vertexAttrib3f colorMask renderbufferStorage blendFuncSeparate blendColor stencilFuncSeparate stencilOpSeparate'],
@@ -7221,6 +7706,24 @@ function copyLibEntry(a, b) {
   LibraryGL[a + '__deps'] = LibraryGL[b + '__deps'].slice(0);
 }
 
+#if GL_PROFILE
+// Wrap each GL function for profiling. The original function is kept as $<name>Unprofiled, and the wrapper calls it
+// between GL.profileEnter() and GL.profileExit(), identifying itself with its index in GL.profileNames.
+keys(LibraryGL).forEach(function(x) {
+  if (x.substr(-6) == '__deps' || x.substr(-9) == '__postset' || x.substr(-5) == '__sig' || x.substr(-5) == '__asm' || x.substr(0, 2) != 'gl') return;
+  if (typeof LibraryGL[x] !== 'function') return; // Aliases get resolved to the wrapped functions below.
+  var id = LibraryGL.$GL.profileNames.length;
+  LibraryGL.$GL.profileNames.push(x);
+  var impl = x + 'Unprofiled';
+  LibraryGL['$' + impl] = LibraryGL[x];
+  LibraryGL['$' + impl + '__deps'] = (LibraryGL[x + '__deps'] || []).slice(0);
+  var args = range(LibraryGL[x].length).map(function(i) { return 'p' + i }).join(', ');
+  LibraryGL[x] = eval('(function(' + args + ') { var prev = GL.profileCurrent, start = GL.profileEnter(' + id + '); ' +
+                      'var ret = ' + impl + '(' + args + '); GL.profileExit(' + id + ', prev, start); return ret; })');
+  LibraryGL[x + '__deps'] = ['$GL', '$' + impl];
+});
+#endif
+
 // GL proc address retrieval - allow access through glX and emscripten_glX, to allow name collisions with user-implemented things having the same name (see gl.c)
 keys(LibraryGL).forEach(function(x) {
   if (x.substr(-6) == '__deps' || x.substr(-9) == '__postset' || x.substr(-5) == '__sig' || x.substr(-5) == '__asm' || x.substr(0, 2) != 'gl') return;
@@ -7248,4 +7751,5 @@ keys(LibraryGL).forEach(function(x) {
 mergeInto(LibraryManager.library, LibraryGL);
 
 assert(!(FULL_ES2 && LEGACY_GL_EMULATION), 'cannot emulate both ES2 and legacy GL');
+assert(!(GL_STATE_CACHE && (FULL_ES2 || LEGACY_GL_EMULATION)), 'GL_STATE_CACHE is not supported with FULL_ES2 or LEGACY_GL_EMULATION');
 
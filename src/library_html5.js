@@ -1767,6 +1767,36 @@ var LibraryJSEvents = {
     return ext ? 1 : 0;
   },
 
+  emscripten_webgl_get_state_cache_stats__deps: ['$GL'],
+  emscripten_webgl_get_state_cache_stats: function(contextHandle, stats) {
+#if GL_STATE_CACHE
+    var context = GL.getContext(contextHandle);
+    if (!context) return {{{ cDefine('EMSCRIPTEN_RESULT_INVALID_PARAM') }}};
+    var cache = context.stateCache;
+    {{{ makeSetValue('stats', C_STRUCTS.EmscriptenWebGLStateCacheStats.issuedThisFrame, 'cache.issued', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.EmscriptenWebGLStateCacheStats.filteredThisFrame, 'cache.filtered', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.EmscriptenWebGLStateCacheStats.issuedLastFrame, 'cache.issuedLastFrame', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.EmscriptenWebGLStateCacheStats.filteredLastFrame, 'cache.filteredLastFrame', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.EmscriptenWebGLStateCacheStats.totalIssued, 'cache.totalIssued + cache.issued', 'double') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.EmscriptenWebGLStateCacheStats.totalFiltered, 'cache.totalFiltered + cache.filtered', 'double') }}};
+    return {{{ cDefine('EMSCRIPTEN_RESULT_SUCCESS') }}};
+#else
+    return {{{ cDefine('EMSCRIPTEN_RESULT_NOT_SUPPORTED') }}};
+#endif
+  },
+
+  emscripten_webgl_invalidate_state_cache__deps: ['$GL'],
+  emscripten_webgl_invalidate_state_cache: function(contextHandle) {
+#if GL_STATE_CACHE
+    var context = GL.getContext(contextHandle);
+    if (!context) return {{{ cDefine('EMSCRIPTEN_RESULT_INVALID_PARAM') }}};
+    GL.invalidateStateCache(context);
+    return {{{ cDefine('EMSCRIPTEN_RESULT_SUCCESS') }}};
+#else
+    return {{{ cDefine('EMSCRIPTEN_RESULT_NOT_SUPPORTED') }}};
+#endif
+  },
+
   emscripten_set_webglcontextlost_callback: function(target, userData, useCapture, callbackfunc) {
     JSEvents.registerWebGlEventCallback(target, userData, useCapture, callbackfunc, {{{ cDefine('EMSCRIPTEN_EVENT_WEBGLCONTEXTLOST') }}}, "webglcontextlost");
     return {{{ cDefine('EMSCRIPTEN_RESULT_SUCCESS') }}};
@@ -6,6 +6,18 @@ mergeInto(LibraryManager.library, {
     FILE_MODE: {{{ cDefine('S_IFREG') }}} | 511 /* 0777 */,
     CHUNK_SIZE: -1,
     codec: null,
+    cacheChunks: {{{ LZ4_CACHE_CHUNKS }}}, // decompressed chunks kept per package, read when a package is loaded
+    readAheadChunks: 4, // chunks decompressed in the background after a read continues into the next chunk
+    bulkReadChunks: 4, // reads covering at least this many chunks decompress them straight into the destination
+    stats: {
+      hits: 0, // chunk reads served from the cache
+      misses: 0, // chunks decompressed during a read
+      readAheads: 0, // chunks decompressed in the background
+      readAheadHits: 0, // reads served from a chunk that was decompressed in the background
+      bulkChunks: 0, // chunks decompressed straight into the destination of a large read
+    },
+    readAheadQueue: [], // pairs of compressedData, chunk index
+    readAheadScheduled: false,
     init: function() {
       if (LZ4.codec) return;
       LZ4.codec = (function() {
@@ -14,17 +26,14 @@ mergeInto(LibraryManager.library, {
       })();
       LZ4.CHUNK_SIZE = LZ4.codec.CHUNK_SIZE;
     },
+    resetStats: function() {
+      for (var name in LZ4.stats) LZ4.stats[name] = 0;
+    },
     loadPackage: function (pack) {
       LZ4.init();
       var compressedData = pack['compressedData'];
       if (!compressedData) compressedData = LZ4.codec.compressPackage(pack['data']);
-      assert(compressedData.cachedIndexes.length === compressedData.cachedChunks.length);
-      for (var i = 0; i < compressedData.cachedIndexes.length; i++) {
-        compressedData.cachedIndexes[i] = -1;
-        compressedData.cachedChunks[i] = compressedData.data.subarray(compressedData.cachedOffset + i*LZ4.CHUNK_SIZE,
-                                                                      compressedData.cachedOffset + (i+1)*LZ4.CHUNK_SIZE);
-        assert(compressedData.cachedChunks[i].length === LZ4.CHUNK_SIZE);
-      }
+      compressedData.cache = LZ4.createCache(compressedData.successes.length);
       console.log('loading package');
       pack['metadata'].files.forEach(function(file) {
         var dir = PATH.dirname(file.filename);
@@ -38,6 +47,155 @@ mergeInto(LibraryManager.library, {
         });
       });
     },
+    // An LRU cache of decompressed chunks. The slots form a doubly linked list, most recently used first, and
+    // slotOf maps a chunk index to its slot (or -1), so lookups and updates are O(1).
+    createCache: function(numChunks) {
+      var size = Math.max(Math.min(LZ4.cacheChunks, numChunks), 1);
+      var cache = {
+        storage: new Uint8Array(size * LZ4.CHUNK_SIZE),
+        chunks: [],
+        slotOf: new Int32Array(numChunks),
+        chunkOf: new Int32Array(size),
+        prev: new Int32Array(size),
+        next: new Int32Array(size),
+        readAhead: new Uint8Array(size), // 1 if the slot was filled in the background and not read yet
+        pending: new Uint8Array(numChunks), // 1 if the chunk is queued for read-ahead
+        head: 0,
+        tail: size - 1,
+        lastChunk: -1,
+      };
+      for (var i = 0; i < numChunks; i++) cache.slotOf[i] = -1;
+      for (var i = 0; i < size; i++) {
+        cache.chunks[i] = cache.storage.subarray(i * LZ4.CHUNK_SIZE, (i + 1) * LZ4.CHUNK_SIZE);
+        cache.chunkOf[i] = -1;
+        cache.prev[i] = i - 1;
+        cache.next[i] = i + 1 < size ? i + 1 : -1;
+      }
+      return cache;
+    },
+    touchSlot: function(cache, slot) {
+      if (cache.head === slot) return;
+      var prev = cache.prev[slot], next = cache.next[slot];
+      cache.next[prev] = next;
+      if (next >= 0) cache.prev[next] = prev;
+      else cache.tail = prev;
+      cache.prev[slot] = -1;
+      cache.next[slot] = cache.head;
+      cache.prev[cache.head] = slot;
+      cache.head = slot;
+    },
+    // Evicts the least recently used chunk, and returns its slot, now holding chunkIndex.
+    allocateSlot: function(cache, chunkIndex) {
+      var slot = cache.tail;
+      if (cache.chunkOf[slot] >= 0) cache.slotOf[cache.chunkOf[slot]] = -1;
+      cache.chunkOf[slot] = chunkIndex;
+      cache.slotOf[chunkIndex] = slot;
+      cache.readAhead[slot] = 0;
+      LZ4.touchSlot(cache, slot);
+      return slot;
+    },
+    decompressChunk: function(compressedData, chunkIndex, output) {
+      if (compressedData.debug) {
+        console.log('decompressing chunk ' + chunkIndex);
+        Module['decompressedChunks'] = (Module['decompressedChunks'] || 0) + 1;
+      }
+      var compressedStart = compressedData.offsets[chunkIndex];
+      var compressed = compressedData.data.subarray(compressedStart, compressedStart + compressedData.sizes[chunkIndex]);
+      var originalSize = LZ4.codec.uncompress(compressed, output);
+      if (chunkIndex < compressedData.successes.length-1) assert(originalSize === LZ4.CHUNK_SIZE); // all but the last chunk must be full-size
+    },
+    // Returns the decompressed contents of a chunk, from the cache if possible.
+    getChunk: function(compressedData, chunkIndex) {
+      var cache = compressedData.cache;
+      var slot = cache.slotOf[chunkIndex];
+      if (slot >= 0) {
+        LZ4.stats.hits++;
+        if (cache.readAhead[slot]) {
+          LZ4.stats.readAheadHits++;
+          cache.readAhead[slot] = 0;
+          LZ4.readAhead(compressedData, chunkIndex); // stay ahead of a sequential reader
+        }
+        LZ4.touchSlot(cache, slot);
+        return cache.chunks[slot];
+      }
+      LZ4.stats.misses++;
+      slot = LZ4.allocateSlot(cache, chunkIndex);
+      LZ4.decompressChunk(compressedData, chunkIndex, cache.chunks[slot]);
+      return cache.chunks[slot];
+    },
+    // Queues the chunks after chunkIndex to be decompressed once the current read is done, so that sequential
+    // reads find them in the cache.
+    readAhead: function(compressedData, chunkIndex) {
+      if (typeof setTimeout === 'undefined') return;
+      var cache = compressedData.cache;
+      var count = Math.min(LZ4.readAheadChunks, cache.chunks.length >> 1);
+      var end = Math.min(chunkIndex + 1 + count, compressedData.successes.length);
+      for (var i = chunkIndex + 1; i < end; i++) {
+        if (!compressedData.successes[i] || cache.slotOf[i] >= 0 || cache.pending[i]) continue;
+        cache.pending[i] = 1;
+#if LZ4_WORKER
+        if (LZ4.decompressInWorker(compressedData, i)) continue;
+#endif
+        LZ4.readAheadQueue.push(compressedData, i);
+      }
+      if (LZ4.readAheadQueue.length && !LZ4.readAheadScheduled) {
+        LZ4.readAheadScheduled = true;
+        setTimeout(LZ4.runReadAhead, 0);
+      }
+    },
+    runReadAhead: function() {
+      LZ4.readAheadScheduled = false;
+      var queue = LZ4.readAheadQueue;
+      LZ4.readAheadQueue = [];
+      for (var i = 0; i < queue.length; i += 2) {
+        var compressedData = queue[i], chunkIndex = queue[i+1];
+        var cache = compressedData.cache;
+        cache.pending[chunkIndex] = 0;
+        if (cache.slotOf[chunkIndex] >= 0) continue; // a read needed it first
+        var slot = LZ4.allocateSlot(cache, chunkIndex);
+        LZ4.decompressChunk(compressedData, chunkIndex, cache.chunks[slot]);
+        cache.readAhead[slot] = 1;
+        LZ4.stats.readAheads++;
+      }
+    },
+#if LZ4_WORKER
+    worker: null,
+    workerRequests: [], // compressedData of each chunk sent to the worker, by chunk index and request id
+    decompressInWorker: function(compressedData, chunkIndex) {
+      if (!LZ4.worker) {
+        if (typeof Worker === 'undefined' || typeof Blob === 'undefined' || typeof URL === 'undefined') return false;
+        // The codec is embedded as a string, so the worker gets the same source whatever the optimizer does to ours.
+        var source = {{{ JSON.stringify(read('mini-lz4.js')) }}} +
+                     'function assert(condition, text) { if (!condition) throw text }\n' +
+                     'onmessage = function(e) {\n' +
+                     '  var output = new Uint8Array(MiniLZ4.CHUNK_SIZE);\n' +
+                     '  var size = MiniLZ4.uncompress(e.data[2], output);\n' +
+                     '  postMessage([e.data[0], e.data[1], output, size], [output.buffer]);\n' +
+                     '};\n';
+        LZ4.worker = new Worker(URL.createObjectURL(new Blob([source], { 'type': 'application/javascript' })));
+        LZ4.worker.onmessage = function(e) {
+          var id = e.data[0], chunkIndex = e.data[1], output = e.data[2], size = e.data[3];
+          var compressedData = LZ4.workerRequests[id];
+          LZ4.workerRequests[id] = null;
+          var cache = compressedData.cache;
+          cache.pending[chunkIndex] = 0;
+          if (cache.slotOf[chunkIndex] >= 0) return; // a read needed it first
+          if (chunkIndex < compressedData.successes.length-1) assert(size === LZ4.CHUNK_SIZE);
+          var slot = LZ4.allocateSlot(cache, chunkIndex);
+          cache.chunks[slot].set(output.subarray(0, size));
+          cache.readAhead[slot] = 1;
+          LZ4.stats.readAheads++;
+        };
+      }
+      var id = LZ4.workerRequests.indexOf(null);
+      if (id < 0) id = LZ4.workerRequests.length;
+      LZ4.workerRequests[id] = compressedData;
+      var compressedStart = compressedData.offsets[chunkIndex];
+      var compressed = new Uint8Array(compressedData.data.subarray(compressedStart, compressedStart + compressedData.sizes[chunkIndex]));
+      LZ4.worker.postMessage([id, chunkIndex, compressed], [compressed.buffer]);
+      return true;
+    },
+#endif
     createNode: function (parent, name, mode, dev, contents, mtime) {
       var node = FS.createNode(parent, name, mode);
       node.mode = mode;
@@ -115,41 +273,35 @@ mergeInto(LibraryManager.library, {
         if (length <= 0) return 0;
         var contents = stream.node.contents;
         var compressedData = contents.compressedData;
+        var cache = compressedData.cache;
+        var bulk = length >= LZ4.bulkReadChunks * LZ4.CHUNK_SIZE;
         var written = 0;
         while (written < length) {
           var start = contents.start + position + written; // start index in uncompressed data
           var desired = length - written;
           //console.log('current read: ' + ['start', start, 'desired', desired]);
           var chunkIndex = Math.floor(start / LZ4.CHUNK_SIZE);
-          var compressedStart = compressedData.offsets[chunkIndex];
-          var compressedSize = compressedData.sizes[chunkIndex];
+          var startInChunk = start % LZ4.CHUNK_SIZE;
+          var endInChunk = Math.min(startInChunk + desired, LZ4.CHUNK_SIZE);
           var currChunk;
           if (compressedData.successes[chunkIndex]) {
-            var found = compressedData.cachedIndexes.indexOf(chunkIndex);
-            if (found >= 0) {
-              currChunk = compressedData.cachedChunks[found];
-            } else {
-              // decompress the chunk
-              compressedData.cachedIndexes.pop();
-              compressedData.cachedIndexes.unshift(chunkIndex);
-              currChunk = compressedData.cachedChunks.pop();
-              compressedData.cachedChunks.unshift(currChunk);
-              if (compressedData.debug) {
-                console.log('decompressing chunk ' + chunkIndex);
-                Module['decompressedChunks'] = (Module['decompressedChunks'] || 0) + 1;
-              }
-              var compressed = compressedData.data.subarray(compressedStart, compressedStart + compressedSize);
-              //var t = Date.now();
-              var originalSize = LZ4.codec.uncompress(compressed, currChunk);
-              //console.log('decompress time: ' + (Date.now() - t));
-              if (chunkIndex < compressedData.successes.length-1) assert(originalSize === LZ4.CHUNK_SIZE); // all but the last chunk must be full-size
+            if (bulk && startInChunk === 0 && endInChunk === LZ4.CHUNK_SIZE && cache.slotOf[chunkIndex] < 0) {
+              // the whole chunk is wanted, decompress it in place instead of through the cache (using a Uint8Array
+              // view like the cache slots, so the codec only ever sees one array type)
+              LZ4.stats.bulkChunks++;
+              LZ4.decompressChunk(compressedData, chunkIndex, new Uint8Array(buffer.buffer, buffer.byteOffset + offset + written, LZ4.CHUNK_SIZE));
+              written += LZ4.CHUNK_SIZE;
+              cache.lastChunk = chunkIndex;
+              continue;
             }
+            if (cache.slotOf[chunkIndex] < 0 && chunkIndex === cache.lastChunk + 1) LZ4.readAhead(compressedData, chunkIndex);
+            currChunk = LZ4.getChunk(compressedData, chunkIndex);
           } else {
             // uncompressed
+            var compressedStart = compressedData.offsets[chunkIndex];
             currChunk = compressedData.data.subarray(compressedStart, compressedStart + LZ4.CHUNK_SIZE);
           }
-          var startInChunk = start % LZ4.CHUNK_SIZE;
-          var endInChunk = Math.min(startInChunk + desired, LZ4.CHUNK_SIZE);
+          cache.lastChunk = chunkIndex;
           buffer.set(currChunk.subarray(startInChunk, endInChunk), offset + written);
           var currWritten = endInChunk - startInChunk;
           written += currWritten;
@@ -72,6 +72,9 @@ mergeInto(LibraryManager.library, {
         // for performance, and used by default. However, typed arrays are not resizable like normal JS arrays are, so there is a small disk size
         // penalty involved for appending file writes that continuously grow a file similar to std::vector capacity vs used -scheme.
         node.contents = null; 
+#if MEMFS_PAGE_SIZE
+        node.pages = null; // When the file has grown larger than a page, its data is kept in this list of pages instead of contents.
+#endif
       } else if (FS.isLink(node.mode)) {
         node.node_ops = MEMFS.ops_table.link.node;
         node.stream_ops = MEMFS.ops_table.link.stream;
@@ -89,6 +92,16 @@ mergeInto(LibraryManager.library, {
 
     // Given a file node, returns its file data converted to a regular JS array. You should treat this as read-only.
     getFileDataAsRegularArray: function(node) {
+#if MEMFS_PAGE_SIZE
+      if (node.pages) {
+        var arr = [];
+        for (var i = 0; i < node.usedBytes; ++i) {
+          var page = node.pages[(i / {{{ MEMFS_PAGE_SIZE }}}) | 0];
+          arr.push(page ? page[i % {{{ MEMFS_PAGE_SIZE }}}] : 0);
+        }
+        return arr;
+      }
+#endif
       if (node.contents && node.contents.subarray) {
         var arr = [];
         for (var i = 0; i < node.usedBytes; ++i) arr.push(node.contents[i]);
@@ -99,6 +112,16 @@ mergeInto(LibraryManager.library, {
 
     // Given a file node, returns its file data converted to a typed array.
     getFileDataAsTypedArray: function(node) {
+#if MEMFS_PAGE_SIZE
+      if (node.pages) {
+        // Gather the pages into a single typed array, which becomes the backing store of the file until it grows again.
+        var contents = new Uint8Array(node.usedBytes);
+        MEMFS.readPages(node, contents, 0, node.usedBytes, 0);
+        node.contents = contents;
+        node.pages = null;
+        return contents;
+      }
+#endif
       if (!node.contents) return new Uint8Array;
       if (node.contents.subarray) return node.contents.subarray(0, node.usedBytes); // Make sure to not return excess unused bytes.
       return new Uint8Array(node.contents);
@@ -108,6 +131,21 @@ mergeInto(LibraryManager.library, {
     // May allocate more, to provide automatic geometric increase and amortized linear performance appending writes.
     // Never shrinks the storage.
     expandFileStorage: function(node, newCapacity) {
+#if MEMFS_PAGE_SIZE
+      // Files that grow beyond one page switch to paged storage, so that appending never copies the existing data.
+      if (node.pages || newCapacity > {{{ MEMFS_PAGE_SIZE }}}) {
+        if (!node.pages) {
+          var contents = node.contents;
+          node.pages = [];
+          node.contents = null;
+          if (node.usedBytes) MEMFS.writePages(node, contents, 0, node.usedBytes, 0);
+        }
+        // Pages are allocated when they are first written to, missing ones read as zeros.
+        var numPages = Math.ceil(newCapacity / {{{ MEMFS_PAGE_SIZE }}});
+        if (node.pages.length < numPages) node.pages.length = numPages;
+        return;
+      }
+#endif
 #if !MEMFS_APPEND_TO_TYPED_ARRAYS
       // If we are asked to expand the size of a file that already exists, revert to using a standard JS array to store the file
       // instead of a typed array. This makes resizing the array more flexible because we can just .push() elements at the back to
@@ -142,9 +180,25 @@ mergeInto(LibraryManager.library, {
       if (node.usedBytes == newSize) return;
       if (newSize == 0) {
         node.contents = null; // Fully decommit when requesting a resize to zero.
+#if MEMFS_PAGE_SIZE
+        node.pages = null;
+#endif
         node.usedBytes = 0;
         return;
       }
+#if MEMFS_PAGE_SIZE
+      if (node.pages) {
+        var numPages = Math.ceil(newSize / {{{ MEMFS_PAGE_SIZE }}});
+        node.pages.length = numPages;
+        // Clear the end of the last page when shrinking, so that the file reads as zeros there if it grows again.
+        var last = node.pages[numPages - 1];
+        if (last && newSize < node.usedBytes) {
+          for (var i = newSize - (numPages - 1) * {{{ MEMFS_PAGE_SIZE }}}; i < {{{ MEMFS_PAGE_SIZE }}}; ++i) last[i] = 0;
+        }
+        node.usedBytes = newSize;
+        return;
+      }
+#endif
       if (!node.contents || node.contents.subarray) { // Resize a typed array if that is being used as the backing store.
         var oldContents = node.contents;
         node.contents = new Uint8Array(new ArrayBuffer(newSize)); // Allocate new storage.
@@ -161,6 +215,46 @@ mergeInto(LibraryManager.library, {
       node.usedBytes = newSize;
     },
 
+#if MEMFS_PAGE_SIZE
+    // Copies length bytes starting at position in the pages of the file to buffer[offset].
+    readPages: function(node, buffer, offset, length, position) {
+      while (length > 0) {
+        var index = (position / {{{ MEMFS_PAGE_SIZE }}}) | 0;
+        var start = position - index * {{{ MEMFS_PAGE_SIZE }}};
+        var size = Math.min(length, {{{ MEMFS_PAGE_SIZE }}} - start);
+        var page = node.pages[index];
+        if (page) {
+          buffer.set(page.subarray(start, start + size), offset);
+        } else {
+          for (var i = 0; i < size; i++) buffer[offset + i] = 0;
+        }
+        offset += size;
+        position += size;
+        length -= size;
+      }
+    },
+
+    // Copies length bytes from buffer[offset] to the pages of the file, starting at position. Allocates the pages
+    // that are written to for the first time.
+    writePages: function(node, buffer, offset, length, position) {
+      while (length > 0) {
+        var index = (position / {{{ MEMFS_PAGE_SIZE }}}) | 0;
+        var start = position - index * {{{ MEMFS_PAGE_SIZE }}};
+        var size = Math.min(length, {{{ MEMFS_PAGE_SIZE }}} - start);
+        var page = node.pages[index];
+        if (!page) page = node.pages[index] = new Uint8Array({{{ MEMFS_PAGE_SIZE }}});
+        if (buffer.subarray) {
+          page.set(buffer.subarray(offset, offset + size), start);
+        } else {
+          for (var i = 0; i < size; i++) page[start + i] = buffer[offset + i];
+        }
+        offset += size;
+        position += size;
+        length -= size;
+      }
+    },
+
+#endif
     node_ops: {
       getattr: function(node) {
         var attr = {};
@@ -265,6 +359,12 @@ mergeInto(LibraryManager.library, {
         if (position >= stream.node.usedBytes) return 0;
         var size = Math.min(stream.node.usedBytes - position, length);
         assert(size >= 0);
+#if MEMFS_PAGE_SIZE
+        if (stream.node.pages) {
+          MEMFS.readPages(stream.node, buffer, offset, size, position);
+          return size;
+        }
+#endif
         if (size > 8 && contents.subarray) { // non-trivial, and typed array
           buffer.set(contents.subarray(position, position + size), offset);
         } else {
@@ -279,6 +379,17 @@ mergeInto(LibraryManager.library, {
         var node = stream.node;
         node.timestamp = Date.now();
 
+#if MEMFS_PAGE_SIZE
+        if (node.pages) {
+          if (!canOwn) {
+            MEMFS.expandFileStorage(node, position+length);
+            MEMFS.writePages(node, buffer, offset, length, position);
+            node.usedBytes = Math.max(node.usedBytes, position+length);
+            return length;
+          }
+          node.pages = null; // The given buffer replaces the whole file below.
+        }
+#endif
         if (buffer.subarray && (!node.contents || node.contents.subarray)) { // This write is from a typed array to a typed array?
           if (canOwn) { // Can we just reuse the buffer we are given?
 #if ASSERTIONS
@@ -299,6 +410,13 @@ mergeInto(LibraryManager.library, {
 
         // Appending to an existing file and we need to reallocate, or source data did not come as a typed array.
         MEMFS.expandFileStorage(node, position+length);
+#if MEMFS_PAGE_SIZE
+        if (node.pages) {
+          MEMFS.writePages(node, buffer, offset, length, position);
+          node.usedBytes = Math.max(node.usedBytes, position+length);
+          return length;
+        }
+#endif
         if (node.contents.subarray && buffer.subarray) node.contents.set(buffer.subarray(offset, offset + length), position); // Use typed array write if available.
         else {
           for (var i = 0; i < length; i++) {
@@ -334,13 +452,31 @@ mergeInto(LibraryManager.library, {
         var ptr;
         var allocated;
         var contents = stream.node.contents;
+#if MEMFS_PAGE_SIZE
+        if (stream.node.pages) {
+          // Paged files are never backed by the buffer being mapped to, so the pages are always copied.
+          ptr = _malloc(length);
+          if (!ptr) {
+            throw new FS.ErrnoError(ERRNO_CODES.ENOMEM);
+          }
+          MEMFS.readPages(stream.node, buffer, ptr, Math.max(0, Math.min(length, stream.node.usedBytes - position)), position);
+          return { ptr: ptr, allocated: true };
+        }
+#endif
+        var inBuffer = contents && (contents.buffer === buffer || contents.buffer === buffer.buffer);
         // Only make a new copy when MAP_PRIVATE is specified.
-        if ( !(flags & {{{ cDefine('MAP_PRIVATE') }}}) &&
-              (contents.buffer === buffer || contents.buffer === buffer.buffer) ) {
+        if ( !(flags & {{{ cDefine('MAP_PRIVATE') }}}) && inBuffer ) {
           // We can't emulate MAP_SHARED when the file is not backed by the buffer
           // we're mapping to (e.g. the HEAP buffer).
           allocated = false;
-          ptr = contents.byteOffset;
+          ptr = contents.byteOffset + position;
+        } else if (inBuffer && !(prot & {{{ cDefine('PROT_WRITE') }}}) && position + length <= stream.node.usedBytes &&
+                   (contents.byteOffset + position) % 8 == 0) {
+          // A read only private mapping can't change the file, so it can point directly at the file data, like the
+          // files preloaded into the heap by the file packager. Writable private mappings must get their own copy,
+          // as we can't detect the first write to them. The data must be aligned like a malloc()ed copy would be.
+          allocated = false;
+          ptr = contents.byteOffset + position;
         } else {
           // Try to avoid unnecessary slices.
           if (position > 0 || position + length < stream.node.usedBytes) {
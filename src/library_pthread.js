@@ -12,6 +12,20 @@ var LibraryPThread = {
     unusedWorkerPool: [],
     // The currently executing pthreads.
     runningWorkers: [],
+    // The number of workers that are still loading the compiled code, and the callbacks to run when they all have.
+    numWorkersLoading: 0,
+    poolReadyCallbacks: [],
+    // Counters reported by emscripten_pthread_pool_get_stats(). A pool hit is a thread started on an unused worker that
+    // had already loaded, a miss one that had to wait for a worker to be created or to finish loading. The start latency
+    // is the time from spawning a thread until its worker begins running it.
+    poolStats: {
+      hits: 0,
+      misses: 0,
+      workersCreated: 0,
+      threadsStarted: 0,
+      totalStartLatency: 0,
+      maxStartLatency: 0
+    },
     // Points to a pthread_t structure in the Emscripten main heap, allocated on demand if/when first needed.
     // mainThreadBlock: undefined,
     initMainThreadBlock: function() {
@@ -129,10 +143,23 @@ var LibraryPThread = {
       Module['print']('Preallocating ' + numWorkers + ' workers for a pthread spawn pool.');
 
       var numWorkersLoaded = 0;
+      // Called once for each worker of this batch, when it has loaded or when it was terminated before it did.
+      var workerDoneLoading = function() {
+        ++numWorkersLoaded;
+        if (numWorkersLoaded === numWorkers && onFinishedLoading) {
+          onFinishedLoading();
+        }
+        if (--PThread.numWorkersLoading == 0) PThread.runPoolReadyCallbacks();
+      };
+      PThread.numWorkersLoading += numWorkers;
+      PThread.poolStats.workersCreated += numWorkers;
       for (var i = 0; i < numWorkers; ++i) {
         var worker = new Worker('pthread-main.js');
+        worker.loaded = false;
+        worker.doneLoading = workerDoneLoading;
 
         worker.onmessage = function(e) {
+          var worker = e.target; // Not the loop variable, which refers to the last worker created by the time this runs.
           if (e.data.cmd === 'processQueuedMainThreadWork') {
             // TODO: Must post message to main Emscripten thread in PROXY_TO_WORKER mode.
             _emscripten_main_thread_process_queued_calls();
@@ -145,10 +172,13 @@ var LibraryPThread = {
           } else if (e.data.cmd === 'cancelThread') {
             __cancel_thread(e.data.thread);
           } else if (e.data.cmd === 'loaded') {
-            ++numWorkersLoaded;
-            if (numWorkersLoaded === numWorkers && onFinishedLoading) {
-              onFinishedLoading();
-            }
+            worker.loaded = true;
+            worker.doneLoading();
+          } else if (e.data.cmd === 'running') {
+            var stats = PThread.poolStats;
+            ++stats.threadsStarted;
+            stats.totalStartLatency += e.data.latency;
+            stats.maxStartLatency = Math.max(stats.maxStartLatency, e.data.latency);
           } else if (e.data.cmd === 'print') {
             Module['print']('Thread ' + e.data.threadId + ': ' + e.data.text);
           } else if (e.data.cmd === 'printErr') {
@@ -160,7 +190,7 @@ var LibraryPThread = {
               worker.pthread = undefined; // Detach the worker from the pthread object, and return it to the worker pool as an unused worker.
               PThread.unusedWorkerPool.push(worker);
               // TODO: Free if detached.
-              PThread.runningWorkers.splice(PThread.runningWorkers.indexOf(worker.pthread), 1); // Not a running Worker anymore.
+              PThread.runningWorkers.splice(PThread.runningWorkers.indexOf(worker), 1); // Not a running Worker anymore.
           } else {
             Module['printErr']("worker sent an unknown command " + e.data.cmd);
           }
@@ -187,11 +217,44 @@ var LibraryPThread = {
     },
 
     getNewWorker: function() {
+      // Prefer a worker that has already loaded, it can start running the thread right away.
+      for (var i = PThread.unusedWorkerPool.length - 1; i >= 0; --i) {
+        var worker = PThread.unusedWorkerPool[i];
+        if (worker.loaded) {
+          PThread.unusedWorkerPool.splice(i, 1);
+          ++PThread.poolStats.hits;
+          return worker;
+        }
+      }
+      ++PThread.poolStats.misses;
       if (PThread.unusedWorkerPool.length == 0) PThread.allocateUnusedWorkers(1);
-      if (PThread.unusedWorkerPool.length > 0) return PThread.unusedWorkerPool.pop();
+      if (PThread.unusedWorkerPool.length > 0) return PThread.unusedWorkerPool.shift(); // The oldest one is the furthest along loading.
       else return null;
     },
 
+    // Terminates unused workers until at most maxUnusedWorkers remain, the ones still loading first. Returns the number of
+    // workers terminated.
+    shrinkUnusedWorkers: function(maxUnusedWorkers) {
+      var pool = PThread.unusedWorkerPool;
+      var numTerminated = 0;
+      while (pool.length > maxUnusedWorkers) {
+        var i = 0;
+        while (i < pool.length && pool[i].loaded) ++i;
+        if (i == pool.length) i = 0;
+        var worker = pool.splice(i, 1)[0];
+        worker.terminate();
+        if (!worker.loaded) worker.doneLoading(); // Its batch would otherwise wait forever for it to load.
+        ++numTerminated;
+      }
+      return numTerminated;
+    },
+
+    runPoolReadyCallbacks: function() {
+      var callbacks = PThread.poolReadyCallbacks;
+      PThread.poolReadyCallbacks = [];
+      for (var i = 0; i < callbacks.length; ++i) callbacks[i]();
+    },
+
     busySpinWait: function(msecs) {
       var t = performance.now() + msecs;
       while(performance.now() < t) {
@@ -209,7 +272,7 @@ var LibraryPThread = {
     PThread.freeThreadData(pthread);
     // The worker was completely nuked (not just the pthread execution it was hosting), so remove it from running workers
     // but don't put it back to the pool.
-    PThread.runningWorkers.splice(PThread.runningWorkers.indexOf(pthread.worker.pthread), 1); // Not a running Worker anymore.
+    PThread.runningWorkers.splice(PThread.runningWorkers.indexOf(pthread.worker), 1); // Not a running Worker anymore.
     pthread.worker.pthread = undefined;
   },
 
@@ -222,7 +285,7 @@ var LibraryPThread = {
     PThread.freeThreadData(pthread);
     worker.pthread = undefined; // Detach the worker from the pthread object, and return it to the worker pool as an unused worker.
     PThread.unusedWorkerPool.push(worker);
-    PThread.runningWorkers.splice(PThread.runningWorkers.indexOf(worker.pthread), 1); // Not a running Worker anymore.
+    PThread.runningWorkers.splice(PThread.runningWorkers.indexOf(worker), 1); // Not a running Worker anymore.
   },
 
   _cancel_thread: function(pthread_ptr) {
@@ -280,10 +343,43 @@ var LibraryPThread = {
       threadInfoStruct: threadParams.pthread_ptr,
       selfThreadId: threadParams.pthread_ptr, // TODO: Remove this since thread ID is now the same as the thread address.
       stackBase: threadParams.stackBase,
-      stackSize: threadParams.stackSize
+      stackSize: threadParams.stackSize,
+      spawnTime: Date.now() // Wall clock time, the only clock that the worker shares with this thread.
     });
   },
 
+  emscripten_pthread_pool_prewarm: function(numWorkers) {
+    if (ENVIRONMENT_IS_PTHREAD || typeof SharedArrayBuffer === 'undefined') return 0;
+    if (numWorkers > 0) PThread.allocateUnusedWorkers(numWorkers);
+    return Math.max(numWorkers, 0);
+  },
+
+  emscripten_pthread_pool_when_ready: function(callback, userData) {
+    if (ENVIRONMENT_IS_PTHREAD) return;
+    var run = function() { Runtime.dynCall('vi', callback, [userData]); };
+    if (PThread.numWorkersLoading == 0) run();
+    else PThread.poolReadyCallbacks.push(run);
+  },
+
+  emscripten_pthread_pool_shrink: function(maxUnusedWorkers) {
+    if (ENVIRONMENT_IS_PTHREAD) return 0;
+    return PThread.shrinkUnusedWorkers(Math.max(maxUnusedWorkers, 0));
+  },
+
+  emscripten_pthread_pool_get_stats: function(stats) {
+    // The pool is only managed on the main thread, in pthreads this reports all zeroes.
+    var s = PThread.poolStats;
+    {{{ makeSetValue('stats', C_STRUCTS.emscripten_pthread_pool_stats.numUnusedWorkers, 'PThread.unusedWorkerPool.length', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.emscripten_pthread_pool_stats.numLoadingWorkers, 'PThread.numWorkersLoading', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.emscripten_pthread_pool_stats.numRunningWorkers, 'PThread.runningWorkers.length', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.emscripten_pthread_pool_stats.workersCreated, 's.workersCreated', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.emscripten_pthread_pool_stats.hits, 's.hits', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.emscripten_pthread_pool_stats.misses, 's.misses', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.emscripten_pthread_pool_stats.threadsStarted, 's.threadsStarted', 'i32') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.emscripten_pthread_pool_stats.averageStartLatencyMsecs, '(s.threadsStarted ? s.totalStartLatency / s.threadsStarted : 0)', 'double') }}};
+    {{{ makeSetValue('stats', C_STRUCTS.emscripten_pthread_pool_stats.maxStartLatencyMsecs, 's.maxStartLatency', 'double') }}};
+  },
+
 #if USE_PTHREADS
   _num_logical_cores__deps: ['emscripten_force_num_logical_cores'],
   _num_logical_cores: '; if (ENVIRONMENT_IS_PTHREAD) __num_logical_cores = PthreadWorkerInit.__num_logical_cores; else { PthreadWorkerInit.__num_logical_cores = __num_logical_cores = allocate(1, "i32*", ALLOC_STATIC); HEAPU32[__num_logical_cores>>2] = navigator["hardwareConcurrency"] || ' + {{{ PTHREAD_HINT_NUM_CORES }}} + '; }',
@@ -655,7 +751,7 @@ var LibraryPThread = {
 
   // Returns 0 on success, or one of the values -ETIMEDOUT, -EWOULDBLOCK or -EINVAL on error.
   emscripten_futex_wait: function(addr, val, timeout) {
-    if (addr <= 0 || addr > HEAP8.length || addr&3 != 0) return -{{{ cDefine('EINVAL') }}};
+    if (addr <= 0 || addr > HEAP8.length || (addr&3) != 0) return -{{{ cDefine('EINVAL') }}};
 //    dump('futex_wait addr:' + addr + ' by thread: ' + _pthread_self() + (ENVIRONMENT_IS_PTHREAD?'(pthread)':'') + '\n');
     var ret = Atomics.futexWait(HEAP32, addr >> 2, val, timeout);
 //    dump('futex_wait done by thread: ' + _pthread_self() + (ENVIRONMENT_IS_PTHREAD?'(pthread)':'') + '\n');
@@ -668,20 +764,21 @@ var LibraryPThread = {
   // Returns the number of threads (>= 0) woken up, or the value -EINVAL on error.
   // Pass count == INT_MAX to wake up all threads.
   emscripten_futex_wake: function(addr, count) {
-    if (addr <= 0 || addr > HEAP8.length || addr&3 != 0 || count < 0) return -{{{ cDefine('EINVAL') }}};
+    if (addr <= 0 || addr > HEAP8.length || (addr&3) != 0 || count < 0) return -{{{ cDefine('EINVAL') }}};
 //    dump('futex_wake addr:' + addr + ' by thread: ' + _pthread_self() + (ENVIRONMENT_IS_PTHREAD?'(pthread)':'') + '\n');
     var ret = Atomics.futexWake(HEAP32, addr >> 2, count);
     if (ret >= 0) return ret;
     throw 'Atomics.futexWake returned an unexpected value ' + ret;
   },
 
-  // Returns the number of threads (>= 0) woken up, or one of the values -EINVAL or -EAGAIN on error.
+  // Wakes up to count threads waiting on addr and moves the rest of them to wait on addr2 instead, if the value at addr
+  // is still cmpValue. Returns the number of threads (>= 0) woken up, or one of the values -EINVAL or -EAGAIN on error.
   emscripten_futex_wake_or_requeue: function(addr, count, cmpValue, addr2) {
     if (addr <= 0 || addr2 <= 0 || addr >= HEAP8.length || addr2 >= HEAP8.length || count < 0
-      || addr&3 != 0 || addr2&3 != 0) {
+      || (addr&3) != 0 || (addr2&3) != 0) {
       return -{{{ cDefine('EINVAL') }}};
     }
-    var ret = Atomics.futexWakeOrRequeue(HEAP32, addr >> 2, count, cmpValue, addr >> 2);
+    var ret = Atomics.futexWakeOrRequeue(HEAP32, addr >> 2, count, cmpValue, addr2 >> 2);
     if (ret == Atomics.NOTEQUAL) return -{{{ cDefine('EAGAIN') }}};
     if (ret >= 0) return ret;
     throw 'Atomics.futexWakeOrRequeue returned an unexpected value ' + ret;
@@ -27,6 +27,25 @@ var LibraryPThreadStub = {
     // We will never have any queued calls to process, so no-op.
   },
 
+  emscripten_pthread_pool_prewarm: function(numWorkers) {
+    return 0;
+  },
+
+  emscripten_pthread_pool_when_ready: function(callback, userData) {
+    // There are no workers to wait for.
+    Runtime.dynCall('vi', callback, [userData]);
+  },
+
+  emscripten_pthread_pool_shrink: function(maxUnusedWorkers) {
+    return 0;
+  },
+
+  emscripten_pthread_pool_get_stats: function(stats) {
+    for (var i = 0; i < {{{ C_STRUCTS.emscripten_pthread_pool_stats.__size__ }}}; i += 4) {
+      {{{ makeSetValue('stats', 'i', 0, 'i32') }}};
+    }
+  },
+
   pthread_mutex_init: function() {},
   pthread_mutex_destroy: function() {},
   pthread_mutexattr_init: function() {},
@@ -64,9 +64,9 @@ var SyscallsLibrary = {
       {{{ makeSetValue('buf', C_STRUCTS.stat.st_ino, 'stat.ino', 'i32') }}};
       return 0;
     },
-    doMsync: function(addr, stream, len, flags) {
+    doMsync: function(addr, stream, len, flags, offset) {
       var buffer = new Uint8Array(HEAPU8.subarray(addr, addr + len));
-      FS.msync(stream, buffer, 0, len, flags);
+      FS.msync(stream, buffer, offset, len, flags);
     },
     doMkdir: function(path, mode) {
       // remove a trailing slash, if one - /a/b/ has basename of '', but
@@ -390,7 +390,8 @@ var SyscallsLibrary = {
     if (!info) return 0;
     if (len === info.len) {
       var stream = FS.getStream(info.fd);
-      SYSCALLS.doMsync(addr, stream, len, info.flags)
+      // a mapping that was not allocated points directly at the file data, so there is nothing to write back
+      if (info.allocated) SYSCALLS.doMsync(addr, stream, len, info.flags, info.offset);
       FS.munmap(stream);
       SYSCALLS.mappings[addr] = null;
       if (info.allocated) {
@@ -733,13 +734,16 @@ var SyscallsLibrary = {
     var addr = SYSCALLS.get(), len = SYSCALLS.get(), flags = SYSCALLS.get();
     var info = SYSCALLS.mappings[addr];
     if (!info) return 0;
-    SYSCALLS.doMsync(addr, FS.getStream(info.fd), len, info.flags);
+    if (info.allocated) SYSCALLS.doMsync(addr, FS.getStream(info.fd), len, info.flags, info.offset);
     return 0;
   },
   __syscall145: function(which, varargs) { // readv
     var stream = SYSCALLS.getStreamFromFD(), iov = SYSCALLS.get(), iovcnt = SYSCALLS.get();
     return SYSCALLS.doReadv(stream, iov, iovcnt);
   },
+#if NO_FILESYSTEM
+  __syscall146__deps: ['$UTF8LineToString'],
+#endif
   __syscall146: function(which, varargs) { // writev
 #if NO_FILESYSTEM == 0
     var stream = SYSCALLS.getStreamFromFD(), iov = SYSCALLS.get(), iovcnt = SYSCALLS.get();
@@ -749,19 +753,35 @@ var SyscallsLibrary = {
     var stream = SYSCALLS.get(), iov = SYSCALLS.get(), iovcnt = SYSCALLS.get();
     var ret = 0;
     if (!___syscall146.buffer) ___syscall146.buffer = [];
-    var buffer = ___syscall146.buffer;
+    var buffer = ___syscall146.buffer; // the start of a line that is not ended yet
     for (var i = 0; i < iovcnt; i++) {
       var ptr = {{{ makeGetValue('iov', 'i*8', 'i32') }}};
       var len = {{{ makeGetValue('iov', 'i*8 + 4', 'i32') }}};
-      for (var j = 0; j < len; j++) {
-        var curr = HEAPU8[ptr+j];
+#if NODE_STDIO_PASSTHROUGH
+      if (ENVIRONMENT_IS_NODE) {
+        // copy the bytes, as node may write them out after the heap has changed
+        var bytes = HEAPU8.subarray(ptr, ptr + len);
+        process[stream === 2 ? 'stderr' : 'stdout']['write'](Buffer['from'] ? Buffer['from'](bytes) : new Buffer(bytes));
+        ret += len;
+        continue;
+      }
+#endif
+      // print each line in the block, decoding it as a whole
+      var start = ptr, end = ptr + len;
+      for (var j = ptr; j < end; j++) {
+        var curr = HEAPU8[j];
         if (curr === 0 || curr === {{{ charCode('\n') }}}) {
-          Module['print'](UTF8ArrayToString(buffer, 0));
-          buffer.length = 0;
-        } else {
-          buffer.push(curr);
+          if (buffer.length) {
+            for (var k = start; k < j; k++) buffer.push(HEAPU8[k]);
+            Module['print'](UTF8LineToString(buffer));
+            buffer.length = 0;
+          } else {
+            Module['print'](UTF8LineToString(HEAPU8.subarray(start, j)));
+          }
+          start = j + 1;
         }
       }
+      for (var k = start; k < end; k++) buffer.push(HEAPU8[k]);
       ret += len;
     }
     return ret;
@@ -854,7 +874,7 @@ var SyscallsLibrary = {
       ptr = res.ptr;
       allocated = res.allocated;
     }
-    SYSCALLS.mappings[ptr] = { malloc: ptr, len: len, allocated: allocated, fd: fd, flags: flags };
+    SYSCALLS.mappings[ptr] = { malloc: ptr, len: len, allocated: allocated, fd: fd, flags: flags, offset: off };
     return ptr;
   },
   __syscall193: function(which, varargs) { // truncate64
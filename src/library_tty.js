@@ -1,5 +1,5 @@
 mergeInto(LibraryManager.library, {
-  $TTY__deps: ['$FS'],
+  $TTY__deps: ['$FS', '$UTF8LineToString'],
   $TTY__postset: '__ATINIT__.unshift(function() { TTY.init() });' +
                  '__ATEXIT__.push(function() { TTY.shutdown() });',
   $TTY: {
@@ -25,6 +25,31 @@ mergeInto(LibraryManager.library, {
       //   process['stdin']['pause']();
       // }
     },
+    // Prints the lines in bytes, a Uint8Array, decoding each as a block. The start of a line that is not ended yet is
+    // kept in tty.output for the next write.
+    printLines: function(tty, bytes, print) {
+      var start = 0;
+      for (var i = 0; i < bytes.length; i++) {
+        var curr = bytes[i];
+        if (curr === {{{ charCode('\n') }}}) {
+          if (tty.output.length) {
+            TTY.appendOutput(tty, bytes, start, i);
+            print(UTF8LineToString(tty.output));
+            tty.output = [];
+          } else {
+            print(UTF8LineToString(bytes.subarray(start, i)));
+          }
+          start = i + 1;
+        } else if (curr === 0) {
+          TTY.appendOutput(tty, bytes, start, i); // a zero would cut text output off in the middle, skip it
+          start = i + 1;
+        }
+      }
+      TTY.appendOutput(tty, bytes, start, bytes.length);
+    },
+    appendOutput: function(tty, bytes, start, end) {
+      for (var i = start; i < end; i++) tty.output.push(bytes[i]);
+    },
     register: function(dev, ops) {
       TTY.ttys[dev] = { input: [], output: [], ops: ops };
       FS.registerDevice(dev, TTY.stream_ops);
@@ -73,6 +98,18 @@ mergeInto(LibraryManager.library, {
         if (!stream.tty || !stream.tty.ops.put_char) {
           throw new FS.ErrnoError(ERRNO_CODES.ENXIO);
         }
+        if (stream.tty.ops.put_chars && buffer.buffer) {
+          // hand the whole block to the tty at once
+          try {
+            stream.tty.ops.put_chars(stream.tty, new Uint8Array(buffer.buffer, buffer.byteOffset + offset, length));
+          } catch (e) {
+            throw new FS.ErrnoError(ERRNO_CODES.EIO);
+          }
+          if (length) {
+            stream.node.timestamp = Date.now();
+          }
+          return length;
+        }
         for (var i = 0; i < length; i++) {
           try {
             stream.tty.ops.put_char(stream.tty, buffer[offset+i]);
@@ -140,15 +177,25 @@ mergeInto(LibraryManager.library, {
       },
       put_char: function(tty, val) {
         if (val === null || val === {{{ charCode('\n') }}}) {
-          Module['print'](UTF8ArrayToString(tty.output, 0));
+          Module['print'](UTF8LineToString(tty.output));
           tty.output = [];
         } else {
           if (val != 0) tty.output.push(val); // val == 0 would cut text output off in the middle.
         }
       },
+      put_chars: function(tty, bytes) {
+#if NODE_STDIO_PASSTHROUGH
+        if (ENVIRONMENT_IS_NODE) {
+          // copy the bytes, as node may write them out after the heap has changed
+          process['stdout']['write'](Buffer['from'] ? Buffer['from'](bytes) : new Buffer(bytes));
+          return;
+        }
+#endif
+        TTY.printLines(tty, bytes, Module['print']);
+      },
       flush: function(tty) {
         if (tty.output && tty.output.length > 0) {
-          Module['print'](UTF8ArrayToString(tty.output, 0));
+          Module['print'](UTF8LineToString(tty.output));
           tty.output = [];
         }
       }
@@ -156,15 +203,24 @@ mergeInto(LibraryManager.library, {
     default_tty1_ops: {
       put_char: function(tty, val) {
         if (val === null || val === {{{ charCode('\n') }}}) {
-          Module['printErr'](UTF8ArrayToString(tty.output, 0));
+          Module['printErr'](UTF8LineToString(tty.output));
           tty.output = [];
         } else {
           if (val != 0) tty.output.push(val);
         }
       },
+      put_chars: function(tty, bytes) {
+#if NODE_STDIO_PASSTHROUGH
+        if (ENVIRONMENT_IS_NODE) {
+          process['stderr']['write'](Buffer['from'] ? Buffer['from'](bytes) : new Buffer(bytes));
+          return;
+        }
+#endif
+        TTY.printLines(tty, bytes, Module['printErr']);
+      },
       flush: function(tty) {
         if (tty.output && tty.output.length > 0) {
-          Module['printErr'](UTF8ArrayToString(tty.output, 0));
+          Module['printErr'](UTF8LineToString(tty.output));
           tty.output = [];
         }
       }
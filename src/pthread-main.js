@@ -50,6 +50,7 @@ this.onmessage = function(e) {
     FS.createStandardStreams();
     postMessage({ cmd: 'loaded' });
   } else if (e.data.cmd === 'run') { // This worker was idle, and now should start executing its pthread entry point.
+    postMessage({ cmd: 'running', latency: Date.now() - e.data.spawnTime }); // For the thread start latency statistics.
     threadInfoStruct = e.data.threadInfoStruct;
     assert(threadInfoStruct);
     selfThreadId = e.data.selfThreadId;
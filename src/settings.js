@@ -67,6 +67,13 @@ var ALLOW_MEMORY_GROWTH = 0; // If false, we abort with an error if we try to al
                              // ALLOW_MEMORY_GROWTH enables fully standard behavior, of both malloc
                              // returning 0 when it fails, and also of being able to allocate more
                              // memory from the system as necessary.
+var MALLOC = "dlmalloc"; // Which malloc implementation to link in:
+                         //   "dlmalloc": dlmalloc (system/lib/dlmalloc.c).
+                         //   "slab": dlmalloc with size-segregated slabs in front of it for allocations
+                         //           of up to 128 bytes (system/lib/slab_malloc.c). Small objects then
+                         //           have no per-object header and are packed together by size, which
+                         //           helps programs that allocate many small objects (e.g. std::map and
+                         //           std::list nodes). Not supported with SPLIT_MEMORY or EMSCRIPTEN_TRACING.
 
 var GLOBAL_BASE = -1; // where global data begins; the start of static memory. -1 means use the
                       // default, any other value will be used as an override
@@ -234,6 +241,17 @@ var GL_ASSERTIONS = 0; // Adds extra checks for error situations in the GL libra
 var GL_DEBUG = 0; // Print out all calls into WebGL. As with LIBRARY_DEBUG, you can set a runtime
                   // option, in this case GL.debug.
 var GL_TESTING = 0; // When enabled, sets preserveDrawingBuffer in the context, to allow tests to work (but adds overhead)
+var GL_STATE_CACHE = 0; // Keeps a shadow copy of the most commonly changed GL state (enabled caps, buffer bindings,
+                        // the current program and uniform values) per context, and skips calls to WebGL that would
+                        // not change that state. Redundant state changes are not free in WebGL, since each call is
+                        // validated by the browser before it reaches the driver. Issued and filtered call counts are
+                        // available from emscripten_webgl_get_state_cache_stats(). If you call into WebGL directly
+                        // from JS, call emscripten_webgl_invalidate_state_cache() afterwards.
+                        // Not supported together with LEGACY_GL_EMULATION or FULL_ES2, since those change the same
+                        // state behind the back of the cache.
+var GL_PROFILE = 0; // Counts the calls to each GL function, the time spent in them and the bytes they upload to the
+                    // GPU, per frame. See emscripten/gl_profile.h for how to read the statistics. Adds a little
+                    // overhead to every GL call.
 var GL_MAX_TEMP_BUFFER_SIZE = 2097152; // How large GL emulation temp buffers are
 var GL_UNSAFE_OPTS = 1; // Enables some potentially-unsafe optimizations in GL emulation code
 var FULL_ES2 = 0;   // Forces support for all GLES2 features, not just the WebGL-friendly subset.
@@ -264,6 +282,13 @@ var LZ4 = 0; // Enable this to support lz4-compressed file packages. They are st
              //     for special preloading operations like pre-decoding of images using browser codecs,
              //     preloadPlugin stuff, etc.
              //   * LZ4 files are read-only.
+var LZ4_CACHE_CHUNKS = 32; // With LZ4, how many decompressed chunks (of 2048 bytes each) are kept in memory for
+                          // each package. Reads of chunks that are not in the cache decompress them again, so
+                          // raise this if your application reads many different parts of its files repeatedly.
+                          // Statistics on how well the cache works are in LZ4.stats.
+var LZ4_WORKER = 0; // With LZ4, decompress the chunks that are read ahead of sequential reads in a Web Worker
+                    // instead of on the main thread. Reads themselves are synchronous, so chunks they need
+                    // that are not in the cache yet are still decompressed on the main thread.
 
 var DISABLE_EXCEPTION_CATCHING = 0; // Disables generating code to actually catch exceptions. If the code you
                                     // are compiling does not actually rely on catching exceptions (but the
@@ -359,6 +384,11 @@ var MEMFS_APPEND_TO_TYPED_ARRAYS = 0; // If set to nonzero, MEMFS will always ut
                                       // for appending data to files. The default behavior is to use typed arrays for files
                                       // when the file size doesn't change after initial creation, and for files that do
                                       // change size, use normal JS arrays instead.
+var MEMFS_PAGE_SIZE = 0; // If set to nonzero, MEMFS files that grow larger than this many bytes are stored as a list
+                        // of pages of this size, allocated as they are written to. Appending to such a file never
+                        // copies the data that is already in it. The file data is gathered into a single typed array
+                        // only when something needs it in one piece, like IDBFS syncing. Overrides
+                        // MEMFS_APPEND_TO_TYPED_ARRAYS for files that large.
 var NO_FILESYSTEM = 0; // If set, does not build in any filesystem support. Useful if you are just doing pure
                        // computation, but not reading files or using any streams (including fprintf, and other
                        // stdio.h things) or anything related. The one exception is there is partial support for printf,
@@ -369,6 +399,11 @@ var NO_BROWSER = 0; // If set, disables building in browser support using the Br
 
 var NODE_STDOUT_FLUSH_WORKAROUND = 1; // Whether or not to work around node issues with not flushing stdout. This
                                       // can cause unnecessary whitespace to be printed.
+var NODE_STDIO_PASSTHROUGH = 0; // Under node, write the bytes written to stdout and stderr directly to
+                                // process.stdout and process.stderr, instead of decoding them into lines
+                                // for Module.print and Module.printErr. This is faster for programs that log
+                                // a lot, but any Module.print and Module.printErr you define are not used
+                                // for that output.
 
 var EXPORTED_FUNCTIONS = ['_main', '_malloc'];
                                     // Functions that are explicitly exported. These functions are kept alive
@@ -649,6 +684,17 @@ var PTHREAD_POOL_SIZE = 0; // Specifies the number of web workers that are preal
 // to show a popup dialog at startup so the user can configure this dynamically.
 var PTHREAD_HINT_NUM_CORES = 4;
 
+// If true, malloc() and free() keep per-thread caches of small chunks in front of the dlmalloc heap, so that threads
+// allocating and freeing small objects do not serialize on the heap lock. Chunks move between the caches and the heap
+// in batches. Only has an effect with USE_PTHREADS, and is ignored with EMSCRIPTEN_TRACING.
+var MALLOC_THREAD_CACHE = 0;
+
+// If true, malloc() samples allocations, about one per 512KB allocated by default, and records them with their
+// callstacks, so that a heap profile can be written with emscripten_heap_profiler_dump() (see
+// emscripten/trace.h). Build with --profiling-funcs to get readable function names. Takes precedence over
+// MALLOC and MALLOC_THREAD_CACHE, and is ignored with EMSCRIPTEN_TRACING and SPLIT_MEMORY.
+var HEAP_PROFILER = 0;
+
 var MAX_GLOBAL_ALIGN = -1; // received from the backend
 
 // Reserved: variables containing POINTER_MASKING.
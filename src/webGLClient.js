@@ -8,263 +8,157 @@ function WebGLClient() {
   var objects = {};
 
   var ctx = null;
-  var buffer = null;
+  var ints = null; // the command stream, see webGLWorker.js
+  var floats = null;
+  var data = null; // the strings and data arrays the stream refers to
   var i = 0;
   var skippable = false;
   var currFrameBuffer = null;
 
-  function func0(name) {
-    ctx[name]();
+  // argument decoders
+  function object() {
+    return objects[ints[i++]];
   }
-  function func1(name) {
-    ctx[name](buffer[i]);
-    i++;
+  function objectOrNull() {
+    var id = ints[i++];
+    return id ? objects[id] : null;
   }
-  function func2(name) {
-    ctx[name](buffer[i], buffer[i+1]);
-    i += 2;
+  function datum() {
+    return data[ints[i++]];
   }
-  function func3(name) {
-    ctx[name](buffer[i], buffer[i+1], buffer[i+2]);
-    i += 3;
+  function floatArray() {
+    var n = ints[i++];
+    var array = floats.subarray(i, i + n);
+    i += n;
+    return array;
   }
-  function func4(name) {
-    ctx[name](buffer[i], buffer[i+1], buffer[i+2], buffer[i+3]);
-    i += 4;
+  function intArray() {
+    var n = ints[i++];
+    var array = Array.prototype.slice.call(ints.subarray(i, i + n));
+    i += n;
+    return array;
   }
-  function func5(name) {
-    ctx[name](buffer[i], buffer[i+1], buffer[i+2], buffer[i+3], buffer[i+4]);
-    i += 5;
+  // constructors save the object under the id that follows the arguments, destructors stop holding on to it
+  function create(object) {
+    objects[ints[i++]] = object;
   }
-  function func6(name) {
-    ctx[name](buffer[i], buffer[i+1], buffer[i+2], buffer[i+3], buffer[i+4], buffer[i+5]);
-    i += 6;
-  }
-  function func7(name) {
-    ctx[name](buffer[i], buffer[i+1], buffer[i+2], buffer[i+3], buffer[i+4], buffer[i+5], buffer[i+6]);
-    i += 7;
-  }
-  function func9(name) {
-    ctx[name](buffer[i], buffer[i+1], buffer[i+2], buffer[i+3], buffer[i+4], buffer[i+5], buffer[i+6], buffer[i+7], buffer[i+8]);
-    i += 9;
-  }
-
-  // lookuppers, convert integer ids to cached objects for some args
-  function func1L0(name) {
-    ctx[name](objects[buffer[i]]);
-    i++;
-  }
-  function func2L0(name) {
-    ctx[name](objects[buffer[i]], buffer[i+1]);
-    i += 2;
-  }
-  function func2L0L1(name) {
-    ctx[name](objects[buffer[i]], objects[buffer[i+1]]);
-    i += 2;
-  }
-  function func2L1_(name) {
-    ctx[name](buffer[i], buffer[i+1] ? objects[buffer[i+1]] : null);
-    i += 2;
-  }
-  function func3L0(name) {
-    ctx[name](objects[buffer[i]], buffer[i+1], buffer[i+2]);
-    i += 3;
-  }
-  function func4L3_(name) {
-    ctx[name](buffer[i], buffer[i+1], buffer[i+2], buffer[i+3] ? objects[buffer[i+3]] : null);
-    i += 4;
-  }
-  function func5L3_(name) {
-    ctx[name](buffer[i], buffer[i+1], buffer[i+2], buffer[i+3] ? objects[buffer[i+3]] : null, buffer[i+4]);
-    i += 5;
-  }
-
-  // constructors, last argument is the id to save as
-  function funcC0(name) {
-    var object = ctx[name]();
-    var id = buffer[i++];
-    objects[id] = object;
-  }
-  function funcC1(name) {
-    var object = ctx[name](buffer[i++]);
-    var id = buffer[i++];
-    objects[id] = object;
-  }
-  function funcC2(name) {
-    var object = ctx[name](buffer[i++], buffer[i++]);
-    var id = buffer[i++];
-    objects[id] = object;
-  }
-  function funcC2L0(name) {
-    var object = ctx[name](objects[buffer[i++]], buffer[i++]);
-    var id = buffer[i++];
-    objects[id] = object;
-  }
-
-  // destructors, stop holding on to the object in the cache
-  function funcD0(name) {
-    var id = buffer[i++];
+  function release() {
+    var id = ints[i++];
     var object = objects[id];
     objects[id] = null;
-    ctx[name](object);
+    return object;
   }
 
-  // special cases/optimizations
-  function bindFramebuffer() {
-    currFrameBuffer = buffer[i+1] ? objects[buffer[i+1]] : null;
-    ctx.bindFramebuffer(buffer[i], currFrameBuffer);
-    i += 2;
-  }
-  function drawArrays(name) {
-    if (!skippable || currFrameBuffer !== null) {
-      ctx.drawArrays(buffer[i], buffer[i+1], buffer[i+2]);
-    }
-    i += 3;
-  }
-  function drawElements(name) {
-    if (!skippable || currFrameBuffer !== null) {
-      ctx.drawElements(buffer[i], buffer[i+1], buffer[i+2], buffer[i+3]);
-    }
-    i += 4;
-  }
-  function enable() {
-    ctx.enable(buffer[i++]);
-  }
-  function disable() {
-    ctx.disable(buffer[i++]);
-  }
-  function enableVertexAttribArray() {
-    ctx.enableVertexAttribArray(buffer[i++]);
-  }
-  function disableVertexAttribArray() {
-    ctx.disableVertexAttribArray(buffer[i++]);
-  }
-  function activeTexture() {
-    ctx.activeTexture(buffer[i++]);
-  }
-  function uniform1i() {
-    ctx.uniform1i(objects[buffer[i]], buffer[i+1]);
-    i += 2;
-  }
-  function uniform1f() {
-    ctx.uniform1f(objects[buffer[i]], buffer[i+1]);
-    i += 2;
-  }
-  function uniform2fv() {
-    ctx.uniform2fv(objects[buffer[i]], buffer[i+1]);
-    i += 2;
-  }
-  function uniform3f() {
-    ctx.uniform3f(objects[buffer[i]], buffer[i+1], buffer[i+2], buffer[i+3]);
-    i += 4;
-  }
-  function uniform3fv() {
-    ctx.uniform3fv(objects[buffer[i]], buffer[i+1]);
-    i += 2;
-  }
-  function uniform4fv() {
-    ctx.uniform4fv(objects[buffer[i]], buffer[i+1]);
-    i += 2;
-  }
-  function vertexAttribPointer() {
-    ctx.vertexAttribPointer(buffer[i], buffer[i+1], buffer[i+2], buffer[i+3], buffer[i+4], buffer[i+5]);
-    i += 6;
-  }
-
-  var calls = {
-    0: { name: 'NULL', func: func0 },
-    1: { name: 'getExtension', func: func1 },
-    2: { name: 'enable', func: enable },
-    3: { name: 'disable', func: disable },
-    4: { name: 'clear', func: func1 },
-    5: { name: 'clearColor', func: func4 },
-    6: { name: 'createShader', func: funcC1 },
-    7: { name: 'deleteShader', func: funcD0 },
-    8: { name: 'shaderSource', func: func2L0 },
-    9: { name: 'compileShader', func: func1L0 },
-    10: { name: 'createProgram', func: funcC0 },
-    11: { name: 'deleteProgram', func: funcD0 },
-    12: { name: 'attachShader', func: func2L0L1 },
-    13: { name: 'bindAttribLocation', func: func3L0 },
-    14: { name: 'linkProgram', func: func1L0 },
-    15: { name: 'getProgramParameter', func: function() { assert(ctx.getProgramParameter(objects[buffer[i++]], buffer[i++]), 'we cannot handle errors, we are async proxied WebGL'); } },
-    16: { name: 'getUniformLocation', func: funcC2L0 },
-    17: { name: 'useProgram', func: func1L0 },
-    18: { name: 'uniform1i', func: uniform1i },
-    19: { name: 'uniform1f', func: uniform1f },
-    20: { name: 'uniform3fv', func: uniform3fv },
-    21: { name: 'uniform4fv', func: uniform4fv },
-    22: { name: 'uniformMatrix4fv', func: func3L0 },
-    23: { name: 'vertexAttrib4fv', func: func2 },
-    24: { name: 'createBuffer', func: funcC0 },
-    25: { name: 'deleteBuffer', func: funcD0 },
-    26: { name: 'bindBuffer', func: func2L1_ },
-    27: { name: 'bufferData', func: func3 },
-    28: { name: 'bufferSubData', func: func3 },
-    29: { name: 'viewport', func: func4 },
-    30: { name: 'vertexAttribPointer', func: vertexAttribPointer },
-    31: { name: 'enableVertexAttribArray', func: enableVertexAttribArray },
-    32: { name: 'disableVertexAttribArray', func: disableVertexAttribArray },
-    33: { name: 'drawArrays', func: drawArrays },
-    34: { name: 'drawElements', func: drawElements },
-    35: { name: 'getError', func: function() { assert(ctx.getError() === ctx.NO_ERROR, 'we cannot handle errors, we are async proxied WebGL') } },
-    36: { name: 'createTexture', func: funcC0 },
-    37: { name: 'deleteTexture', func: funcD0 },
-    38: { name: 'bindTexture', func: func2L1_ },
-    39: { name: 'texParameteri', func: func3 },
-    40: { name: 'texImage2D', func: func9 },
-    41: { name: 'compressedTexImage2D', func: func7 },
-    42: { name: 'activeTexture', func: activeTexture },
-    43: { name: 'getShaderParameter', func: function() { assert(ctx.getShaderParameter(objects[buffer[i++]], buffer[i++]), 'we cannot handle errors, we are async proxied WebGL'); } },
-    44: { name: 'clearDepth', func: func1 },
-    45: { name: 'depthFunc', func: func1 },
-    46: { name: 'frontFace', func: func1 },
-    47: { name: 'cullFace', func: func1 },
-    48: { name: 'pixelStorei', func: func2 },
-    49: { name: 'depthMask', func: func1 },
-    50: { name: 'depthRange', func: func2 },
-    51: { name: 'blendFunc', func: func2 },
-    52: { name: 'scissor', func: func4 },
-    53: { name: 'colorMask', func: func4 },
-    54: { name: 'lineWidth', func: func1 },
-    55: { name: 'createFramebuffer', func: funcC0 },
-    56: { name: 'deleteFramebuffer', func: funcD0 },
-    57: { name: 'bindFramebuffer', func: bindFramebuffer },
-    58: { name: 'framebufferTexture2D', func: func5L3_ },
-    59: { name: 'createRenderbuffer', func: funcC0 },
-    60: { name: 'deleteRenderbuffer', func: funcD0 },
-    61: { name: 'bindRenderbuffer', func: func2L1_ },
-    62: { name: 'renderbufferStorage', func: func4 },
-    63: { name: 'framebufferRenderbuffer', func: func4L3_ },
-    64: { name: 'debugPrint', func: func1 },
-    65: { name: 'hint', func: func2 },
-    66: { name: 'blendEquation', func: func1 },
-    67: { name: 'generateMipmap', func: func1 },
-    68: { name: 'uniformMatrix3fv', func: func3L0 },
-    69: { name: 'stencilMask', func: func1 },
-    70: { name: 'clearStencil', func: func1 },
-    71: { name: 'texSubImage2D', func: func9 },
-    72: { name: 'uniform3f', func: uniform3f },
-    73: { name: 'blendFuncSeparate', func: func4 },
-    74: { name: 'uniform2fv', func: uniform2fv },
-    75: { name: 'texParameterf', func: func3 },
-    76: { name: 'isContextLost', func: function() { assert(!ctx.isContextLost(), 'context lost which we cannot handle, we are async proxied WebGL') } },
-    77: { name: 'blendEquationSeparate', func: func2 },
-    78: { name: 'stencilFuncSeparate', func: func4 },
-    79: { name: 'stencilOpSeparate', func: func4 },
-    80: { name: 'drawBuffersWEBGL', func: func1 },
-  };
-
-  function renderCommands(buf) {
+  function renderCommands(msg) {
     ctx = Module.ctx;
+    ints = new Int32Array(msg.commandBuffer, 0, msg.length);
+    floats = new Float32Array(msg.commandBuffer, 0, msg.length);
+    data = msg.objects;
     i = 0;
-    buffer = buf;
-    var len = buffer.length;
+    var len = msg.length;
     //dump('issuing commands, buffer len: ' + len + '\n');
     while (i < len) {
-      var info = calls[buffer[i++]];
-      var name = info.name;
-      info.func(name);
+      switch (ints[i++]) {
+        case 0: break; // NULL
+        case 1: ctx.getExtension(datum()); break;
+        case 2: ctx.enable(ints[i++]); break;
+        case 3: ctx.disable(ints[i++]); break;
+        case 4: ctx.clear(ints[i++]); break;
+        case 5: ctx.clearColor(floats[i++], floats[i++], floats[i++], floats[i++]); break;
+        case 6: create(ctx.createShader(ints[i++])); break;
+        case 7: ctx.deleteShader(release()); break;
+        case 8: ctx.shaderSource(object(), datum()); break;
+        case 9: ctx.compileShader(object()); break;
+        case 10: create(ctx.createProgram()); break;
+        case 11: ctx.deleteProgram(release()); break;
+        case 12: ctx.attachShader(object(), object()); break;
+        case 13: ctx.bindAttribLocation(object(), ints[i++], datum()); break;
+        case 14: ctx.linkProgram(object()); break;
+        case 15: assert(ctx.getProgramParameter(object(), ints[i++]), 'we cannot handle errors, we are async proxied WebGL'); break;
+        case 16: create(ctx.getUniformLocation(object(), datum())); break;
+        case 17: ctx.useProgram(object()); break;
+        case 18: ctx.uniform1i(object(), ints[i++]); break;
+        case 19: ctx.uniform1f(object(), floats[i++]); break;
+        case 20: ctx.uniform3fv(object(), floatArray()); break;
+        case 21: ctx.uniform4fv(object(), floatArray()); break;
+        case 22: ctx.uniformMatrix4fv(object(), ints[i++], floatArray()); break;
+        case 23: ctx.vertexAttrib4fv(ints[i++], floatArray()); break;
+        case 24: create(ctx.createBuffer()); break;
+        case 25: ctx.deleteBuffer(release()); break;
+        case 26: ctx.bindBuffer(ints[i++], objectOrNull()); break;
+        case 27: ctx.bufferData(ints[i++], datum(), ints[i++]); break;
+        case 28: ctx.bufferSubData(ints[i++], ints[i++], datum()); break;
+        case 29: ctx.viewport(ints[i++], ints[i++], ints[i++], ints[i++]); break;
+        case 30: ctx.vertexAttribPointer(ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], ints[i++]); break;
+        case 31: ctx.enableVertexAttribArray(ints[i++]); break;
+        case 32: ctx.disableVertexAttribArray(ints[i++]); break;
+        case 33: {
+          if (!skippable || currFrameBuffer !== null) {
+            ctx.drawArrays(ints[i], ints[i+1], ints[i+2]);
+          }
+          i += 3;
+          break;
+        }
+        case 34: {
+          if (!skippable || currFrameBuffer !== null) {
+            ctx.drawElements(ints[i], ints[i+1], ints[i+2], ints[i+3]);
+          }
+          i += 4;
+          break;
+        }
+        case 35: assert(ctx.getError() === ctx.NO_ERROR, 'we cannot handle errors, we are async proxied WebGL'); break;
+        case 36: create(ctx.createTexture()); break;
+        case 37: ctx.deleteTexture(release()); break;
+        case 38: ctx.bindTexture(ints[i++], objectOrNull()); break;
+        case 39: ctx.texParameteri(ints[i++], ints[i++], ints[i++]); break;
+        case 40: ctx.texImage2D(ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], datum()); break;
+        case 41: ctx.compressedTexImage2D(ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], datum()); break;
+        case 42: ctx.activeTexture(ints[i++]); break;
+        case 43: assert(ctx.getShaderParameter(object(), ints[i++]), 'we cannot handle errors, we are async proxied WebGL'); break;
+        case 44: ctx.clearDepth(floats[i++]); break;
+        case 45: ctx.depthFunc(ints[i++]); break;
+        case 46: ctx.frontFace(ints[i++]); break;
+        case 47: ctx.cullFace(ints[i++]); break;
+        case 48: ctx.pixelStorei(ints[i++], ints[i++]); break;
+        case 49: ctx.depthMask(ints[i++]); break;
+        case 50: ctx.depthRange(floats[i++], floats[i++]); break;
+        case 51: ctx.blendFunc(ints[i++], ints[i++]); break;
+        case 52: ctx.scissor(ints[i++], ints[i++], ints[i++], ints[i++]); break;
+        case 53: ctx.colorMask(ints[i++], ints[i++], ints[i++], ints[i++]); break;
+        case 54: ctx.lineWidth(floats[i++]); break;
+        case 55: create(ctx.createFramebuffer()); break;
+        case 56: ctx.deleteFramebuffer(release()); break;
+        case 57: {
+          var target = ints[i++];
+          currFrameBuffer = objectOrNull();
+          ctx.bindFramebuffer(target, currFrameBuffer);
+          break;
+        }
+        case 58: ctx.framebufferTexture2D(ints[i++], ints[i++], ints[i++], objectOrNull(), ints[i++]); break;
+        case 59: create(ctx.createRenderbuffer()); break;
+        case 60: ctx.deleteRenderbuffer(release()); break;
+        case 61: ctx.bindRenderbuffer(ints[i++], objectOrNull()); break;
+        case 62: ctx.renderbufferStorage(ints[i++], ints[i++], ints[i++], ints[i++]); break;
+        case 63: ctx.framebufferRenderbuffer(ints[i++], ints[i++], ints[i++], objectOrNull()); break;
+        case 64: Module.print(datum()); break; // debugPrint
+        case 65: ctx.hint(ints[i++], ints[i++]); break;
+        case 66: ctx.blendEquation(ints[i++]); break;
+        case 67: ctx.generateMipmap(ints[i++]); break;
+        case 68: ctx.uniformMatrix3fv(object(), ints[i++], floatArray()); break;
+        case 69: ctx.stencilMask(ints[i++]); break;
+        case 70: ctx.clearStencil(ints[i++]); break;
+        case 71: ctx.texSubImage2D(ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], ints[i++], datum()); break;
+        case 72: ctx.uniform3f(object(), floats[i++], floats[i++], floats[i++]); break;
+        case 73: ctx.blendFuncSeparate(ints[i++], ints[i++], ints[i++], ints[i++]); break;
+        case 74: ctx.uniform2fv(object(), floatArray()); break;
+        case 75: ctx.texParameterf(ints[i++], ints[i++], floats[i++]); break;
+        case 76: assert(!ctx.isContextLost(), 'context lost which we cannot handle, we are async proxied WebGL'); break;
+        case 77: ctx.blendEquationSeparate(ints[i++], ints[i++]); break;
+        case 78: ctx.stencilFuncSeparate(ints[i++], ints[i++], ints[i++], ints[i++]); break;
+        case 79: ctx.stencilOpSeparate(ints[i++], ints[i++], ints[i++], ints[i++]); break;
+        case 80: ctx.drawBuffersWEBGL(intArray()); break;
+        default: throw 'unknown proxied GL command ' + ints[i-1];
+      }
       //var err;
       //while ((err = ctx.getError()) !== ctx.NO_ERROR) {
       //  dump('warning: GL error ' + err + ', after ' + [command, numArgs] + '\n');
@@ -294,7 +188,7 @@ function WebGLClient() {
           // requestion a new frame, we will clear the buffers after rendering them
           window.requestAnimationFrame(renderAllCommands);
         }
-        commandBuffers.push(msg.commandBuffer);
+        commandBuffers.push(msg);
         break;
       }
       default: throw 'weird gl onmessage ' + JSON.stringify(msg);
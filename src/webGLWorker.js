@@ -32,7 +32,51 @@ function WebGLWorker() {
   // State
   //=======
 
-  var commandBuffer = [];
+  // GL calls are recorded into a command stream of 32-bit words, each command an opcode followed by its arguments, and
+  // sent to the client once per frame. Strings and data arrays go to a side table and are referenced by their index in
+  // it; the ArrayBuffers of the data arrays are transferred to the client along with the stream instead of copied.
+  var commandInts = new Int32Array(16384);
+  var commandFloats = new Float32Array(commandInts.buffer);
+  var commandPos = 0;
+  var commandObjects = [];
+  var commandTransfers = [];
+
+  function growCommands(words) {
+    var size = commandInts.length;
+    while (size < commandPos + words) size *= 2;
+    var ints = new Int32Array(size);
+    ints.set(commandInts.subarray(0, commandPos));
+    commandInts = ints;
+    commandFloats = new Float32Array(ints.buffer);
+  }
+  function putInt(x) {
+    if (commandPos === commandInts.length) growCommands(1);
+    commandInts[commandPos++] = x;
+  }
+  function putFloat(x) {
+    if (commandPos === commandInts.length) growCommands(1);
+    commandFloats[commandPos++] = x;
+  }
+  function pushInts() { // an opcode and integer arguments
+    if (commandPos + arguments.length > commandInts.length) growCommands(arguments.length);
+    for (var i = 0; i < arguments.length; i++) commandInts[commandPos++] = arguments[i];
+  }
+  function putFloatArray(data) { // the length, then the elements
+    if (commandPos + data.length + 1 > commandInts.length) growCommands(data.length + 1);
+    commandInts[commandPos++] = data.length;
+    for (var i = 0; i < data.length; i++) commandFloats[commandPos++] = data[i];
+  }
+  function putIntArray(data) {
+    if (commandPos + data.length + 1 > commandInts.length) growCommands(data.length + 1);
+    commandInts[commandPos++] = data.length;
+    for (var i = 0; i < data.length; i++) commandInts[commandPos++] = data[i];
+  }
+  function putObject(object) {
+    putInt(commandObjects.length);
+    commandObjects.push(object);
+    if (object instanceof ArrayBuffer) commandTransfers.push(object);
+    else if (object && object.buffer instanceof ArrayBuffer) commandTransfers.push(object.buffer);
+  }
 
   var nextId = 1; // valid ids are > 0
 
@@ -521,7 +565,7 @@ function WebGLWorker() {
   this.getExtension = function(name) {
     var i = this.prefetchedExtensions.indexOf(name);
     if (i < 0) return null;
-    commandBuffer.push(1, name);
+    putInt(1); putObject(name);
     switch (name) {
       case 'EXT_texture_filter_anisotropic': {
         return {
@@ -586,53 +630,53 @@ function WebGLWorker() {
     return this.prefetchedPrecisions[shaderType][precisionType];
   };
   this.enable = function(cap) {
-    commandBuffer.push(2, cap);
+    pushInts(2, cap);
   };
   this.disable = function(cap) {
-    commandBuffer.push(3, cap);
+    pushInts(3, cap);
   };
   this.clear = function(mask) {
-    commandBuffer.push(4, mask);
+    pushInts(4, mask);
   };
   this.clearColor = function(r, g, b, a) {
-    commandBuffer.push(5, r, g, b, a);
+    putInt(5); putFloat(r); putFloat(g); putFloat(b); putFloat(a);
   };
   this.createShader = function(type) {
     var id = nextId++;
-    commandBuffer.push(6, type, id);
+    pushInts(6, type, id);
     return { id: id, what: 'shader', type: type };
   };
   this.deleteShader = function(shader) {
     if (!shader) return;
-    commandBuffer.push(7, shader.id);
+    pushInts(7, shader.id);
   };
   this.shaderSource = function(shader, source) {
     shader.source = source;
-    commandBuffer.push(8, shader.id, source);
+    pushInts(8, shader.id); putObject(source);
   };
   this.compileShader = function(shader) {
-    commandBuffer.push(9, shader.id);
+    pushInts(9, shader.id);
   };
   this.getShaderInfoLog = function(shader) {
     return ''; // optimistic assumption of success; no proxying
   };
   this.createProgram = function() {
     var id = nextId++;
-    commandBuffer.push(10, id);
+    pushInts(10, id);
     return new WebGLProgram(id);
   };
   this.deleteProgram = function(program) {
     if (!program) return;
-    commandBuffer.push(11, program.id);
+    pushInts(11, program.id);
   };
   this.attachShader = function(program, shader) {
     program.shaders.push(shader);
-    commandBuffer.push(12, program.id, shader.id);
+    pushInts(12, program.id, shader.id);
   };
   this.bindAttribLocation = function(program, index, name) {
     program.nextAttributes[name] = { what: 'attribute', name: name, size: -1, location: index, type: '?' }; // fill in size, type later
     program.nextAttributeVec[index] = name;
-    commandBuffer.push(13, program.id, index, name);
+    pushInts(13, program.id, index); putObject(name);
   };
   this.getAttribLocation = function(program, name) {
     // all existing attribs are cached locally
@@ -711,13 +755,13 @@ function WebGLWorker() {
         var index = program.attributeVec.length;
         program.attributes[attr] = { what: 'attribute', name: attr, size: -1, location: index, type: '?' }; // fill in size, type later
         program.attributeVec[index] = attr;
-        commandBuffer.push(13, program.id, index, attr); // do a bindAttribLocation as well, so this takes effect in the link we are about to do
+        pushInts(13, program.id, index); putObject(attr); // do a bindAttribLocation as well, so this takes effect in the link we are about to do
       }
       program.attributes[attr].size = existingAttributes[attr].size;
       program.attributes[attr].type = existingAttributes[attr].type;
     }
 
-    commandBuffer.push(14, program.id);
+    pushInts(14, program.id);
   };
   this.getProgramParameter = function(program, name) {
     switch (name) {
@@ -725,7 +769,7 @@ function WebGLWorker() {
       case this.ACTIVE_ATTRIBUTES: return program.attributeVec.length;
       case this.LINK_STATUS: {
         // optimisticaly return success; client will abort on an actual error. we assume an error-free async workflow
-        commandBuffer.push(15, program.id, name);
+        pushInts(15, program.id, name);
         return true;
       }
       default: throw 'bad getProgramParameter ' + revname(name);
@@ -752,54 +796,54 @@ function WebGLWorker() {
     }
     if (!(name in program.uniforms)) return null;
     var id = nextId++;
-    commandBuffer.push(16, program.id, fullname, id);
+    pushInts(16, program.id); putObject(fullname); putInt(id);
     return { what: 'location', uniform: program.uniforms[name], id: id, index: index };
   };
   this.getProgramInfoLog = function(shader) {
     return ''; // optimistic assumption of success; no proxying
   };
   this.useProgram = function(program) {
-    commandBuffer.push(17, program ? program.id : 0);
+    pushInts(17, program ? program.id : 0);
     bindings.program = program;
   };
   this.uniform1i = function(location, data) {
     if (!location) return;
-    commandBuffer.push(18, location.id, data);
+    pushInts(18, location.id, data);
   };
   this.uniform1f = function(location, data) {
     if (!location) return;
-    commandBuffer.push(19, location.id, data);
+    pushInts(19, location.id); putFloat(data);
   };
   this.uniform3fv = function(location, data) {
     if (!location) return;
-    commandBuffer.push(20, location.id, new Float32Array(data));
+    pushInts(20, location.id); putFloatArray(data);
   };
   this.uniform4f = function(location, x, y, z, w) {
     if (!location) return;
-    commandBuffer.push(21, location.id, new Float32Array([x, y, z, w]));
+    pushInts(21, location.id, 4); putFloat(x); putFloat(y); putFloat(z); putFloat(w);
   };
   this.uniform4fv = function(location, data) {
     if (!location) return;
-    commandBuffer.push(21, location.id, new Float32Array(data));
+    pushInts(21, location.id); putFloatArray(data);
   };
   this.uniformMatrix4fv = function(location, transpose, data) {
     if (!location) return;
-    commandBuffer.push(22, location.id, transpose, new Float32Array(data));
+    pushInts(22, location.id, transpose); putFloatArray(data);
   };
   this.vertexAttrib4fv = function(index, values) {
-    commandBuffer.push(23, index, new Float32Array(values));
+    pushInts(23, index); putFloatArray(values);
   };
   this.createBuffer = function() {
     var id = nextId++;
-    commandBuffer.push(24, id);
+    pushInts(24, id);
     return new WebGLBuffer(id);
   };
   this.deleteBuffer = function(buffer) {
     if (!buffer) return;
-    commandBuffer.push(25, buffer.id);
+    pushInts(25, buffer.id);
   };
   this.bindBuffer = function(target, buffer) {
-    commandBuffer.push(26, target, buffer ? buffer.id : 0);
+    pushInts(26, target, buffer ? buffer.id : 0);
     switch (target) {
       case this.ARRAY_BUFFER_BINDING: {
         bindings.arrayBuffer = buffer;
@@ -818,42 +862,42 @@ function WebGLWorker() {
     return new something.constructor(something); // typed array
   }
   this.bufferData = function(target, something, usage) {
-    commandBuffer.push(27, target, duplicate(something), usage);
+    pushInts(27, target); putObject(duplicate(something)); putInt(usage);
   };
   this.bufferSubData = function(target, offset, something) {
-    commandBuffer.push(28, target, offset, duplicate(something));
+    pushInts(28, target, offset); putObject(duplicate(something));
   };
   this.viewport = function(x, y, w, h) {
-    commandBuffer.push(29, x, y, w, h);
+    pushInts(29, x, y, w, h);
   };
   this.vertexAttribPointer = function(index, size, type, normalized, stride, offset) {
-    commandBuffer.push(30, index, size, type, normalized, stride, offset);
+    pushInts(30, index, size, type, normalized, stride, offset);
   };
   this.enableVertexAttribArray = function(index) {
-    commandBuffer.push(31, index);
+    pushInts(31, index);
   };
   this.disableVertexAttribArray = function(index) {
-    commandBuffer.push(32, index);
+    pushInts(32, index);
   };
   this.drawArrays = function(mode, first, count) {
-    commandBuffer.push(33, mode, first, count);
+    pushInts(33, mode, first, count);
   };
   this.drawElements = function(mode, count, type, offset) {
-    commandBuffer.push(34, mode, count, type, offset);
+    pushInts(34, mode, count, type, offset);
   };
   this.getError = function() {
     // optimisticaly return success; client will abort on an actual error. we assume an error-free async workflow
-    commandBuffer.push(35);
+    pushInts(35);
     return this.NO_ERROR;
   };
   this.createTexture = function() {
     var id = nextId++;
-    commandBuffer.push(36, id);
+    pushInts(36, id);
     return new WebGLTexture(id);
   };
   this.deleteTexture = function(texture) {
     if (!texture) return;
-    commandBuffer.push(37, texture.id);
+    pushInts(37, texture.id);
     texture.id = 0;
   };
   this.isTexture = function(texture) {
@@ -867,10 +911,10 @@ function WebGLWorker() {
       }
     }
     if (texture) texture.binding = target;
-    commandBuffer.push(38, target, texture ? texture.id : 0);
+    pushInts(38, target, texture ? texture.id : 0);
   };
   this.texParameteri = function(target, pname, param) {
-    commandBuffer.push(39, target, pname, param);
+    pushInts(39, target, pname, param);
   };
   this.texImage2D = function(target, level, internalformat, width, height, border, format, type, pixels) {
     if (pixels === undefined) {
@@ -886,119 +930,119 @@ function WebGLWorker() {
       border = 0;
       pixels = new Uint8Array(data.data); // XXX transform from clamped to normal, could have been done in duplicate
     }
-    commandBuffer.push(40, target, level, internalformat, width, height, border, format, type, duplicate(pixels));
+    pushInts(40, target, level, internalformat, width, height, border, format, type); putObject(duplicate(pixels));
   };
   this.compressedTexImage2D = function(target, level, internalformat, width, height, border, pixels) {
-    commandBuffer.push(41, target, level, internalformat, width, height, border, duplicate(pixels));
+    pushInts(41, target, level, internalformat, width, height, border); putObject(duplicate(pixels));
   };
   this.activeTexture = function(texture) {
-    commandBuffer.push(42, texture);
+    pushInts(42, texture);
   };
   this.getShaderParameter = function(shader, pname) {
     switch (pname) {
       case this.SHADER_TYPE: return shader.type;
       case this.COMPILE_STATUS: {
         // optimisticaly return success; client will abort on an actual error. we assume an error-free async workflow
-        commandBuffer.push(43, shader.id, pname);
+        pushInts(43, shader.id, pname);
         return true;
       }
       default: throw 'unsupported getShaderParameter ' + pname;
     }
   };
   this.clearDepth = function(depth) {
-    commandBuffer.push(44, depth);
+    putInt(44); putFloat(depth);
   };
   this.depthFunc = function(depth) {
-    commandBuffer.push(45, depth);
+    pushInts(45, depth);
   };
   this.frontFace = function(depth) {
-    commandBuffer.push(46, depth);
+    pushInts(46, depth);
   };
   this.cullFace = function(depth) {
-    commandBuffer.push(47, depth);
+    pushInts(47, depth);
   };
   this.readPixels = function(depth) {
     abort('readPixels is impossible, we are async GL');
   };
   this.pixelStorei = function(pname, param) {
-    commandBuffer.push(48, pname, param);
+    pushInts(48, pname, param);
   };
   this.depthMask = function(flag) {
-    commandBuffer.push(49, flag);
+    pushInts(49, flag);
   };
   this.depthRange = function(near, far) {
-    commandBuffer.push(50, near, far);
+    putInt(50); putFloat(near); putFloat(far);
   };
   this.blendFunc = function(sfactor, dfactor) {
-    commandBuffer.push(51, sfactor, dfactor);
+    pushInts(51, sfactor, dfactor);
   };
   this.scissor = function(x, y, width, height) {
-    commandBuffer.push(52, x, y, width, height);
+    pushInts(52, x, y, width, height);
   };
   this.colorMask = function(red, green, blue, alpha) {
-    commandBuffer.push(53, red, green, blue, alpha);
+    pushInts(53, red, green, blue, alpha);
   };
   this.lineWidth = function(width) {
-    commandBuffer.push(54, width);
+    putInt(54); putFloat(width);
   };
   this.createFramebuffer = function() {
     var id = nextId++;
-    commandBuffer.push(55, id);
+    pushInts(55, id);
     return new WebGLFramebuffer(id);
   };
   this.deleteFramebuffer = function(framebuffer) {
     if (!framebuffer) return;
-    commandBuffer.push(56, framebuffer.id);
+    pushInts(56, framebuffer.id);
   };
   this.bindFramebuffer = function(target, framebuffer) {
-    commandBuffer.push(57, target, framebuffer ? framebuffer.id : 0);
+    pushInts(57, target, framebuffer ? framebuffer.id : 0);
     bindings.framebuffer = framebuffer;
   };
   this.framebufferTexture2D = function(target, attachment, textarget, texture, level) {
-    commandBuffer.push(58, target, attachment, textarget, texture ? texture.id : 0, level);
+    pushInts(58, target, attachment, textarget, texture ? texture.id : 0, level);
   };
   this.checkFramebufferStatus = function(target) {
     return this.FRAMEBUFFER_COMPLETE; // XXX totally wrong
   };
   this.createRenderbuffer = function() {
     var id = nextId++;
-    commandBuffer.push(59, id);
+    pushInts(59, id);
     return new WebGLRenderbuffer(id);
   };
   this.deleteRenderbuffer = function(renderbuffer) {
     if (!renderbuffer) return;
-    commandBuffer.push(60, renderbuffer.id);
+    pushInts(60, renderbuffer.id);
   };
   this.bindRenderbuffer = function(target, renderbuffer) {
-    commandBuffer.push(61, target, renderbuffer ? renderbuffer.id : 0);
+    pushInts(61, target, renderbuffer ? renderbuffer.id : 0);
   };
   this.renderbufferStorage = function(target, internalformat, width, height) {
-    commandBuffer.push(62, target, internalformat, width, height);
+    pushInts(62, target, internalformat, width, height);
   };
   this.framebufferRenderbuffer = function(target, attachment, renderbuffertarget, renderbuffer) {
-    commandBuffer.push(63, target, attachment, renderbuffertarget, renderbuffer ? renderbuffer.id : 0);
+    pushInts(63, target, attachment, renderbuffertarget, renderbuffer ? renderbuffer.id : 0);
   };
   this.debugPrint = function(text) { // useful to interleave debug output properly with client GL commands
-    commandBuffer.push(64, text);
+    putInt(64); putObject(text);
   };
   this.hint = function(target, mode) {
-    commandBuffer.push(65, target, mode);
+    pushInts(65, target, mode);
   };
   this.blendEquation = function(mode) {
-    commandBuffer.push(66, mode);
+    pushInts(66, mode);
   };
   this.generateMipmap = function(target) {
-    commandBuffer.push(67, target);
+    pushInts(67, target);
   };
   this.uniformMatrix3fv = function(location, transpose, data) {
     if (!location) return;
-    commandBuffer.push(68, location.id, transpose, new Float32Array(data));
+    pushInts(68, location.id, transpose); putFloatArray(data);
   };
   this.stencilMask = function(mask) {
-    commandBuffer.push(69, mask);
+    pushInts(69, mask);
   };
   this.clearStencil = function(s) {
-    commandBuffer.push(70, s);
+    pushInts(70, s);
   };
   this.texSubImage2D = function(target, level, xoffset, yoffset, width, height, format, type, pixels) {
     if (pixels === undefined) {
@@ -1015,41 +1059,41 @@ function WebGLWorker() {
       height = data.height;
       pixels = new Uint8Array(data.data); // XXX transform from clamped to normal, could have been done in duplicate
     }
-    commandBuffer.push(71, target, level, xoffset, yoffset, width, height, format, type, duplicate(pixels));
+    pushInts(71, target, level, xoffset, yoffset, width, height, format, type); putObject(duplicate(pixels));
   };
   this.uniform3f = function(location, x, y, z) {
     if (!location) return;
-    commandBuffer.push(72, location.id, x, y, z);
+    pushInts(72, location.id); putFloat(x); putFloat(y); putFloat(z);
   };
   this.blendFuncSeparate = function(srcRGB, dstRGB, srcAlpha, dstAlpha) {
-    commandBuffer.push(73, srcRGB, dstRGB, srcAlpha, dstAlpha);
+    pushInts(73, srcRGB, dstRGB, srcAlpha, dstAlpha);
   }
   this.uniform2fv = function(location, data) {
     if (!location) return;
-    commandBuffer.push(74, location.id, new Float32Array(data));
+    pushInts(74, location.id); putFloatArray(data);
   };
   this.texParameterf = function(target, pname, param) {
-    commandBuffer.push(75, target, pname, param);
+    pushInts(75, target, pname); putFloat(param);
   };
   this.isContextLost = function() {
     // optimisticaly return that everything is ok; client will abort on an actual context loss. we assume an error-free async workflow
-    commandBuffer.push(76);
+    pushInts(76);
     return false;
   };
   this.isProgram = function(program) {
     return program && program.what === 'program';
   };
   this.blendEquationSeparate = function(rgb, alpha) {
-    commandBuffer.push(77, rgb, alpha);
+    pushInts(77, rgb, alpha);
   };
   this.stencilFuncSeparate = function(face, func, ref, mask) {
-    commandBuffer.push(78, face, func, ref, mask);
+    pushInts(78, face, func, ref, mask);
   };
   this.stencilOpSeparate = function(face, fail, zfail, zpass) {
-    commandBuffer.push(79, face, fail, zfail, zpass);
+    pushInts(79, face, fail, zfail, zpass);
   };
   this.drawBuffersWEBGL = function(buffers) {
-    commandBuffer.push(80, buffers);
+    putInt(80); putIntArray(buffers);
   };
 
   // Setup
@@ -1069,9 +1113,16 @@ function WebGLWorker() {
   var postRAFed = false;
 
   function postRAF() {
-    if (commandBuffer.length > 0) {
-      postMessage({ target: 'gl', op: 'render', commandBuffer: commandBuffer });
-      commandBuffer = [];
+    if (commandPos > 0) {
+      var capacity = commandInts.length;
+      commandTransfers.push(commandInts.buffer);
+      postMessage({ target: 'gl', op: 'render', commandBuffer: commandInts.buffer, length: commandPos, objects: commandObjects }, commandTransfers);
+      // The stream was transferred, start the next one with the same capacity.
+      commandInts = new Int32Array(capacity);
+      commandFloats = new Float32Array(commandInts.buffer);
+      commandPos = 0;
+      commandObjects = [];
+      commandTransfers = [];
     }
     postRAFed = true;
   }
@@ -77,6 +77,16 @@ namespace emscripten {
                 GenericFunction invoker,
                 GenericFunction function);
 
+            void _embind_register_batched_function(
+                const char* name,
+                unsigned argCount,
+                const TYPEID argTypes[],
+                const char* argumentLayout,
+                GenericFunction batchedInvoker,
+                GenericFunction function,
+                const char* dispatcherSignature,
+                GenericFunction dispatcher);
+
             void _embind_register_value_array(
                 TYPEID tupleType,
                 const char* name,
@@ -96,6 +106,13 @@ namespace emscripten {
                 GenericFunction setter,
                 void* setterContext);
 
+            void _embind_register_value_array_direct_element(
+                TYPEID tupleType,
+                TYPEID elementType,
+                char elementLayout,
+                size_t elementOffset,
+                size_t tupleSize);
+
             void _embind_finalize_value_array(TYPEID tupleType);
 
             void _embind_register_value_object(
@@ -118,6 +135,14 @@ namespace emscripten {
                 GenericFunction setter,
                 void* setterContext);
 
+            void _embind_register_value_object_direct_field(
+                TYPEID structType,
+                const char* fieldName,
+                TYPEID fieldType,
+                char fieldLayout,
+                size_t fieldOffset,
+                size_t structSize);
+
             void _embind_finalize_value_object(TYPEID structType);
 
             void _embind_register_class(
@@ -412,6 +437,112 @@ namespace emscripten {
             reinterpret_cast<GenericFunction>(fn));
     }
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // BATCHED FUNCTIONS
+    ////////////////////////////////////////////////////////////////////////////////
+
+    namespace internal {
+        // Calls recorded into a Module.CommandBuffer are laid out as one
+        // GenericWireType holding the batched invoker and the target
+        // function, followed by one GenericWireType per argument.
+        typedef const GenericWireType* (*BatchedInvokerFunction)(
+            GenericFunction function,
+            const GenericWireType* args);
+
+        // Runs every call recorded in [begin, end).  Implemented in bind.cpp.
+        void invokeBatchedCalls(const GenericWireType* begin, const GenericWireType* end);
+
+        template<typename WireType>
+        struct GenericWireTypeReader {
+            static WireType read(const GenericWireType& g) {
+                return static_cast<WireType>(g.w[0].u);
+            }
+        };
+
+        template<>
+        struct GenericWireTypeReader<float> {
+            static float read(const GenericWireType& g) {
+                return g.w[0].f;
+            }
+        };
+
+        template<>
+        struct GenericWireTypeReader<double> {
+            static double read(const GenericWireType& g) {
+                return g.d;
+            }
+        };
+
+        template<typename Pointee>
+        struct GenericWireTypeReader<Pointee*> {
+            static Pointee* read(const GenericWireType& g) {
+                return static_cast<Pointee*>(const_cast<void*>(g.w[0].p));
+            }
+        };
+
+        template<size_t... Indices>
+        struct IndexSequence {};
+
+        template<size_t N, size_t... Indices>
+        struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Indices...> {};
+
+        template<size_t... Indices>
+        struct MakeIndexSequence<0, Indices...> {
+            typedef IndexSequence<Indices...> type;
+        };
+
+        template<typename... Args>
+        struct BatchedInvoker {
+            static const GenericWireType* invoke(
+                GenericFunction function,
+                const GenericWireType* args
+            ) {
+                call(
+                    reinterpret_cast<void (*)(Args...)>(function),
+                    args,
+                    typename MakeIndexSequence<sizeof...(Args)>::type());
+                return args + sizeof...(Args);
+            }
+
+        private:
+            template<size_t... Indices>
+            static void call(
+                void (*fn)(Args...),
+                const GenericWireType* args,
+                IndexSequence<Indices...>
+            ) {
+                fn(
+                    BindingType<Args>::fromWireType(
+                        GenericWireTypeReader<typename BindingType<Args>::WireType>::read(args[Indices]))...
+                );
+            }
+        };
+    }
+
+    // Registers a function that JavaScript records into a
+    // Module.CommandBuffer instead of calling immediately.  Recorded calls
+    // run in order, all in one call into C++, when the buffer is flushed or
+    // fills up.
+    template<typename... Args, typename... Policies>
+    void batched_function(const char* name, void (*fn)(Args...), Policies...) {
+        using namespace internal;
+        static_assert(
+            PackSize<Args...>::value == sizeof...(Args),
+            "batched function arguments must fit in a GenericWireType each");
+        typename WithPolicies<Policies...>::template ArgTypeList<void, Args...> args;
+        auto invoker = &BatchedInvoker<Args...>::invoke;
+        auto dispatcher = &invokeBatchedCalls;
+        _embind_register_batched_function(
+            name,
+            args.getCount(),
+            args.getTypes(),
+            getSpecificSignature<void, typename BindingType<Args>::WireType...>(),
+            reinterpret_cast<GenericFunction>(invoker),
+            reinterpret_cast<GenericFunction>(fn),
+            getSignature(dispatcher),
+            reinterpret_cast<GenericFunction>(dispatcher));
+    }
+
     namespace internal {
         template<typename ClassType, typename... Args>
         ClassType* operator_new(Args&&... args) {
@@ -522,6 +653,47 @@ namespace emscripten {
             }
         };
 
+        // Members of trivially copyable value types that have a native
+        // heap representation are read and written by JavaScript directly
+        // at their offset, without going through getter/setter invokers.
+        template<typename ClassType, typename FieldType>
+        struct IsDirectField : std::integral_constant<bool,
+            std::is_trivially_copyable<ClassType>::value &&
+            std::is_arithmetic<FieldType>::value &&
+            (std::is_floating_point<FieldType>::value
+                ? (std::is_same<typename std::remove_cv<FieldType>::type, float>::value || std::is_same<typename std::remove_cv<FieldType>::type, double>::value)
+                : sizeof(FieldType) <= 4)
+        > {};
+
+        // Must match the layout codes in $getDirectFieldAccessors in embind.js.
+        template<typename FieldType>
+        struct DirectFieldLayout {
+            // long double has no heap view; it goes through the getter/setter path.
+            static_assert(!std::is_floating_point<FieldType>::value ||
+                          std::is_same<typename std::remove_cv<FieldType>::type, float>::value ||
+                          std::is_same<typename std::remove_cv<FieldType>::type, double>::value,
+                          "only float and double fields can be marshalled directly");
+
+            static constexpr char get() {
+                return std::is_floating_point<FieldType>::value
+                    ? (std::is_same<typename std::remove_cv<FieldType>::type, float>::value ? 'f' : 'd')
+                    : sizeof(FieldType) == 1
+                    ? (std::is_signed<FieldType>::value ? 'b' : 'B')
+                    : sizeof(FieldType) == 2
+                    ? (std::is_signed<FieldType>::value ? 'h' : 'H')
+                    : (std::is_signed<FieldType>::value ? 'i' : 'I');
+            }
+        };
+
+        template<typename ClassType, typename InstanceType, typename FieldType>
+        size_t getFieldOffset(FieldType InstanceType::*field) {
+            // Only the member's address is computed; the storage is never read.
+            typename std::aligned_storage<sizeof(ClassType), alignof(ClassType)>::type storage;
+            const ClassType& instance = *reinterpret_cast<const ClassType*>(&storage);
+            return reinterpret_cast<const char*>(&(instance.*field)) -
+                reinterpret_cast<const char*>(&instance);
+        }
+
         // TODO: This could do a reinterpret-cast if sizeof(T) === sizeof(void*)
         template<typename T>
         inline T* getContext(const T& t) {
@@ -661,24 +833,9 @@ namespace emscripten {
 
         template<typename InstanceType, typename ElementType>
         value_array& element(ElementType InstanceType::*field) {
-            using namespace internal;
-
-            auto getter = &MemberAccess<InstanceType, ElementType>
-                ::template getWire<ClassType>;
-            auto setter = &MemberAccess<InstanceType, ElementType>
-                ::template setWire<ClassType>;
-
-            _embind_register_value_array_element(
-                TypeID<ClassType>::get(),
-                TypeID<ElementType>::get(),
-                getSignature(getter),
-                reinterpret_cast<GenericFunction>(getter),
-                getContext(field),
-                TypeID<ElementType>::get(),
-                getSignature(setter),
-                reinterpret_cast<GenericFunction>(setter),
-                getContext(field));
-            return *this;
+            return member_element(
+                field,
+                internal::IsDirectField<ClassType, ElementType>());
         }
 
         template<typename Getter, typename Setter>
@@ -723,6 +880,42 @@ namespace emscripten {
                 reinterpret_cast<void*>(Index));
             return *this;
         }
+
+    private:
+        template<typename InstanceType, typename ElementType>
+        value_array& member_element(ElementType InstanceType::*field, std::false_type) {
+            using namespace internal;
+
+            auto getter = &MemberAccess<InstanceType, ElementType>
+                ::template getWire<ClassType>;
+            auto setter = &MemberAccess<InstanceType, ElementType>
+                ::template setWire<ClassType>;
+
+            _embind_register_value_array_element(
+                TypeID<ClassType>::get(),
+                TypeID<ElementType>::get(),
+                getSignature(getter),
+                reinterpret_cast<GenericFunction>(getter),
+                getContext(field),
+                TypeID<ElementType>::get(),
+                getSignature(setter),
+                reinterpret_cast<GenericFunction>(setter),
+                getContext(field));
+            return *this;
+        }
+
+        template<typename InstanceType, typename ElementType>
+        value_array& member_element(ElementType InstanceType::*field, std::true_type) {
+            using namespace internal;
+
+            _embind_register_value_array_direct_element(
+                TypeID<ClassType>::get(),
+                TypeID<ElementType>::get(),
+                DirectFieldLayout<ElementType>::get(),
+                getFieldOffset<ClassType>(field),
+                sizeof(ClassType));
+            return *this;
+        }
     };
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -756,25 +949,10 @@ namespace emscripten {
 
         template<typename InstanceType, typename FieldType>
         value_object& field(const char* fieldName, FieldType InstanceType::*field) {
-            using namespace internal;
-
-            auto getter = &MemberAccess<InstanceType, FieldType>
-                ::template getWire<ClassType>;
-            auto setter = &MemberAccess<InstanceType, FieldType>
-                ::template setWire<ClassType>;
-
-            _embind_register_value_object_field(
-                TypeID<ClassType>::get(),
+            return member_field(
                 fieldName,
-                TypeID<FieldType>::get(),
-                getSignature(getter),
-                reinterpret_cast<GenericFunction>(getter),
-                getContext(field),
-                TypeID<FieldType>::get(),
-                getSignature(setter),
-                reinterpret_cast<GenericFunction>(setter),
-                getContext(field));
-            return *this;
+                field,
+                internal::IsDirectField<ClassType, FieldType>());
         }
     
         template<typename Getter, typename Setter>
@@ -826,6 +1004,52 @@ namespace emscripten {
                 reinterpret_cast<void*>(Index));
             return *this;
         }
+
+    private:
+        template<typename InstanceType, typename FieldType>
+        value_object& member_field(
+            const char* fieldName,
+            FieldType InstanceType::*field,
+            std::false_type
+        ) {
+            using namespace internal;
+
+            auto getter = &MemberAccess<InstanceType, FieldType>
+                ::template getWire<ClassType>;
+            auto setter = &MemberAccess<InstanceType, FieldType>
+                ::template setWire<ClassType>;
+
+            _embind_register_value_object_field(
+                TypeID<ClassType>::get(),
+                fieldName,
+                TypeID<FieldType>::get(),
+                getSignature(getter),
+                reinterpret_cast<GenericFunction>(getter),
+                getContext(field),
+                TypeID<FieldType>::get(),
+                getSignature(setter),
+                reinterpret_cast<GenericFunction>(setter),
+                getContext(field));
+            return *this;
+        }
+
+        template<typename InstanceType, typename FieldType>
+        value_object& member_field(
+            const char* fieldName,
+            FieldType InstanceType::*field,
+            std::true_type
+        ) {
+            using namespace internal;
+
+            _embind_register_value_object_direct_field(
+                TypeID<ClassType>::get(),
+                fieldName,
+                TypeID<FieldType>::get(),
+                DirectFieldLayout<FieldType>::get(),
+                getFieldOffset<ClassType>(field),
+                sizeof(ClassType));
+            return *this;
+        }
     };
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -924,6 +1148,7 @@ namespace emscripten {
         explicit wrapper(val&& wrapped, Args&&... args)
             : T(std::forward<Args>(args)...)
             , wrapped(std::forward<val>(wrapped))
+            , dispatchTable(val::take_ownership(internal::_emval_create_dispatch_table(this->wrapped.__get_handle())))
         {}
 
         ~wrapper() {
@@ -932,13 +1157,19 @@ namespace emscripten {
             }
         }
 
+        // Each method is looked up on the JS object the first time it is
+        // called and the function is reused for the lifetime of the wrapper.
         template<typename ReturnType, typename... Args>
         ReturnType call(const char* name, Args&&... args) const {
-            return wrapped.call<ReturnType>(name, std::forward<Args>(args)...);
+            return internal::DispatchedMethodCaller<ReturnType, Args...>::call(
+                dispatchTable.__get_handle(),
+                name,
+                std::forward<Args>(args)...);
         }
 
     private:
         val wrapped;
+        val dispatchTable;
     };
 
 #define EMSCRIPTEN_WRAPPER(T)                                           \
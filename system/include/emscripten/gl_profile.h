@@ -0,0 +1,41 @@
+#ifndef __emscripten_gl_profile_h__
+#define __emscripten_gl_profile_h__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Profiling of the GL library functions, available when building with -s GL_PROFILE=1.
+
+#define EMSCRIPTEN_GL_PROFILE_HISTOGRAM_BUCKETS 8
+
+// The statistics of one GL function over one frame. Bucket 0 of the histogram counts the calls that took less
+// than 1 microsecond, and bucket i the calls that took at least 4^(i-1) but less than 4^i microseconds. The last
+// bucket counts all calls that took longer.
+typedef struct emscripten_gl_profile_entry {
+  const char *name;
+  uint32_t calls;
+  double msecs;
+  double bytesUploaded;
+  uint32_t histogram[EMSCRIPTEN_GL_PROFILE_HISTOGRAM_BUCKETS];
+} emscripten_gl_profile_entry;
+
+// Finishes the current profiling frame. This is called automatically at the start of each main loop iteration,
+// applications that drive their own frames can call it at the end of each frame.
+extern void emscripten_gl_profile_end_frame(void);
+
+// Copies the statistics of the GL functions that were called during the last finished frame to entries, ordered
+// by the time spent in them, starting from the most expensive. Returns the number of entries written, which is at
+// most maxEntries, or -1 if GL profiling was not enabled at compile time.
+extern int emscripten_gl_profile_get_frame(emscripten_gl_profile_entry *entries, int maxEntries);
+
+// Clears the statistics of the current and the last finished frame.
+extern void emscripten_gl_profile_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __emscripten_gl_profile_h__
@@ -417,6 +417,18 @@ extern EMSCRIPTEN_RESULT emscripten_webgl_destroy_context(EMSCRIPTEN_WEBGL_CONTE
 
 extern EM_BOOL emscripten_webgl_enable_extension(EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context, const char *extension);
 
+typedef struct EmscriptenWebGLStateCacheStats {
+  int issuedThisFrame;
+  int filteredThisFrame;
+  int issuedLastFrame;
+  int filteredLastFrame;
+  double totalIssued;
+  double totalFiltered;
+} EmscriptenWebGLStateCacheStats;
+
+extern EMSCRIPTEN_RESULT emscripten_webgl_get_state_cache_stats(EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context, EmscriptenWebGLStateCacheStats *stats);
+extern EMSCRIPTEN_RESULT emscripten_webgl_invalidate_state_cache(EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context);
+
 typedef EM_BOOL (*em_webgl_context_callback)(int eventType, const void *reserved, void *userData);
 extern EMSCRIPTEN_RESULT emscripten_set_webglcontextlost_callback(const char *target, void *userData, EM_BOOL useCapture, em_webgl_context_callback callback);
 extern EMSCRIPTEN_RESULT emscripten_set_webglcontextrestored_callback(const char *target, void *userData, EM_BOOL useCapture, em_webgl_context_callback callback);
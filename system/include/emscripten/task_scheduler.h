@@ -0,0 +1,117 @@
+#ifndef __emscripten_task_scheduler_h__
+#define __emscripten_task_scheduler_h__
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A work-stealing task scheduler on top of pthreads. Only available when building with -s USE_PTHREADS=1.
+//
+// Each worker thread owns a deque of tasks: it pushes and pops new tasks at one end, and idle workers steal from the
+// other end of the deques of busy workers. Tasks spawned from threads that are not scheduler workers (e.g. the main
+// thread) go to a shared queue that all workers take from. Idle workers park on a futex until new tasks are spawned.
+//
+// Threads that wait for tasks to finish (emscripten_task_group_wait(), emscripten_parallel_for()) execute pending tasks
+// themselves while they wait, so a scheduler with zero workers still runs all tasks to completion, just serially.
+// When waiting on the main thread, calls proxied to the main thread are processed while waiting.
+//
+// Note that in browsers, new pthreads can only start running once the main thread yields back to the event loop. Use
+// -s PTHREAD_POOL_SIZE=<n> to have the worker threads available when the scheduler is first used on the main thread.
+
+typedef void (*em_task_func)(void *arg);
+typedef void (*em_parallel_for_func)(int begin, int end, void *arg);
+
+// Starts the scheduler with the given number of worker threads. Pass 0 to use emscripten_num_logical_cores()-1
+// workers, or -1 to start no workers at all. Returns 0 on success, or EBUSY if the scheduler is already running.
+// Calling this is optional: the scheduler starts with the default number of workers on first use.
+int emscripten_task_scheduler_init(int numWorkers);
+
+// Stops and joins all worker threads. No tasks may be pending when this is called. The scheduler can be started
+// again afterwards.
+void emscripten_task_scheduler_shutdown(void);
+
+// Returns the number of worker threads of the running scheduler, or 0 if it is not running.
+int emscripten_task_scheduler_num_workers(void);
+
+// A task group tracks a set of spawned tasks so that they can be waited on together.
+typedef struct em_task_group
+{
+  uint32_t pendingTasks;
+} em_task_group;
+
+#define EM_TASK_GROUP_INITIALIZER { 0 }
+
+void emscripten_task_group_init(em_task_group *group);
+
+// Spawns func(arg) to be run asynchronously as part of the given group. The task may also run synchronously inside
+// this call if the task queue of the calling thread is full.
+void emscripten_task_group_run(em_task_group *group, em_task_func func, void *arg);
+
+// Blocks until all tasks spawned in the group, including tasks they spawned into the same group, have finished.
+// Executes other pending tasks while waiting.
+void emscripten_task_group_wait(em_task_group *group);
+
+// Calls func(b, e, arg) over disjoint subranges [b, e[ that together cover [begin, end[, in parallel. Ranges are split
+// in halves until they are at most grainSize long. Pass grainSize <= 0 to pick one based on the number of workers.
+// Returns after all subranges have been processed.
+void emscripten_parallel_for(int begin, int end, int grainSize, em_parallel_for_func func, void *arg);
+
+#ifdef __cplusplus
+} // ~extern "C"
+
+namespace emscripten {
+    namespace internal {
+        template<typename F>
+        void parallelForRange(int begin, int end, void *arg) {
+            const F &f = *static_cast<const F*>(arg);
+            for (int i = begin; i < end; ++i) {
+                f(i);
+            }
+        }
+
+        template<typename F>
+        void runAndDeleteTask(void *arg) {
+            F *f = static_cast<F*>(arg);
+            (*f)();
+            delete f;
+        }
+    }
+
+    // Calls f(i) for each i in [begin, end[, in parallel.
+    template<typename F>
+    void parallel_for(int begin, int end, const F &f, int grainSize = 0) {
+        emscripten_parallel_for(begin, end, grainSize, &internal::parallelForRange<F>, const_cast<F*>(&f));
+    }
+
+    // Runs copies of function objects asynchronously. The destructor waits for all of them to finish.
+    class task_group {
+    public:
+        task_group() {
+            emscripten_task_group_init(&group);
+        }
+
+        ~task_group() {
+            wait();
+        }
+
+        template<typename F>
+        void run(const F &f) {
+            emscripten_task_group_run(&group, &internal::runAndDeleteTask<F>, new F(f));
+        }
+
+        void wait() {
+            emscripten_task_group_wait(&group);
+        }
+
+    private:
+        task_group(const task_group&);
+        task_group &operator=(const task_group&);
+
+        em_task_group group;
+    };
+}
+#endif
+
+#endif
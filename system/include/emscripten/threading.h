@@ -25,7 +25,7 @@ void emscripten_force_num_logical_cores(int cores);
 uint8_t emscripten_atomic_exchange_u8(void/*uint8_t*/ *addr, uint8_t newVal);
 uint16_t emscripten_atomic_exchange_u16(void/*uint16_t*/ *addr, uint16_t newVal);
 uint32_t emscripten_atomic_exchange_u32(void/*uint32_t*/ *addr, uint32_t newVal);
-uint64_t emscripten_atomic_exchange_u64(void/*uint64_t*/ *addr, uint64_t newVal); // Emulated with locks, very slow!!
+uint64_t emscripten_atomic_exchange_u64(void/*uint64_t*/ *addr, uint64_t newVal); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
 
 // CAS returns the *old* value that was in the memory location before the operation took place.
 // That is, if the return value when calling this function equals to 'oldVal', then the operation succeeded,
@@ -33,22 +33,22 @@ uint64_t emscripten_atomic_exchange_u64(void/*uint64_t*/ *addr, uint64_t newVal)
 uint8_t emscripten_atomic_cas_u8(void/*uint8_t*/ *addr, uint8_t oldVal, uint8_t newVal);
 uint16_t emscripten_atomic_cas_u16(void/*uint16_t*/ *addr, uint16_t oldVal, uint16_t newVal);
 uint32_t emscripten_atomic_cas_u32(void/*uint32_t*/ *addr, uint32_t oldVal, uint32_t newVal);
-uint64_t emscripten_atomic_cas_u64(void/*uint64_t*/ *addr, uint64_t oldVal, uint64_t newVal); // Emulated with locks, very slow!!
+uint64_t emscripten_atomic_cas_u64(void/*uint64_t*/ *addr, uint64_t oldVal, uint64_t newVal); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
 
 uint8_t emscripten_atomic_load_u8(const void/*uint8_t*/ *addr);
 uint16_t emscripten_atomic_load_u16(const void/*uint16_t*/ *addr);
 uint32_t emscripten_atomic_load_u32(const void/*uint32_t*/ *addr);
 float emscripten_atomic_load_f32(const void/*float*/ *addr);
-uint64_t emscripten_atomic_load_u64(const void/*uint64_t*/ *addr); // Emulated with locks, very slow!!
-double emscripten_atomic_load_f64(const void/*double*/ *addr); // Emulated with locks, very slow!!
+uint64_t emscripten_atomic_load_u64(const void/*uint64_t*/ *addr); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
+double emscripten_atomic_load_f64(const void/*double*/ *addr); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
 
 // Returns the value that was stored (i.e. 'val')
 uint8_t emscripten_atomic_store_u8(void/*uint8_t*/ *addr, uint8_t val);
 uint16_t emscripten_atomic_store_u16(void/*uint16_t*/ *addr, uint16_t val);
 uint32_t emscripten_atomic_store_u32(void/*uint32_t*/ *addr, uint32_t val);
 float emscripten_atomic_store_f32(void/*float*/ *addr, float val);
-uint64_t emscripten_atomic_store_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks, very slow!!
-double emscripten_atomic_store_f64(void/*double*/ *addr, double val); // Emulated with locks, very slow!!
+uint64_t emscripten_atomic_store_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
+double emscripten_atomic_store_f64(void/*double*/ *addr, double val); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
 
 void emscripten_atomic_fence();
 
@@ -56,32 +56,79 @@ void emscripten_atomic_fence();
 uint8_t emscripten_atomic_add_u8(void/*uint8_t*/ *addr, uint8_t val);
 uint16_t emscripten_atomic_add_u16(void/*uint16_t*/ *addr, uint16_t val);
 uint32_t emscripten_atomic_add_u32(void/*uint32_t*/ *addr, uint32_t val);
-uint64_t emscripten_atomic_add_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks, very slow!!
+uint64_t emscripten_atomic_add_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
 
 uint8_t emscripten_atomic_sub_u8(void/*uint8_t*/ *addr, uint8_t val);
 uint16_t emscripten_atomic_sub_u16(void/*uint16_t*/ *addr, uint16_t val);
 uint32_t emscripten_atomic_sub_u32(void/*uint32_t*/ *addr, uint32_t val);
-uint64_t emscripten_atomic_sub_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks, very slow!!
+uint64_t emscripten_atomic_sub_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
 
 uint8_t emscripten_atomic_and_u8(void/*uint8_t*/ *addr, uint8_t val);
 uint16_t emscripten_atomic_and_u16(void/*uint16_t*/ *addr, uint16_t val);
 uint32_t emscripten_atomic_and_u32(void/*uint32_t*/ *addr, uint32_t val);
-uint64_t emscripten_atomic_and_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks, very slow!!
+uint64_t emscripten_atomic_and_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
 
 uint8_t emscripten_atomic_or_u8(void/*uint8_t*/ *addr, uint8_t val);
 uint16_t emscripten_atomic_or_u16(void/*uint16_t*/ *addr, uint16_t val);
 uint32_t emscripten_atomic_or_u32(void/*uint32_t*/ *addr, uint32_t val);
-uint64_t emscripten_atomic_or_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks, very slow!!
+uint64_t emscripten_atomic_or_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
 
 uint8_t emscripten_atomic_xor_u8(void/*uint8_t*/ *addr, uint8_t val);
 uint16_t emscripten_atomic_xor_u16(void/*uint16_t*/ *addr, uint16_t val);
 uint32_t emscripten_atomic_xor_u32(void/*uint32_t*/ *addr, uint32_t val);
-uint64_t emscripten_atomic_xor_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks, very slow!!
+uint64_t emscripten_atomic_xor_u64(void/*uint64_t*/ *addr, uint64_t val); // Emulated with locks unless the target has native 64-bit atomics, see pthread/atomic_u64.c.
 
 int emscripten_futex_wait(void/*uint32_t*/ *addr, uint32_t val, double maxWaitMilliseconds);
 int emscripten_futex_wake(void/*uint32_t*/ *addr, int count);
 int emscripten_futex_wake_or_requeue(void/*uint32_t*/ *addr, int count, int cmpValue, void/*uint32_t*/ *addr2);
 
+// Contention statistics of the futex waits and wakes performed by the pthread synchronization primitives (mutexes,
+// condition variables, barriers, ...), summed over all threads. Direct calls to the emscripten_futex_* functions above
+// are not counted.
+typedef struct emscripten_futex_stats
+{
+  uint32_t waits; // Number of times a thread had to wait for a futex.
+  uint32_t timeouts; // Number of waits that timed out.
+  uint32_t wakes; // Number of wake operations that woke up at least one thread.
+  uint32_t threadsWoken; // Total number of threads woken up.
+  uint32_t requeues; // Number of condition variable broadcasts that moved their waiters over to the mutex.
+  double mainThreadWaitMsecs; // Time the main runtime thread has spent waiting, processing proxied calls meanwhile.
+} emscripten_futex_stats;
+
+void emscripten_futex_get_stats(emscripten_futex_stats *stats);
+void emscripten_futex_reset_stats(void);
+
+// pthread_create() runs each thread in a Web Worker taken from a pool of unused workers. A new worker must first load
+// and compile the whole application before it can run a thread, which can take hundreds of milliseconds, so the pool
+// can be filled ahead of time, either at startup with -s PTHREAD_POOL_SIZE=x, which delays running main() until the
+// workers have loaded, or with the functions below. They must be called on the main browser thread.
+
+// Asynchronously creates numWorkers new workers in the pool. Returns the number of workers created, 0 if threading is
+// not supported.
+int emscripten_pthread_pool_prewarm(int numWorkers);
+
+// Calls callback(userData) once all workers in the pool have finished loading, immediately if they already have.
+void emscripten_pthread_pool_when_ready(void (*callback)(void *userData), void *userData);
+
+// Terminates unused workers, the ones still loading first, until at most maxUnusedWorkers remain in the pool. Returns the
+// number of workers terminated.
+int emscripten_pthread_pool_shrink(int maxUnusedWorkers);
+
+typedef struct emscripten_pthread_pool_stats
+{
+  uint32_t numUnusedWorkers; // Workers in the pool, including the ones still loading.
+  uint32_t numLoadingWorkers; // Workers that have not yet finished loading, unused or not.
+  uint32_t numRunningWorkers; // Workers currently running a thread.
+  uint32_t workersCreated; // Total number of workers created.
+  uint32_t hits; // Threads started on an unused worker that had already loaded.
+  uint32_t misses; // Threads that had to wait for a worker to be created or to finish loading.
+  uint32_t threadsStarted; // Threads that have started running, the number of samples in the latencies below.
+  double averageStartLatencyMsecs; // Time from pthread_create() until the worker starts running the thread.
+  double maxStartLatencyMsecs;
+} emscripten_pthread_pool_stats;
+
+void emscripten_pthread_pool_get_stats(emscripten_pthread_pool_stats *stats);
+
 typedef union em_variant_val
 {
   int i;
@@ -98,14 +145,109 @@ typedef struct em_queued_call
   int operationDone;
   em_variant_val args[EM_QUEUED_CALL_MAX_ARGS];
   em_variant_val returnValue;
+  int calleeDelete; // If nonzero, the main thread frees this call with free() after executing it.
+  void *functionPtr; // If nonzero, 'function' is the EM_FUNC_SIGNATURE of this function, which is called instead of an EM_PROXIED_* operation.
 } em_queued_call;
 
 void emscripten_sync_run_in_main_thread(em_queued_call *call);
+void *emscripten_sync_run_in_main_thread_0(int function);
 void *emscripten_sync_run_in_main_thread_1(int function, void *arg1);
 void *emscripten_sync_run_in_main_thread_2(int function, void *arg1, void *arg2);
 void *emscripten_sync_run_in_main_thread_3(int function, void *arg1, void *arg2, void *arg3);
 void *emscripten_sync_run_in_main_thread_7(int function, void *arg1, void *arg2, void *arg3, void *arg4, void *arg5, void *arg6, void *arg7);
 
+// Queues the given call to be executed on the main runtime thread and returns immediately, without waiting for it to run.
+// Use these for calls whose return value is not needed. The call passed to emscripten_async_run_in_main_thread() must
+// have been allocated with malloc(); it is freed after it has executed. Any pointer arguments must stay valid until then.
+// Calls from the same thread are executed in the order they were queued.
+void emscripten_async_run_in_main_thread(em_queued_call *call);
+void emscripten_async_run_in_main_thread_0(int function);
+void emscripten_async_run_in_main_thread_1(int function, void *arg1);
+void emscripten_async_run_in_main_thread_2(int function, void *arg1, void *arg2);
+void emscripten_async_run_in_main_thread_3(int function, void *arg1, void *arg2, void *arg3);
+
+// Signatures of functions that can be proxied to the main runtime thread by pointer. A signature packs the return type,
+// the number of parameters and the type of each parameter. Only the combinations listed as EM_FUNC_SIG_* below are
+// supported: the first letter is the return type and the rest are the parameter types, where I stands for int and
+// pointer parameters, F for float and D for double.
+typedef int EM_FUNC_SIGNATURE;
+#define EM_FUNC_SIG_RETURN_VALUE_V 0
+#define EM_FUNC_SIG_RETURN_VALUE_I 1
+#define EM_FUNC_SIG_RETURN_VALUE_F 2
+#define EM_FUNC_SIG_RETURN_VALUE_D 3
+#define EM_FUNC_SIG_PARAM_I 0
+#define EM_FUNC_SIG_PARAM_F 1
+#define EM_FUNC_SIG_PARAM_D 2
+#define EM_FUNC_SIG_NUM_PARAMETERS_SHIFT 16
+#define EM_FUNC_SIG_RETURN_VALUE_SHIFT 20
+#define EM_FUNC_SIG_WITH_N_PARAMETERS(n) ((n) << EM_FUNC_SIG_NUM_PARAMETERS_SHIFT)
+#define EM_FUNC_SIG_WITH_RETURN_VALUE(type) ((type) << EM_FUNC_SIG_RETURN_VALUE_SHIFT)
+#define EM_FUNC_SIG_SET_PARAM(i, type) ((type) << (2*(i)))
+#define EM_FUNC_SIG_NUM_PARAMETERS(sig) (((sig) >> EM_FUNC_SIG_NUM_PARAMETERS_SHIFT) & 0xF)
+#define EM_FUNC_SIG_PARAM_TYPE(sig, i) (((sig) >> (2*(i))) & 0x3)
+#define EM_FUNC_SIG_RETURN_VALUE(sig) (((sig) >> EM_FUNC_SIG_RETURN_VALUE_SHIFT) & 0x3)
+
+#define EM_FUNC_SIG_V (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(0))
+#define EM_FUNC_SIG_VI (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(1))
+#define EM_FUNC_SIG_VII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(2))
+#define EM_FUNC_SIG_VIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(3))
+#define EM_FUNC_SIG_VIIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(4))
+#define EM_FUNC_SIG_VIIIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(5))
+#define EM_FUNC_SIG_VIIIIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(6))
+#define EM_FUNC_SIG_VIIIIIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(7))
+#define EM_FUNC_SIG_I (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_I) | EM_FUNC_SIG_WITH_N_PARAMETERS(0))
+#define EM_FUNC_SIG_II (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_I) | EM_FUNC_SIG_WITH_N_PARAMETERS(1))
+#define EM_FUNC_SIG_III (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_I) | EM_FUNC_SIG_WITH_N_PARAMETERS(2))
+#define EM_FUNC_SIG_IIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_I) | EM_FUNC_SIG_WITH_N_PARAMETERS(3))
+#define EM_FUNC_SIG_IIIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_I) | EM_FUNC_SIG_WITH_N_PARAMETERS(4))
+#define EM_FUNC_SIG_IIIIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_I) | EM_FUNC_SIG_WITH_N_PARAMETERS(5))
+#define EM_FUNC_SIG_IIIIIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_I) | EM_FUNC_SIG_WITH_N_PARAMETERS(6))
+#define EM_FUNC_SIG_IIIIIIII (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_I) | EM_FUNC_SIG_WITH_N_PARAMETERS(7))
+#define EM_FUNC_SIG_VF (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(1) | EM_FUNC_SIG_SET_PARAM(0, EM_FUNC_SIG_PARAM_F))
+#define EM_FUNC_SIG_VFF (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(2) | EM_FUNC_SIG_SET_PARAM(0, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_F))
+#define EM_FUNC_SIG_VFFF (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(3) | EM_FUNC_SIG_SET_PARAM(0, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(2, EM_FUNC_SIG_PARAM_F))
+#define EM_FUNC_SIG_VFFFF (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(4) | EM_FUNC_SIG_SET_PARAM(0, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(2, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(3, EM_FUNC_SIG_PARAM_F))
+#define EM_FUNC_SIG_VIF (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(2) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_F))
+#define EM_FUNC_SIG_VIFF (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(3) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(2, EM_FUNC_SIG_PARAM_F))
+#define EM_FUNC_SIG_VIFFF (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(4) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(2, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(3, EM_FUNC_SIG_PARAM_F))
+#define EM_FUNC_SIG_VIFFFF (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(5) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(2, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(3, EM_FUNC_SIG_PARAM_F) | EM_FUNC_SIG_SET_PARAM(4, EM_FUNC_SIG_PARAM_F))
+#define EM_FUNC_SIG_VD (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(1) | EM_FUNC_SIG_SET_PARAM(0, EM_FUNC_SIG_PARAM_D))
+#define EM_FUNC_SIG_VDD (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(2) | EM_FUNC_SIG_SET_PARAM(0, EM_FUNC_SIG_PARAM_D) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_D))
+#define EM_FUNC_SIG_VID (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(2) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_D))
+#define EM_FUNC_SIG_VIDD (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_V) | EM_FUNC_SIG_WITH_N_PARAMETERS(3) | EM_FUNC_SIG_SET_PARAM(1, EM_FUNC_SIG_PARAM_D) | EM_FUNC_SIG_SET_PARAM(2, EM_FUNC_SIG_PARAM_D))
+#define EM_FUNC_SIG_F (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_F) | EM_FUNC_SIG_WITH_N_PARAMETERS(0))
+#define EM_FUNC_SIG_FI (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_F) | EM_FUNC_SIG_WITH_N_PARAMETERS(1))
+#define EM_FUNC_SIG_D (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_D) | EM_FUNC_SIG_WITH_N_PARAMETERS(0))
+#define EM_FUNC_SIG_DI (EM_FUNC_SIG_WITH_RETURN_VALUE(EM_FUNC_SIG_RETURN_VALUE_D) | EM_FUNC_SIG_WITH_N_PARAMETERS(1))
+
+// Calls the given function with the given arguments on the main runtime thread and waits for it to finish. The result is
+// in the member of the returned em_variant_val that matches the return type of the signature.
+em_variant_val emscripten_sync_run_in_main_runtime_thread_(EM_FUNC_SIGNATURE sig, void *func_ptr, ...);
+#define emscripten_sync_run_in_main_runtime_thread(sig, func_ptr, ...) emscripten_sync_run_in_main_runtime_thread_((sig), (void*)(func_ptr), ##__VA_ARGS__)
+
+// Queues a call to the given function on the main runtime thread and returns immediately. The return value of the
+// function is discarded.
+void emscripten_async_run_in_main_runtime_thread_(EM_FUNC_SIGNATURE sig, void *func_ptr, ...);
+#define emscripten_async_run_in_main_runtime_thread(sig, func_ptr, ...) emscripten_async_run_in_main_runtime_thread_((sig), (void*)(func_ptr), ##__VA_ARGS__)
+
+// Like emscripten_async_run_in_main_runtime_thread(), but does not wake up the main thread. Queue any number of calls
+// this way and then call emscripten_main_runtime_thread_flush_batched_calls() to have them all processed with a single
+// wakeup. The main thread may also pick them up earlier, when it processes calls queued by other means.
+void emscripten_async_batched_run_in_main_runtime_thread_(EM_FUNC_SIGNATURE sig, void *func_ptr, ...);
+#define emscripten_async_batched_run_in_main_runtime_thread(sig, func_ptr, ...) emscripten_async_batched_run_in_main_runtime_thread_((sig), (void*)(func_ptr), ##__VA_ARGS__)
+void emscripten_main_runtime_thread_flush_batched_calls(void);
+
+// Queues a call to the given function on the main runtime thread and returns a handle to it, which acts as a future:
+// emscripten_wait_for_call() waits for the call to finish and fetches its result. Every handle must be released with
+// emscripten_async_waitable_close(), which waits for the call to finish if it has not yet.
+em_queued_call *emscripten_async_waitable_run_in_main_runtime_thread_(EM_FUNC_SIGNATURE sig, void *func_ptr, ...);
+#define emscripten_async_waitable_run_in_main_runtime_thread(sig, func_ptr, ...) emscripten_async_waitable_run_in_main_runtime_thread_((sig), (void*)(func_ptr), ##__VA_ARGS__)
+
+// Waits up to timeoutMSecs milliseconds (pass INFINITY to wait indefinitely) for the given call to finish. Returns 1 and
+// stores the result of the call to outResult (if not null) if it finished, or 0 if the wait timed out.
+int emscripten_wait_for_call(em_queued_call *call, double timeoutMSecs, em_variant_val *outResult);
+void emscripten_async_waitable_close(em_queued_call *call);
+
 // Returns 1 if the current thread is the thread that hosts the Emscripten runtime.
 int emscripten_is_main_runtime_thread(void);
 
@@ -2,6 +2,7 @@
 #define __emscripten_trace__h__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -89,6 +90,19 @@ void emscripten_trace_close(void);
 
 #endif
 
+// Sampling heap profiler, available when linking with -s HEAP_PROFILER=1. A sample of the allocations, about one per
+// sample interval bytes allocated, is recorded together with the callstack of the allocation. Build with
+// --profiling-funcs to get readable function names in the callstacks.
+
+// Sets the average number of bytes allocated between two samples. The default is 512KB. Pass 0 to stop sampling.
+void emscripten_heap_profiler_set_sample_interval(size_t bytes);
+
+// Writes a profile of the sampled allocations that are still in use, and of all sampled allocations so far, to out as
+// a null-terminated string, truncated to maxbytes. The profile is in the legacy pprof heap profile format with the
+// symbols included, so pprof can read it without the binary, e.g. "pprof --text heap.prof". Returns the size of the
+// whole profile including the null terminator; pass maxbytes 0 to query it.
+size_t emscripten_heap_profiler_dump(char *out, size_t maxbytes);
+
 #ifdef __cplusplus
 } // ~extern "C"
 #endif
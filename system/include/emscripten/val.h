@@ -10,6 +10,9 @@ namespace emscripten {
 
     class val;
 
+    template<typename T>
+    class wrapper;
+
     namespace internal {
 
         template<typename WrapperType>
@@ -80,6 +83,22 @@ namespace emscripten {
                 EM_VAL handle,
                 const char* methodName,
                 EM_VAR_ARGS argv);
+
+            // Dispatch tables cache, per JS object, the functions found by
+            // method name, so repeated calls skip reading the name from the
+            // heap and looking it up on the object.
+            EM_VAL _emval_create_dispatch_table(EM_VAL object);
+            EM_GENERIC_WIRE_TYPE _emval_dispatch_method(
+                EM_METHOD_CALLER caller,
+                EM_VAL dispatchTable,
+                const char* methodName,
+                EM_DESTRUCTORS* destructors,
+                EM_VAR_ARGS argv);
+            void _emval_dispatch_void_method(
+                EM_METHOD_CALLER caller,
+                EM_VAL dispatchTable,
+                const char* methodName,
+                EM_VAR_ARGS argv);
             EM_VAL _emval_typeof(EM_VAL value);
         }
 
@@ -257,6 +276,38 @@ namespace emscripten {
                     argv);
             }
         };
+
+        template<typename ReturnType, typename... Args>
+        struct DispatchedMethodCaller {
+            static ReturnType call(EM_VAL dispatchTable, const char* methodName, Args&&... args) {
+                auto caller = Signature<ReturnType, Args...>::get_method_caller();
+
+                WireTypePack<Args...> argv(std::forward<Args>(args)...);
+                EM_DESTRUCTORS destructors;
+                EM_GENERIC_WIRE_TYPE result = _emval_dispatch_method(
+                    caller,
+                    dispatchTable,
+                    methodName,
+                    &destructors,
+                    argv);
+                DestructorsRunner rd(destructors);
+                return fromGenericWireType<ReturnType>(result);
+            }
+        };
+
+        template<typename... Args>
+        struct DispatchedMethodCaller<void, Args...> {
+            static void call(EM_VAL dispatchTable, const char* methodName, Args&&... args) {
+                auto caller = Signature<void, Args...>::get_method_caller();
+
+                WireTypePack<Args...> argv(std::forward<Args>(args)...);
+                _emval_dispatch_void_method(
+                    caller,
+                    dispatchTable,
+                    methodName,
+                    argv);
+            }
+        };
     }
 
 #define EMSCRIPTEN_SYMBOL(name)                                         \
@@ -443,6 +494,9 @@ namespace emscripten {
         template<typename WrapperType>
         friend val internal::wrapped_extend(const std::string& , const val& );
 
+        template<typename T>
+        friend class wrapper;
+
         internal::EM_VAL __get_handle() const {
             return handle;
         }
@@ -15,6 +15,16 @@
 #define USE_SPIN_LOCKS 0 // Ensure we use pthread_mutex_t.
 #endif
 
+/* With THREAD_CACHE, malloc() and free() go through per-thread caches of small chunks, see "thread caches" below. */
+#if THREAD_CACHE && !__EMSCRIPTEN_PTHREADS__
+#error "THREAD_CACHE requires a pthreads build"
+#endif
+
+/* With HEAP_PROFILER, a sample of allocations is recorded with their callstacks, see "heap profiler" below. */
+#if HEAP_PROFILER && THREAD_CACHE
+#error "HEAP_PROFILER cannot be combined with THREAD_CACHE"
+#endif
+
 #endif
 
 
@@ -839,8 +849,14 @@ extern "C" {
     
 #ifndef USE_DL_PREFIX
 #define dlcalloc               calloc
+#if THREAD_CACHE
+/* XXX Emscripten: malloc and free are defined in front of the heap, see "thread caches" below. */
+#define dlfree                 __dl_heap_free
+#define dlmalloc               __dl_heap_malloc
+#else
 #define dlfree                 free
 #define dlmalloc               malloc
+#endif
 #define dlmemalign             memalign
 #define dlposix_memalign       posix_memalign
 #define dlrealloc              realloc
@@ -4561,6 +4577,13 @@ static void* tmalloc_small(mstate m, size_t nb) {
     return 0;
 }
 
+#if HEAP_PROFILER && !ONLY_MSPACES
+static int heap_profiler_should_sample(size_t bytes);
+static void heap_profiler_record_allocation(void* mem, size_t bytes);
+static void heap_profiler_record_free(void* mem);
+static void heap_profiler_forget(void* mem);
+#endif /* HEAP_PROFILER */
+
 #if !ONLY_MSPACES
 
 void* dlmalloc(size_t bytes) {
@@ -4594,6 +4617,9 @@ void* dlmalloc(size_t bytes) {
     if (!PREACTION(gm)) {
         void* mem;
         size_t nb;
+#if HEAP_PROFILER
+        int sampled;
+#endif
         if (bytes <= MAX_SMALL_REQUEST) {
             bindex_t idx;
             binmap_t smallbits;
@@ -4692,10 +4718,20 @@ void* dlmalloc(size_t bytes) {
         mem = sys_alloc(gm, nb);
         
     postaction:
+#if HEAP_PROFILER
+        /* XXX Emscripten: sampled chunks are marked under the lock, and recorded after it. */
+        sampled = mem != 0 && heap_profiler_should_sample(bytes);
+        if (sampled)
+            set_flag4(mem2chunk(mem));
+#endif
         POSTACTION(gm);
 #if __EMSCRIPTEN__
         /* XXX Emscripten Tracing API. */
         emscripten_trace_record_allocation(mem, bytes);
+#endif
+#if HEAP_PROFILER
+        if (sampled)
+            heap_profiler_record_allocation(mem, bytes);
 #endif
         return mem;
     }
@@ -4716,6 +4752,10 @@ void dlfree(void* mem) {
 #if __EMSCRIPTEN__
         /* XXX Emscripten Tracing API. */
         emscripten_trace_record_free(mem);
+#endif
+#if HEAP_PROFILER
+        if (flag4inuse(mem2chunk(mem)))
+            heap_profiler_record_free(mem);
 #endif
         mchunkptr p  = mem2chunk(mem);
 #if FOOTERS
@@ -4919,6 +4959,9 @@ static mchunkptr try_realloc_chunk(mstate m, mchunkptr p, size_t nb,
 
 static void* internal_memalign(mstate m, size_t alignment, size_t bytes) {
     void* mem = 0;
+#if HEAP_PROFILER && !ONLY_MSPACES
+    int sampled;
+#endif
     if (alignment <  MIN_CHUNK_SIZE) /* must be at least a minimum chunk size */
         alignment = MIN_CHUNK_SIZE;
     if ((alignment & (alignment-SIZE_T_ONE)) != 0) {/* Ensure a power of 2 */
@@ -4937,6 +4980,11 @@ static void* internal_memalign(mstate m, size_t alignment, size_t bytes) {
         mem = internal_malloc(m, req);
         if (mem != 0) {
             mchunkptr p = mem2chunk(mem);
+#if HEAP_PROFILER && !ONLY_MSPACES
+            /* XXX Emscripten: the padded chunk is not a sample, the aligned one is sampled below. */
+            if (flag4inuse(p))
+                heap_profiler_forget(mem);
+#endif
             if (PREACTION(m))
                 return 0;
             if ((((size_t)(mem)) & (alignment - 1)) != 0) { /* misaligned */
@@ -4985,7 +5033,17 @@ static void* internal_memalign(mstate m, size_t alignment, size_t bytes) {
             assert (chunksize(p) >= nb);
             assert(((size_t)mem & (alignment - 1)) == 0);
             check_inuse_chunk(m, p);
+#if HEAP_PROFILER && !ONLY_MSPACES
+            clear_flag4(p);
+            sampled = heap_profiler_should_sample(bytes);
+            if (sampled)
+                set_flag4(p);
+#endif
             POSTACTION(m);
+#if HEAP_PROFILER && !ONLY_MSPACES
+            if (sampled)
+                heap_profiler_record_allocation(mem, bytes);
+#endif
         }
     }
     return mem;
@@ -5228,6 +5286,12 @@ void* dlrealloc(void* oldmem, size_t bytes) {
     else {
         size_t nb = request2size(bytes);
         mchunkptr oldp = mem2chunk(oldmem);
+#if HEAP_PROFILER
+        /* XXX Emscripten: a chunk resized in place is sampled anew. A moved
+           chunk is sampled by malloc(), and the old one unrecorded by free(). */
+        int was_sampled = flag4inuse(oldp) != 0;
+        int resized = 0, sampled = 0;
+#endif
 #if ! FOOTERS
         mstate m = gm;
 #else /* FOOTERS */
@@ -5239,6 +5303,15 @@ void* dlrealloc(void* oldmem, size_t bytes) {
 #endif /* FOOTERS */
         if (!PREACTION(m)) {
             mchunkptr newp = try_realloc_chunk(m, oldp, nb, 1);
+#if HEAP_PROFILER
+            if (newp != 0) {
+                resized = 1;
+                clear_flag4(newp);
+                sampled = heap_profiler_should_sample(bytes);
+                if (sampled)
+                    set_flag4(newp);
+            }
+#endif
             POSTACTION(m);
             if (newp != 0) {
                 check_inuse_chunk(m, newp);
@@ -5253,6 +5326,12 @@ void* dlrealloc(void* oldmem, size_t bytes) {
                 }
             }
         }
+#if HEAP_PROFILER
+        if (resized && was_sampled)
+            heap_profiler_record_free(oldmem);
+        if (sampled)
+            heap_profiler_record_allocation(mem, bytes);
+#endif
 #if __EMSCRIPTEN__
         /* XXX Emscripten Tracing API. */
         emscripten_trace_record_reallocation(oldmem, mem, bytes);
@@ -5270,6 +5349,11 @@ void* dlrealloc_in_place(void* oldmem, size_t bytes) {
         else {
             size_t nb = request2size(bytes);
             mchunkptr oldp = mem2chunk(oldmem);
+#if HEAP_PROFILER
+            /* XXX Emscripten: a chunk resized in place is sampled anew, as in dlrealloc(). */
+            int was_sampled = flag4inuse(oldp) != 0;
+            int sampled = 0;
+#endif
 #if ! FOOTERS
             mstate m = gm;
 #else /* FOOTERS */
@@ -5281,10 +5365,24 @@ void* dlrealloc_in_place(void* oldmem, size_t bytes) {
 #endif /* FOOTERS */
             if (!PREACTION(m)) {
                 mchunkptr newp = try_realloc_chunk(m, oldp, nb, 0);
+#if HEAP_PROFILER
+                if (newp == oldp) {
+                    clear_flag4(newp);
+                    sampled = heap_profiler_should_sample(bytes);
+                    if (sampled)
+                        set_flag4(newp);
+                }
+#endif
                 POSTACTION(m);
                 if (newp == oldp) {
                     check_inuse_chunk(m, newp);
                     mem = oldmem;
+#if HEAP_PROFILER
+                    if (was_sampled)
+                        heap_profiler_record_free(oldmem);
+                    if (sampled)
+                        heap_profiler_record_allocation(mem, bytes);
+#endif
                 }
             }
         }
@@ -5348,6 +5446,13 @@ void** dlindependent_comalloc(size_t n_elements, size_t sizes[],
 }
 
 size_t dlbulk_free(void* array[], size_t nelem) {
+#if HEAP_PROFILER
+    size_t i;
+    for (i = 0; i < nelem; ++i) {
+        if (array[i] != 0 && flag4inuse(mem2chunk(array[i])))
+            heap_profiler_record_free(array[i]);
+    }
+#endif
     return internal_bulk_free(gm, array, nelem);
 }
 
@@ -5426,6 +5531,632 @@ size_t dlmalloc_usable_size(void* mem) {
 
 #endif /* !ONLY_MSPACES */
 
+/* --------------------------- thread caches ---------------------------- */
+
+#if THREAD_CACHE && !ONLY_MSPACES
+
+/*
+ XXX Emscripten: Per-thread caches of small chunks in front of the locked heap.
+
+ Each thread keeps a singly linked free list for each chunk size up to
+ THREAD_CACHE_MAX_CHUNK. malloc() and free() of small sizes only touch
+ the list of the calling thread, and do not take the heap lock. An empty
+ list is refilled with THREAD_CACHE_BATCH chunks from one call to
+ independent_comalloc, and a list that grows beyond
+ THREAD_CACHE_MAX_COUNT returns THREAD_CACHE_BATCH chunks with one call
+ to bulk_free. The heap lock is thus taken once per batch rather than
+ once per call. Chunks can be freed by any thread, and a thread's cache
+ is returned to the heap when the thread exits, or at exit() for the main
+ thread. After that, the thread's calls go straight to the heap.
+
+ Cached chunks still count as in use in mallinfo() and malloc_stats().
+*/
+
+#include <pthread.h>
+#include <emscripten/threading.h>
+
+#define THREAD_CACHE_MAX_CHUNK ((size_t)256U)
+#define THREAD_CACHE_NUM_BINS  ((THREAD_CACHE_MAX_CHUNK >> 3) + 1)
+#define THREAD_CACHE_BATCH     32
+#define THREAD_CACHE_MAX_COUNT (2 * THREAD_CACHE_BATCH)
+#define MAX_CACHED_REQUEST     (THREAD_CACHE_MAX_CHUNK - CHUNK_OVERHEAD)
+
+struct thread_cache_bin {
+    void* head;
+    size_t count;
+};
+
+struct thread_cache {
+    struct thread_cache_bin bins[THREAD_CACHE_NUM_BINS]; /* indexed by chunk size / 8 */
+};
+
+/* The value of thread_cache_key once the thread's cache has been destroyed. */
+#define THREAD_CACHE_DESTROYED ((struct thread_cache*)-1)
+
+static pthread_key_t thread_cache_key;
+static pthread_once_t thread_cache_once = PTHREAD_ONCE_INIT;
+
+static void thread_cache_release(struct thread_cache_bin* bin, size_t n) {
+    void* chunks[THREAD_CACHE_MAX_COUNT];
+    size_t i;
+    for (i = 0; i < n && bin->head != 0; ++i) {
+        chunks[i] = bin->head;
+        bin->head = *(void**)bin->head;
+    }
+    bin->count -= i;
+    dlbulk_free(chunks, i);
+}
+
+static void thread_cache_refill(struct thread_cache_bin* bin, size_t nb) {
+    size_t sizes[THREAD_CACHE_BATCH];
+    void* chunks[THREAD_CACHE_BATCH];
+    size_t i;
+    for (i = 0; i < THREAD_CACHE_BATCH; ++i)
+        sizes[i] = nb - CHUNK_OVERHEAD; /* pads back to exactly nb */
+    if (dlindependent_comalloc(THREAD_CACHE_BATCH, sizes, chunks) == 0)
+        return;
+    for (i = 0; i < THREAD_CACHE_BATCH; ++i) {
+        *(void**)chunks[i] = bin->head;
+        bin->head = chunks[i];
+    }
+    bin->count += THREAD_CACHE_BATCH;
+}
+
+static void thread_cache_destroy(void* arg) {
+    struct thread_cache* tc = (struct thread_cache*)arg;
+    size_t i;
+    /* Destructors of other keys may still call malloc() and free(). The
+       marker keeps them from creating a new cache that would never be
+       destroyed. Setting it makes this run again with the marker, which it
+       sets once more, until PTHREAD_DESTRUCTOR_ITERATIONS is reached. */
+    pthread_setspecific(thread_cache_key, THREAD_CACHE_DESTROYED);
+    if (tc == THREAD_CACHE_DESTROYED)
+        return;
+    for (i = 0; i < THREAD_CACHE_NUM_BINS; ++i) {
+        while (tc->bins[i].head != 0)
+            thread_cache_release(&tc->bins[i], THREAD_CACHE_MAX_COUNT);
+    }
+    dlfree(tc);
+}
+
+/* Key destructors only run when a pthread exits, not for the main thread. */
+static void thread_cache_destroy_main(void) {
+    thread_cache_destroy(pthread_getspecific(thread_cache_key));
+}
+
+static void thread_cache_create_key(void) {
+    pthread_key_create(&thread_cache_key, thread_cache_destroy);
+}
+
+static struct thread_cache* get_thread_cache(void) {
+    struct thread_cache* tc;
+    pthread_once(&thread_cache_once, thread_cache_create_key);
+    tc = (struct thread_cache*)pthread_getspecific(thread_cache_key);
+    if (tc == THREAD_CACHE_DESTROYED)
+        return 0;
+    if (tc == 0) {
+        tc = (struct thread_cache*)dlcalloc(1, sizeof(struct thread_cache));
+        if (tc != 0) {
+            pthread_setspecific(thread_cache_key, tc);
+            if (emscripten_is_main_runtime_thread())
+                atexit(thread_cache_destroy_main);
+        }
+    }
+    return tc;
+}
+
+DLMALLOC_EXPORT void* malloc(size_t bytes) {
+    if (bytes <= MAX_CACHED_REQUEST) {
+        struct thread_cache* tc = get_thread_cache();
+        if (tc != 0) {
+            size_t nb = request2size(bytes);
+            struct thread_cache_bin* bin = &tc->bins[nb >> 3];
+            if (bin->head == 0)
+                thread_cache_refill(bin, nb);
+            if (bin->head != 0) {
+                void* mem = bin->head;
+                bin->head = *(void**)mem;
+                --bin->count;
+                return mem;
+            }
+        }
+    }
+    return dlmalloc(bytes);
+}
+
+DLMALLOC_EXPORT void free(void* mem) {
+    if (mem != 0) {
+        size_t size = chunksize(mem2chunk(mem));
+        if (size <= THREAD_CACHE_MAX_CHUNK) {
+            struct thread_cache* tc = get_thread_cache();
+            if (tc != 0) {
+                struct thread_cache_bin* bin = &tc->bins[size >> 3];
+                *(void**)mem = bin->head;
+                bin->head = mem;
+                if (++bin->count > THREAD_CACHE_MAX_COUNT)
+                    thread_cache_release(bin, THREAD_CACHE_BATCH);
+                return;
+            }
+        }
+        dlfree(mem);
+    }
+}
+
+#endif /* THREAD_CACHE */
+
+/* ---------------------------- heap profiler ---------------------------- */
+
+#if HEAP_PROFILER && !ONLY_MSPACES
+
+/*
+ XXX Emscripten: Sampling heap profiler.
+
+ On average one allocation per heap_profiler.interval bytes allocated is
+ sampled. The distance in bytes between two samples is drawn from an
+ exponential distribution, so the chance of an allocation being sampled
+ is proportional to its size. Sampled chunks are marked with FLAG4_BIT
+ while the heap lock is held, so that free() only looks up chunks that
+ were sampled. After the heap lock is released the sample is recorded
+ with the callstack of the allocation, captured with
+ emscripten_get_callstack().
+
+ The profiler allocates its tables from the heap itself. Allocations made
+ while the profiler holds its lock are never sampled.
+
+ emscripten_heap_profiler_dump() writes the sampled allocations per
+ callstack in the legacy pprof heap profile format ("heap_v2"), which
+ pprof unsamples with the sample interval. Symbols are included in the
+ profile, so pprof does not need the binary to read it.
+*/
+
+#include <emscripten/emscripten.h>
+#include <math.h>
+#include <stdarg.h>
+
+#define HEAP_PROFILER_DEFAULT_INTERVAL ((size_t)512U * 1024U)
+#define HEAP_PROFILER_MAX_DEPTH        64
+#define HEAP_PROFILER_CALLSTACK_BYTES  8192
+#define HEAP_PROFILER_MIN_INDEX_SIZE   256
+
+struct heap_profiler_stack {
+    unsigned int hash;
+    unsigned int depth;
+    unsigned int* frames;  /* symbol ids, innermost frame first */
+    size_t live_count;     /* sampled allocations that are still in use */
+    size_t live_bytes;
+    size_t total_count;    /* all sampled allocations */
+    size_t total_bytes;
+};
+
+struct heap_profiler_sample {
+    void* mem;             /* 0 if the slot is empty */
+    unsigned int stack;
+    size_t bytes;
+};
+
+/*
+ interval, countdown, random and internal are read by the sampling decision,
+ which runs with the heap lock held, so they are only accessed under the heap
+ lock. The rest of the state is guarded by heap_profiler_mutex, which may be
+ held while taking the heap lock but not the other way around.
+*/
+static struct heap_profiler_state {
+    size_t interval;       /* 0 if sampling is disabled */
+    size_t countdown;      /* bytes to allocate until the next sample, 0 if not drawn yet */
+    unsigned int random;
+    int internal;          /* set while the profiler allocates its own tables */
+    char** symbols;        /* function names, by symbol id */
+    unsigned int num_symbols;
+    unsigned int max_symbols;
+    unsigned int* symbol_index; /* open addressing hash table of symbol ids + 1 */
+    unsigned int symbol_index_size;
+    struct heap_profiler_stack* stacks;
+    unsigned int num_stacks;
+    unsigned int max_stacks;
+    unsigned int* stack_index;  /* open addressing hash table of stack ids + 1 */
+    unsigned int stack_index_size;
+    struct heap_profiler_sample* samples; /* open addressing hash table keyed by address */
+    size_t num_samples;
+    size_t samples_size;
+} heap_profiler = { HEAP_PROFILER_DEFAULT_INTERVAL, 0, 0x2545F491U };
+
+#if USE_LOCKS
+static MLOCK_T heap_profiler_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static unsigned int heap_profiler_hash_bytes(const char* bytes, size_t n, unsigned int hash) {
+    size_t i;
+    for (i = 0; i < n; ++i)
+        hash = (hash ^ (unsigned char)bytes[i]) * 16777619U; /* FNV-1a */
+    return hash;
+}
+
+static unsigned int heap_profiler_hash_address(void* mem) {
+    return (unsigned int)(((size_t)mem >> 3) * 2654435761U);
+}
+
+static size_t heap_profiler_next_countdown(void) {
+    double u, next;
+    heap_profiler.random ^= heap_profiler.random << 13; /* xorshift32 */
+    heap_profiler.random ^= heap_profiler.random >> 17;
+    heap_profiler.random ^= heap_profiler.random << 5;
+    u = ((heap_profiler.random >> 8) + 0.5) / 16777216.0; /* uniform in ]0, 1[ */
+    next = -log(u) * (double)heap_profiler.interval + 1.0;
+    return next < (double)(MAX_SIZE_T >> 1) ? (size_t)next : (MAX_SIZE_T >> 1);
+}
+
+/* Called with the heap lock held. */
+static int heap_profiler_should_sample(size_t bytes) {
+    if (heap_profiler.interval == 0 || heap_profiler.internal)
+        return 0;
+    if (heap_profiler.countdown == 0)
+        heap_profiler.countdown = heap_profiler_next_countdown();
+    if (bytes < heap_profiler.countdown) {
+        heap_profiler.countdown -= bytes;
+        return 0;
+    }
+    heap_profiler.countdown = heap_profiler_next_countdown();
+    return 1;
+}
+
+/* Doubles the size of an open addressing table of ids + 1. */
+static int heap_profiler_grow_index(unsigned int** index, unsigned int* size, unsigned int count, unsigned int (*hash_of)(unsigned int)) {
+    unsigned int new_size = *size ? *size * 2 : HEAP_PROFILER_MIN_INDEX_SIZE;
+    unsigned int* new_index = (unsigned int*)dlcalloc(new_size, sizeof(unsigned int));
+    unsigned int i;
+    if (new_index == 0)
+        return 0;
+    for (i = 0; i < count; ++i) {
+        unsigned int slot = hash_of(i) & (new_size - 1);
+        while (new_index[slot] != 0)
+            slot = (slot + 1) & (new_size - 1);
+        new_index[slot] = i + 1;
+    }
+    dlfree(*index);
+    *index = new_index;
+    *size = new_size;
+    return 1;
+}
+
+static unsigned int heap_profiler_symbol_hash(unsigned int id) {
+    const char* name = heap_profiler.symbols[id];
+    return heap_profiler_hash_bytes(name, strlen(name), 2166136261U);
+}
+
+static unsigned int heap_profiler_stack_hash(unsigned int id) {
+    return heap_profiler.stacks[id].hash;
+}
+
+/* Returns the id of the symbol with the given name, or -1 if out of memory. */
+static unsigned int heap_profiler_symbol(const char* name, size_t length) {
+    unsigned int hash = heap_profiler_hash_bytes(name, length, 2166136261U);
+    unsigned int slot;
+    char* copy;
+    if (heap_profiler.symbol_index_size != 0) {
+        for (slot = hash & (heap_profiler.symbol_index_size - 1);
+             heap_profiler.symbol_index[slot] != 0;
+             slot = (slot + 1) & (heap_profiler.symbol_index_size - 1)) {
+            const char* symbol = heap_profiler.symbols[heap_profiler.symbol_index[slot] - 1];
+            if (strncmp(symbol, name, length) == 0 && symbol[length] == 0)
+                return heap_profiler.symbol_index[slot] - 1;
+        }
+    }
+    if (heap_profiler.num_symbols == heap_profiler.max_symbols) {
+        unsigned int max = heap_profiler.max_symbols ? heap_profiler.max_symbols * 2 : HEAP_PROFILER_MIN_INDEX_SIZE / 2;
+        char** symbols = (char**)dlrealloc(heap_profiler.symbols, max * sizeof(char*));
+        if (symbols == 0)
+            return (unsigned int)-1;
+        heap_profiler.symbols = symbols;
+        heap_profiler.max_symbols = max;
+    }
+    if (2 * (heap_profiler.num_symbols + 1) > heap_profiler.symbol_index_size &&
+        !heap_profiler_grow_index(&heap_profiler.symbol_index, &heap_profiler.symbol_index_size,
+                                  heap_profiler.num_symbols, heap_profiler_symbol_hash))
+        return (unsigned int)-1;
+    copy = (char*)dlmalloc(length + 1);
+    if (copy == 0)
+        return (unsigned int)-1;
+    memcpy(copy, name, length);
+    copy[length] = 0;
+    heap_profiler.symbols[heap_profiler.num_symbols] = copy;
+    for (slot = hash & (heap_profiler.symbol_index_size - 1);
+         heap_profiler.symbol_index[slot] != 0;
+         slot = (slot + 1) & (heap_profiler.symbol_index_size - 1))
+        ;
+    heap_profiler.symbol_index[slot] = ++heap_profiler.num_symbols;
+    return heap_profiler.num_symbols - 1;
+}
+
+/* Frames of the allocator itself, skipped at the top of captured callstacks. */
+static int heap_profiler_is_allocator_frame(const char* name, size_t length) {
+    static const char* const allocator_functions[] = {
+        "_malloc", "_calloc", "_realloc", "_realloc_in_place", "_memalign", "_posix_memalign", "_valloc",
+        "_pvalloc", "_dlmalloc", "_dlcalloc", "_dlrealloc", "_dlrealloc_in_place", "_dlmemalign",
+        "_dlposix_memalign", "_dlvalloc", "_dlpvalloc", "_internal_memalign", "_emscripten_get_callstack", 0
+    };
+    size_t i;
+    if (length >= 14 && strncmp(name, "_heap_profiler", 14) == 0)
+        return 1;
+    for (i = 0; allocator_functions[i] != 0; ++i) {
+        if (strncmp(name, allocator_functions[i], length) == 0 && allocator_functions[i][length] == 0)
+            return 1;
+    }
+    return 0;
+}
+
+/* Captures the callstack of the current allocation as symbol ids, returns its depth. */
+static unsigned int heap_profiler_capture(unsigned int* frames) {
+    static char callstack[HEAP_PROFILER_CALLSTACK_BYTES]; /* guarded by heap_profiler_mutex */
+    unsigned int depth = 0;
+    int skipping = 1;
+    char* line = callstack;
+    emscripten_get_callstack(EM_LOG_JS_STACK | EM_LOG_DEMANGLE | EM_LOG_NO_PATHS, callstack, sizeof(callstack));
+    /* Each line is of the form "    at function (file:line:column)". */
+    while (*line != 0 && depth < HEAP_PROFILER_MAX_DEPTH) {
+        char* end = strchr(line, '\n');
+        char* name = line;
+        char* name_end;
+        if (end == 0)
+            end = line + strlen(line);
+        while (name < end && *name == ' ')
+            ++name;
+        if (end - name > 3 && strncmp(name, "at ", 3) == 0) {
+            name += 3;
+            for (name_end = end - 1; name_end > name && !(name_end[0] == '(' && name_end[-1] == ' '); --name_end)
+                ;
+            name_end = name_end > name ? name_end - 1 : end;
+            if (!skipping || !heap_profiler_is_allocator_frame(name, name_end - name)) {
+                unsigned int symbol = heap_profiler_symbol(name, name_end - name);
+                if (symbol == (unsigned int)-1)
+                    break;
+                frames[depth++] = symbol;
+                skipping = 0;
+            }
+        }
+        line = *end != 0 ? end + 1 : end;
+    }
+    if (depth == 0) {
+        unsigned int symbol = heap_profiler_symbol("<unknown>", 9);
+        if (symbol != (unsigned int)-1)
+            frames[depth++] = symbol;
+    }
+    return depth;
+}
+
+/* Returns the id of the stack with the given frames, or -1 if out of memory. */
+static unsigned int heap_profiler_stack(unsigned int* frames, unsigned int depth) {
+    unsigned int hash = heap_profiler_hash_bytes((const char*)frames, depth * sizeof(unsigned int), 2166136261U);
+    unsigned int slot;
+    struct heap_profiler_stack* stack;
+    if (heap_profiler.stack_index_size != 0) {
+        for (slot = hash & (heap_profiler.stack_index_size - 1);
+             heap_profiler.stack_index[slot] != 0;
+             slot = (slot + 1) & (heap_profiler.stack_index_size - 1)) {
+            stack = &heap_profiler.stacks[heap_profiler.stack_index[slot] - 1];
+            if (stack->hash == hash && stack->depth == depth &&
+                memcmp(stack->frames, frames, depth * sizeof(unsigned int)) == 0)
+                return heap_profiler.stack_index[slot] - 1;
+        }
+    }
+    if (heap_profiler.num_stacks == heap_profiler.max_stacks) {
+        unsigned int max = heap_profiler.max_stacks ? heap_profiler.max_stacks * 2 : HEAP_PROFILER_MIN_INDEX_SIZE / 2;
+        struct heap_profiler_stack* stacks = (struct heap_profiler_stack*)dlrealloc(heap_profiler.stacks, max * sizeof(struct heap_profiler_stack));
+        if (stacks == 0)
+            return (unsigned int)-1;
+        heap_profiler.stacks = stacks;
+        heap_profiler.max_stacks = max;
+    }
+    if (2 * (heap_profiler.num_stacks + 1) > heap_profiler.stack_index_size &&
+        !heap_profiler_grow_index(&heap_profiler.stack_index, &heap_profiler.stack_index_size,
+                                  heap_profiler.num_stacks, heap_profiler_stack_hash))
+        return (unsigned int)-1;
+    stack = &heap_profiler.stacks[heap_profiler.num_stacks];
+    stack->frames = (unsigned int*)dlmalloc(depth * sizeof(unsigned int));
+    if (stack->frames == 0)
+        return (unsigned int)-1;
+    memcpy(stack->frames, frames, depth * sizeof(unsigned int));
+    stack->hash = hash;
+    stack->depth = depth;
+    stack->live_count = stack->live_bytes = stack->total_count = stack->total_bytes = 0;
+    for (slot = hash & (heap_profiler.stack_index_size - 1);
+         heap_profiler.stack_index[slot] != 0;
+         slot = (slot + 1) & (heap_profiler.stack_index_size - 1))
+        ;
+    heap_profiler.stack_index[slot] = ++heap_profiler.num_stacks;
+    return heap_profiler.num_stacks - 1;
+}
+
+static int heap_profiler_grow_samples(void) {
+    size_t new_size = heap_profiler.samples_size ? heap_profiler.samples_size * 2 : HEAP_PROFILER_MIN_INDEX_SIZE;
+    struct heap_profiler_sample* samples = (struct heap_profiler_sample*)dlcalloc(new_size, sizeof(struct heap_profiler_sample));
+    size_t i;
+    if (samples == 0)
+        return 0;
+    for (i = 0; i < heap_profiler.samples_size; ++i) {
+        struct heap_profiler_sample* sample = &heap_profiler.samples[i];
+        if (sample->mem != 0) {
+            size_t slot = heap_profiler_hash_address(sample->mem) & (new_size - 1);
+            while (samples[slot].mem != 0)
+                slot = (slot + 1) & (new_size - 1);
+            samples[slot] = *sample;
+        }
+    }
+    dlfree(heap_profiler.samples);
+    heap_profiler.samples = samples;
+    heap_profiler.samples_size = new_size;
+    return 1;
+}
+
+/* Turns sampling off while the profiler allocates its own tables. */
+static void heap_profiler_set_internal(int internal) {
+    if (!PREACTION(gm)) {
+        heap_profiler.internal = internal;
+        POSTACTION(gm);
+    }
+}
+
+/* Records a sampled allocation. Called without the heap lock. */
+static void heap_profiler_record_allocation(void* mem, size_t bytes) {
+    unsigned int frames[HEAP_PROFILER_MAX_DEPTH];
+    unsigned int depth, id;
+#if USE_LOCKS
+    ACQUIRE_LOCK(&heap_profiler_mutex);
+#endif
+    heap_profiler_set_internal(1);
+    depth = heap_profiler_capture(frames);
+    id = heap_profiler_stack(frames, depth);
+    if (id != (unsigned int)-1 &&
+        (2 * (heap_profiler.num_samples + 1) <= heap_profiler.samples_size || heap_profiler_grow_samples())) {
+        struct heap_profiler_stack* stack = &heap_profiler.stacks[id];
+        size_t slot = heap_profiler_hash_address(mem) & (heap_profiler.samples_size - 1);
+        while (heap_profiler.samples[slot].mem != 0)
+            slot = (slot + 1) & (heap_profiler.samples_size - 1);
+        heap_profiler.samples[slot].mem = mem;
+        heap_profiler.samples[slot].stack = id;
+        heap_profiler.samples[slot].bytes = bytes;
+        ++heap_profiler.num_samples;
+        ++stack->live_count;
+        stack->live_bytes += bytes;
+        ++stack->total_count;
+        stack->total_bytes += bytes;
+    }
+    heap_profiler_set_internal(0);
+#if USE_LOCKS
+    RELEASE_LOCK(&heap_profiler_mutex);
+#endif
+}
+
+/* Removes the sample of a chunk, and if forget is set, also from the totals. */
+static void heap_profiler_remove(void* mem, int forget) {
+#if USE_LOCKS
+    ACQUIRE_LOCK(&heap_profiler_mutex);
+#endif
+    if (heap_profiler.samples_size != 0) {
+        size_t mask = heap_profiler.samples_size - 1;
+        size_t slot = heap_profiler_hash_address(mem) & mask;
+        while (heap_profiler.samples[slot].mem != 0 && heap_profiler.samples[slot].mem != mem)
+            slot = (slot + 1) & mask;
+        if (heap_profiler.samples[slot].mem != 0) {
+            struct heap_profiler_stack* stack = &heap_profiler.stacks[heap_profiler.samples[slot].stack];
+            size_t next;
+            --stack->live_count;
+            stack->live_bytes -= heap_profiler.samples[slot].bytes;
+            if (forget) {
+                --stack->total_count;
+                stack->total_bytes -= heap_profiler.samples[slot].bytes;
+            }
+            --heap_profiler.num_samples;
+            /* Shift back following entries of the probe sequence into the hole. */
+            for (next = (slot + 1) & mask; heap_profiler.samples[next].mem != 0; next = (next + 1) & mask) {
+                size_t home = heap_profiler_hash_address(heap_profiler.samples[next].mem) & mask;
+                if (((next - home) & mask) >= ((next - slot) & mask)) {
+                    heap_profiler.samples[slot] = heap_profiler.samples[next];
+                    slot = next;
+                }
+            }
+            heap_profiler.samples[slot].mem = 0;
+        }
+    }
+#if USE_LOCKS
+    RELEASE_LOCK(&heap_profiler_mutex);
+#endif
+}
+
+/* Records the free of a chunk that was marked as sampled. Called without the heap lock. */
+static void heap_profiler_record_free(void* mem) {
+    heap_profiler_remove(mem, 0);
+}
+
+/* Drops a sample as if it was never taken. Called without the heap lock. */
+static void heap_profiler_forget(void* mem) {
+    heap_profiler_remove(mem, 1);
+}
+
+void emscripten_heap_profiler_set_sample_interval(size_t bytes) {
+    ensure_initialization();
+    if (!PREACTION(gm)) {
+        heap_profiler.interval = bytes;
+        heap_profiler.countdown = 0;
+        POSTACTION(gm);
+    }
+}
+
+struct heap_profiler_writer {
+    char* out;
+    size_t size;
+    size_t length; /* of the whole output, may exceed size */
+};
+
+static void heap_profiler_printf(struct heap_profiler_writer* writer, const char* format, ...) {
+    va_list args;
+    int n;
+    va_start(args, format);
+    if (writer->length < writer->size)
+        n = vsnprintf(writer->out + writer->length, writer->size - writer->length, format, args);
+    else
+        n = vsnprintf(0, 0, format, args);
+    va_end(args);
+    if (n > 0)
+        writer->length += n;
+}
+
+/*
+ Symbol ids are written as fake program counters. pprof looks up caller
+ frames at their address minus one, so symbols are listed at both.
+*/
+#define heap_profiler_address(id) ((unsigned long)((id) + 1) << 4)
+
+size_t emscripten_heap_profiler_dump(char* out, size_t maxbytes) {
+    struct heap_profiler_writer writer;
+    size_t live_count = 0, live_bytes = 0, total_count = 0, total_bytes = 0;
+    size_t interval = 0;
+    unsigned int i, j;
+    writer.out = out;
+    writer.size = out != 0 ? maxbytes : 0;
+    writer.length = 0;
+    ensure_initialization();
+    if (!PREACTION(gm)) {
+        interval = heap_profiler.interval;
+        POSTACTION(gm);
+    }
+#if USE_LOCKS
+    ACQUIRE_LOCK(&heap_profiler_mutex);
+#endif
+    heap_profiler_printf(&writer, "--- symbol\n");
+    for (i = 0; i < heap_profiler.num_symbols; ++i) {
+        heap_profiler_printf(&writer, "0x%08lx %s\n", heap_profiler_address(i), heap_profiler.symbols[i]);
+        heap_profiler_printf(&writer, "0x%08lx %s\n", heap_profiler_address(i) - 1, heap_profiler.symbols[i]);
+    }
+    heap_profiler_printf(&writer, "---\n--- heap\n");
+    for (i = 0; i < heap_profiler.num_stacks; ++i) {
+        live_count += heap_profiler.stacks[i].live_count;
+        live_bytes += heap_profiler.stacks[i].live_bytes;
+        total_count += heap_profiler.stacks[i].total_count;
+        total_bytes += heap_profiler.stacks[i].total_bytes;
+    }
+    heap_profiler_printf(&writer, "heap profile: %lu: %lu [%lu: %lu] @ heap_v2/%lu\n",
+                         (unsigned long)live_count, (unsigned long)live_bytes,
+                         (unsigned long)total_count, (unsigned long)total_bytes,
+                         (unsigned long)interval);
+    for (i = 0; i < heap_profiler.num_stacks; ++i) {
+        struct heap_profiler_stack* stack = &heap_profiler.stacks[i];
+        if (stack->total_count == 0)
+            continue;
+        heap_profiler_printf(&writer, "%lu: %lu [%lu: %lu] @",
+                             (unsigned long)stack->live_count, (unsigned long)stack->live_bytes,
+                             (unsigned long)stack->total_count, (unsigned long)stack->total_bytes);
+        for (j = 0; j < stack->depth; ++j)
+            heap_profiler_printf(&writer, " 0x%08lx", heap_profiler_address(stack->frames[j]));
+        heap_profiler_printf(&writer, "\n");
+    }
+#if USE_LOCKS
+    RELEASE_LOCK(&heap_profiler_mutex);
+#endif
+    return writer.length + 1;
+}
+
+#endif /* HEAP_PROFILER */
+
 /* ----------------------------- user mspaces ---------------------------- */
 
 #if MSPACES
@@ -43,6 +43,16 @@ extern "C" {
     }
 }
 
+void internal::invokeBatchedCalls(const GenericWireType* cursor, const GenericWireType* end) {
+    while (cursor < end) {
+        auto invoker = reinterpret_cast<BatchedInvokerFunction>(
+            static_cast<uintptr_t>(cursor->w[0].u));
+        auto function = reinterpret_cast<GenericFunction>(
+            static_cast<uintptr_t>(cursor->w[1].u));
+        cursor = invoker(function, cursor + 1);
+    }
+}
+
 namespace {
     template<typename T>
     static void register_integer(const char* name) {
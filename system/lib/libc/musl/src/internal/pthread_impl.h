@@ -132,7 +132,12 @@ int __timedwait(volatile int *, int, clockid_t, const struct timespec *, void (*
 void __wait(volatile int *, volatile int *, int, int);
 
 #ifdef __EMSCRIPTEN__
-#define __wake(addr, cnt, priv) emscripten_futex_wake((void*)addr, (cnt)<0?INT_MAX:(cnt))
+// Futex operations of the synchronization primitives, implemented in library_pthread.c. They count contention
+// statistics, and the wait keeps the main runtime thread processing proxied calls.
+int __emscripten_futex_wait(volatile void *addr, int val, double maxWaitMilliseconds);
+int __emscripten_futex_wake(volatile void *addr, int count);
+int __emscripten_futex_wake_or_requeue(volatile void *addr, int count, int cmpValue, volatile void *addr2);
+#define __wake(addr, cnt, priv) __emscripten_futex_wake((void*)addr, (cnt)<0?INT_MAX:(cnt))
 #else
 #define __wake(addr, cnt, priv) \
 	__syscall(SYS_futex, addr, FUTEX_WAKE, (cnt)<0?INT_MAX:(cnt))
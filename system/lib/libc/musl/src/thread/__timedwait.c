@@ -50,14 +50,12 @@ static int do_wait(volatile int *addr, int val,
 				break;
 			}
 			if (waitMsecs > 100) waitMsecs = 100;
-			r = -emscripten_futex_wait((void*)addr, val, waitMsecs);
-			// Assist other threads by executing proxied operations that are effectively singlethreaded.
-			if (emscripten_is_main_runtime_thread()) emscripten_main_thread_process_queued_calls();
+			r = -__emscripten_futex_wait(addr, val, waitMsecs);
 		} while(r == ETIMEDOUT);
 	} else {
 		// Can wait in one go.
 		double waitMsecs = at ? _pthread_msecs_until(at) : INFINITY;
-		r = -emscripten_futex_wait((void*)addr, val, waitMsecs);
+		r = -__emscripten_futex_wait(addr, val, waitMsecs);
 	}
 #else
 	r = -__syscall_cp(SYS_futex, addr, FUTEX_WAIT, val, top);
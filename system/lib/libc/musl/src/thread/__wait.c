@@ -25,11 +25,11 @@ void __wait(volatile int *addr, volatile int *waiters, int val, int priv)
 					if (waiters) a_dec(waiters);
 					return;
 				}
-				e = emscripten_futex_wait((void*)addr, val, 100);
+				e = __emscripten_futex_wait(addr, val, 100);
 			} while(e == -ETIMEDOUT);
 		} else {
 			// Can wait in one go.
-			emscripten_futex_wait((void*)addr, val, INFINITY);
+			__emscripten_futex_wait(addr, val, INFINITY);
 		}
 #else
 		__syscall(SYS_futex, addr, FUTEX_WAIT|priv, val, 0);
@@ -8,13 +8,6 @@ int pthread_cond_broadcast(pthread_cond_t *c)
 
 	a_inc(&c->_c_seq);
 
-#ifdef __EMSCRIPTEN__
-	// XXX Emscripten: TODO: This is suboptimal but works naively correctly for now. The Emscripten-specific code path below
-	// has a bug and does not work for some reason. Figure it out and remove this code block.
-	__wake(&c->_c_seq, -1, 0);
-	return 0;
-#endif
-
 	/* If cond var is process-shared, simply wake all waiters. */
 	if (c->_c_mutex == (void *)-1) {
 		__wake(&c->_c_seq, -1, 0);
@@ -33,10 +26,13 @@ int pthread_cond_broadcast(pthread_cond_t *c)
 	c->_c_waiters2 = 0;
 
 #ifdef __EMSCRIPTEN__
+	/* Wake one waiter unless we know that the calling thread holds the
+	 * mutex, and requeue the rest to the mutex, which wakes them one at
+	 * a time as it is unlocked instead of all of them contending for it
+	 * at once. Retry if a signal changed the sequence number meanwhile. */
 	int futexResult;
 	do {
-		// XXX Emscripten: Bug, this does not work correctly.
-		futexResult = emscripten_futex_wake_or_requeue(&c->_c_seq, !m->_m_type || (m->_m_lock&INT_MAX)!=pthread_self()->tid,
+		futexResult = __emscripten_futex_wake_or_requeue(&c->_c_seq, !m->_m_type || (m->_m_lock&INT_MAX)!=pthread_self()->tid,
 			c->_c_seq, &m->_m_lock);
 	} while(futexResult == -EAGAIN);
 #else
@@ -0,0 +1,220 @@
+#include <stdint.h>
+#include <emscripten/threading.h>
+
+// Only the functions in <emscripten/threading.h> are used here, so that the tests can also build this file natively,
+// see test_other.test_pthread_64bit_atomics_native.
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#define EMSCRIPTEN_KEEPALIVE
+#endif
+
+// 64-bit atomics.
+//
+// Define EMSCRIPTEN_NATIVE_64BIT_ATOMICS when building for a target whose backend lowers 64-bit atomic operations to
+// native instructions, to implement the functions below directly on top of them. It must not be defined when the
+// backend lowers 64-bit atomics to calls to these very functions, as the asm.js backend does.
+//
+// Otherwise they are emulated with striped seqlocks: each 64-bit address hashes to one of NUM_64BIT_LOCKS lock words,
+// which holds an odd value while a writer owns it. Writers take the lock with a cas, and back off exponentially while
+// it is contended. Loads never write to the lock: they read its sequence number, then the value, then the sequence
+// number again, and retry if a writer got in between. Concurrent readers therefore do not contend with each other.
+
+#ifdef EMSCRIPTEN_NATIVE_64BIT_ATOMICS
+
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_exchange_u64(void/*uint64_t*/ *addr, uint64_t newVal)
+{
+	return __atomic_exchange_n((uint64_t*)addr, newVal, __ATOMIC_SEQ_CST);
+}
+
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_cas_u64(void/*uint64_t*/ *addr, uint64_t oldVal, uint64_t newVal)
+{
+	__atomic_compare_exchange_n((uint64_t*)addr, &oldVal, newVal, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return oldVal; // Holds the value in memory if the exchange failed.
+}
+
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_load_u64(const void *addr)
+{
+	return __atomic_load_n((uint64_t*)addr, __ATOMIC_SEQ_CST);
+}
+
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_store_u64(void *addr, uint64_t val)
+{
+	__atomic_store_n((uint64_t*)addr, val, __ATOMIC_SEQ_CST);
+	return val;
+}
+
+// Defines emscripten_atomic_<op>_u64, which returns the new value, and _emscripten_atomic_fetch_and_<op>_u64,
+// which returns the old value.
+#define ATOMIC_RMW_U64(op, builtin) \
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_##op##_u64(void *addr, uint64_t val) \
+{ \
+	return __atomic_##builtin##_fetch((uint64_t*)addr, val, __ATOMIC_SEQ_CST); \
+} \
+\
+uint64_t EMSCRIPTEN_KEEPALIVE _emscripten_atomic_fetch_and_##op##_u64(void *addr, uint64_t val) \
+{ \
+	return __atomic_fetch_##builtin((uint64_t*)addr, val, __ATOMIC_SEQ_CST); \
+}
+
+#else
+
+#define NUM_64BIT_LOCKS_LOG2 7
+#define NUM_64BIT_LOCKS (1 << NUM_64BIT_LOCKS_LOG2)
+#define MAX_BACKOFF_SPINS 1024
+
+typedef struct seqlock
+{
+	uint32_t sequence;
+	char padding[60]; // One lock per cache line, so that threads using different locks do not contend.
+} seqlock;
+
+static seqlock emulated64BitAtomicsLocks[NUM_64BIT_LOCKS];
+
+static inline uint32_t *seqlock_for_address(const void *addr)
+{
+	// Fibonacci hashing, so that addresses with power-of-two strides (array elements, struct members) spread over all
+	// the locks.
+	uint32_t h = (uint32_t)((uintptr_t)addr >> 3) * 2654435769u;
+	return &emulated64BitAtomicsLocks[h >> (32 - NUM_64BIT_LOCKS_LOG2)].sequence;
+}
+
+// Spins for the given number of reads of the lock word, and doubles the number for next time.
+static inline void seqlock_backoff(uint32_t *lock, int *spins)
+{
+	for(int i = 0; i < *spins; ++i)
+		emscripten_atomic_load_u32(lock);
+	if (*spins < MAX_BACKOFF_SPINS) *spins <<= 1;
+}
+
+static uint32_t seqlock_write_begin(uint32_t *lock)
+{
+	int spins = 1;
+	for(;;)
+	{
+		uint32_t seq = emscripten_atomic_load_u32(lock);
+		if (!(seq & 1) && emscripten_atomic_cas_u32(lock, seq, seq + 1) == seq)
+			return seq + 1;
+		seqlock_backoff(lock, &spins);
+	}
+}
+
+static inline void seqlock_write_end(uint32_t *lock, uint32_t seq)
+{
+	emscripten_atomic_store_u32(lock, seq + 1);
+}
+
+// Loads may race with a writer, so they read the value as two 32-bit atomics, whose ordering with the sequence number
+// reads is guaranteed. Writers own the lock and access the value directly.
+static inline uint64_t seqlock_read_u64(const void *addr)
+{
+	uint32_t lo = emscripten_atomic_load_u32((uint32_t*)addr);
+	uint32_t hi = emscripten_atomic_load_u32((uint32_t*)addr + 1);
+	return ((uint64_t)hi << 32) | lo;
+}
+
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_exchange_u64(void/*uint64_t*/ *addr, uint64_t newVal)
+{
+	uint32_t *lock = seqlock_for_address(addr);
+	uint32_t seq = seqlock_write_begin(lock);
+	uint64_t oldValInMemory = *(volatile uint64_t*)addr;
+	*(volatile uint64_t*)addr = newVal;
+	seqlock_write_end(lock, seq);
+	return oldValInMemory;
+}
+
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_cas_u64(void/*uint64_t*/ *addr, uint64_t oldVal, uint64_t newVal)
+{
+	uint32_t *lock = seqlock_for_address(addr);
+	uint32_t seq = seqlock_write_begin(lock);
+	uint64_t oldValInMemory = *(volatile uint64_t*)addr;
+	if (oldValInMemory == oldVal)
+		*(volatile uint64_t*)addr = newVal;
+	seqlock_write_end(lock, seq);
+	return oldValInMemory;
+}
+
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_load_u64(const void *addr)
+{
+	uint32_t *lock = seqlock_for_address(addr);
+	int spins = 1;
+	for(;;)
+	{
+		uint32_t seq = emscripten_atomic_load_u32(lock);
+		if (!(seq & 1))
+		{
+			uint64_t val = seqlock_read_u64(addr);
+			if (emscripten_atomic_load_u32(lock) == seq)
+				return val;
+		}
+		seqlock_backoff(lock, &spins);
+	}
+}
+
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_store_u64(void *addr, uint64_t val)
+{
+	uint32_t *lock = seqlock_for_address(addr);
+	uint32_t seq = seqlock_write_begin(lock);
+	*(volatile uint64_t*)addr = val;
+	seqlock_write_end(lock, seq);
+	return val;
+}
+
+// Defines emscripten_atomic_<op>_u64, which returns the new value, and _emscripten_atomic_fetch_and_<op>_u64,
+// which returns the old value.
+#define ATOMIC_RMW_U64(op, builtin) \
+uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_##op##_u64(void *addr, uint64_t val) \
+{ \
+	uint32_t *lock = seqlock_for_address(addr); \
+	uint32_t seq = seqlock_write_begin(lock); \
+	uint64_t newVal = ATOMIC_RMW_U64_##builtin(*(volatile uint64_t*)addr, val); \
+	*(volatile uint64_t*)addr = newVal; \
+	seqlock_write_end(lock, seq); \
+	return newVal; \
+} \
+\
+uint64_t EMSCRIPTEN_KEEPALIVE _emscripten_atomic_fetch_and_##op##_u64(void *addr, uint64_t val) \
+{ \
+	uint32_t *lock = seqlock_for_address(addr); \
+	uint32_t seq = seqlock_write_begin(lock); \
+	uint64_t oldVal = *(volatile uint64_t*)addr; \
+	*(volatile uint64_t*)addr = ATOMIC_RMW_U64_##builtin(oldVal, val); \
+	seqlock_write_end(lock, seq); \
+	return oldVal; \
+}
+
+#define ATOMIC_RMW_U64_add(a, b) ((a) + (b))
+#define ATOMIC_RMW_U64_sub(a, b) ((a) - (b))
+#define ATOMIC_RMW_U64_and(a, b) ((a) & (b))
+#define ATOMIC_RMW_U64_or(a, b) ((a) | (b))
+#define ATOMIC_RMW_U64_xor(a, b) ((a) ^ (b))
+
+#endif
+
+double EMSCRIPTEN_KEEPALIVE emscripten_atomic_load_f64(const void *addr)
+{
+	union {
+		double d;
+		uint64_t u;
+	} u;
+	u.u = emscripten_atomic_load_u64(addr);
+	return u.d;
+}
+
+double EMSCRIPTEN_KEEPALIVE emscripten_atomic_store_f64(void *addr, double val)
+{
+	union {
+		double d;
+		uint64_t u;
+	} u;
+	u.d = val;
+	emscripten_atomic_store_u64(addr, u.u);
+	return val;
+}
+
+// The _emscripten_atomic_fetch_and_<op>_u64 variants implement GCC 64-bit __sync_fetch_and_<op>. Not to be called directly.
+ATOMIC_RMW_U64(add, add)
+ATOMIC_RMW_U64(sub, sub)
+ATOMIC_RMW_U64(and, and)
+ATOMIC_RMW_U64(or, or)
+ATOMIC_RMW_U64(xor, xor)
@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 #include <termios.h>
 #include <sys/mman.h>
 #include <sys/socket.h>
@@ -249,9 +250,50 @@ int usleep(unsigned usec)
 	return 0;
 }
 
-static void _do_call(em_queued_call *q)
+static void _do_call_function_ptr(em_queued_call *q)
 {
 	switch(q->function)
+	{
+		case EM_FUNC_SIG_V: ((void(*)(void))q->functionPtr)(); break;
+		case EM_FUNC_SIG_VI: ((void(*)(int))q->functionPtr)(q->args[0].i); break;
+		case EM_FUNC_SIG_VII: ((void(*)(int, int))q->functionPtr)(q->args[0].i, q->args[1].i); break;
+		case EM_FUNC_SIG_VIII: ((void(*)(int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i); break;
+		case EM_FUNC_SIG_VIIII: ((void(*)(int, int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i, q->args[3].i); break;
+		case EM_FUNC_SIG_VIIIII: ((void(*)(int, int, int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i, q->args[3].i, q->args[4].i); break;
+		case EM_FUNC_SIG_VIIIIII: ((void(*)(int, int, int, int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i, q->args[3].i, q->args[4].i, q->args[5].i); break;
+		case EM_FUNC_SIG_VIIIIIII: ((void(*)(int, int, int, int, int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i, q->args[3].i, q->args[4].i, q->args[5].i, q->args[6].i); break;
+		case EM_FUNC_SIG_I: q->returnValue.i = ((int(*)(void))q->functionPtr)(); break;
+		case EM_FUNC_SIG_II: q->returnValue.i = ((int(*)(int))q->functionPtr)(q->args[0].i); break;
+		case EM_FUNC_SIG_III: q->returnValue.i = ((int(*)(int, int))q->functionPtr)(q->args[0].i, q->args[1].i); break;
+		case EM_FUNC_SIG_IIII: q->returnValue.i = ((int(*)(int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i); break;
+		case EM_FUNC_SIG_IIIII: q->returnValue.i = ((int(*)(int, int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i, q->args[3].i); break;
+		case EM_FUNC_SIG_IIIIII: q->returnValue.i = ((int(*)(int, int, int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i, q->args[3].i, q->args[4].i); break;
+		case EM_FUNC_SIG_IIIIIII: q->returnValue.i = ((int(*)(int, int, int, int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i, q->args[3].i, q->args[4].i, q->args[5].i); break;
+		case EM_FUNC_SIG_IIIIIIII: q->returnValue.i = ((int(*)(int, int, int, int, int, int, int))q->functionPtr)(q->args[0].i, q->args[1].i, q->args[2].i, q->args[3].i, q->args[4].i, q->args[5].i, q->args[6].i); break;
+		case EM_FUNC_SIG_VF: ((void(*)(float))q->functionPtr)(q->args[0].f); break;
+		case EM_FUNC_SIG_VFF: ((void(*)(float, float))q->functionPtr)(q->args[0].f, q->args[1].f); break;
+		case EM_FUNC_SIG_VFFF: ((void(*)(float, float, float))q->functionPtr)(q->args[0].f, q->args[1].f, q->args[2].f); break;
+		case EM_FUNC_SIG_VFFFF: ((void(*)(float, float, float, float))q->functionPtr)(q->args[0].f, q->args[1].f, q->args[2].f, q->args[3].f); break;
+		case EM_FUNC_SIG_VIF: ((void(*)(int, float))q->functionPtr)(q->args[0].i, q->args[1].f); break;
+		case EM_FUNC_SIG_VIFF: ((void(*)(int, float, float))q->functionPtr)(q->args[0].i, q->args[1].f, q->args[2].f); break;
+		case EM_FUNC_SIG_VIFFF: ((void(*)(int, float, float, float))q->functionPtr)(q->args[0].i, q->args[1].f, q->args[2].f, q->args[3].f); break;
+		case EM_FUNC_SIG_VIFFFF: ((void(*)(int, float, float, float, float))q->functionPtr)(q->args[0].i, q->args[1].f, q->args[2].f, q->args[3].f, q->args[4].f); break;
+		case EM_FUNC_SIG_VD: ((void(*)(double))q->functionPtr)(q->args[0].d); break;
+		case EM_FUNC_SIG_VDD: ((void(*)(double, double))q->functionPtr)(q->args[0].d, q->args[1].d); break;
+		case EM_FUNC_SIG_VID: ((void(*)(int, double))q->functionPtr)(q->args[0].i, q->args[1].d); break;
+		case EM_FUNC_SIG_VIDD: ((void(*)(int, double, double))q->functionPtr)(q->args[0].i, q->args[1].d, q->args[2].d); break;
+		case EM_FUNC_SIG_F: q->returnValue.f = ((float(*)(void))q->functionPtr)(); break;
+		case EM_FUNC_SIG_FI: q->returnValue.f = ((float(*)(int))q->functionPtr)(q->args[0].i); break;
+		case EM_FUNC_SIG_D: q->returnValue.d = ((double(*)(void))q->functionPtr)(); break;
+		case EM_FUNC_SIG_DI: q->returnValue.d = ((double(*)(int))q->functionPtr)(q->args[0].i); break;
+		default: assert(0 && "Unsupported EM_FUNC_SIGNATURE passed to a proxied function pointer call!");
+	}
+}
+
+static void _do_call(em_queued_call *q)
+{
+	if (q->functionPtr) _do_call_function_ptr(q);
+	else switch(q->function)
 	{
 		case EM_PROXIED_UTIME: q->returnValue.i = utime(q->args[0].cp, (struct utimbuf*)q->args[1].vp); break;
 		case EM_PROXIED_UTIMES: q->returnValue.i = utimes(q->args[0].cp, (struct timeval*)q->args[1].vp); break;
@@ -271,39 +313,256 @@ static void _do_call(em_queued_call *q)
 		case EM_PROXIED_SYSCALL: q->returnValue.i = emscripten_syscall(q->args[0].i, q->args[1].vp); break;
 		default: assert(0 && "Invalid Emscripten pthread _do_call opcode!");
 	}
+	if (q->calleeDelete)
+	{
+		// Asynchronous calls are owned by the queue, nobody is waiting on them.
+		free(q);
+		return;
+	}
 	q->operationDone = 1;
 	emscripten_futex_wake(&q->operationDone, INT_MAX);
 }
 
-#define CALL_QUEUE_SIZE 128
-static em_queued_call **call_queue = 0;
-static int call_queue_length = 0; // Shared data synchronized by call_queue_lock.
-static pthread_mutex_t call_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+// Proxied calls are passed to the main thread through a bounded lock-free multi-producer, single-consumer ring buffer.
+// Each slot carries a sequence number that tells which lap of the ring it is ready for: a producer may fill slot
+// pos % CALL_QUEUE_SIZE when its sequence equals pos, and the main thread may consume it once the sequence is pos+1.
+// Sequences are stored minus the slot index so that the zero-initialized ring starts out empty.
+#define CALL_QUEUE_SIZE 128 // Must be a power of two.
+typedef struct call_queue_slot
+{
+	uint32_t sequence;
+	em_queued_call *call;
+} call_queue_slot;
+static call_queue_slot call_queue[CALL_QUEUE_SIZE];
+static uint32_t call_queue_tail = 0; // Next position to produce to, shared by all threads.
+static uint32_t call_queue_head = 0; // Next position to consume from, only accessed by the main thread.
+static uint32_t call_queue_notified = 0; // 1 if the main thread has been posted a message to process the queue.
+
+static int call_queue_try_push(em_queued_call *call)
+{
+	uint32_t pos = emscripten_atomic_load_u32(&call_queue_tail);
+	for(;;)
+	{
+		uint32_t index = pos & (CALL_QUEUE_SIZE-1);
+		call_queue_slot *slot = &call_queue[index];
+		int32_t diff = (int32_t)(emscripten_atomic_load_u32(&slot->sequence) + index - pos);
+		if (diff == 0)
+		{
+			uint32_t prev = emscripten_atomic_cas_u32(&call_queue_tail, pos, pos + 1);
+			if (prev == pos)
+			{
+				slot->call = call;
+				emscripten_atomic_store_u32(&slot->sequence, pos + 1 - index); // Publishes the call to the main thread.
+				return 1;
+			}
+			pos = prev;
+		}
+		else if (diff < 0) return 0; // The main thread has not yet consumed this slot from the previous lap: the queue is full.
+		else pos = emscripten_atomic_load_u32(&call_queue_tail); // Another producer claimed this position, retry.
+	}
+}
+
+static em_queued_call *call_queue_pop()
+{
+	uint32_t pos = call_queue_head;
+	uint32_t index = pos & (CALL_QUEUE_SIZE-1);
+	call_queue_slot *slot = &call_queue[index];
+	if (emscripten_atomic_load_u32(&slot->sequence) + index != pos + 1) return 0; // Empty, or the producer has not finished writing the slot.
+	em_queued_call *call = slot->call;
+	emscripten_atomic_store_u32(&slot->sequence, pos + CALL_QUEUE_SIZE - index); // Hands the slot back to producers for the next lap.
+	call_queue_head = pos + 1;
+	return call;
+}
+
+static void call_queue_notify_main_thread()
+{
+	// Only post a message when the main thread is not already going to process the queue, so that bursts of calls
+	// cost a single message.
+	if (emscripten_atomic_cas_u32(&call_queue_notified, 0, 1) == 0)
+		EM_ASM(postMessage({ cmd: 'processQueuedMainThreadWork' }));
+}
+
+static void call_queue_push_without_notify(em_queued_call *call)
+{
+	while(!call_queue_try_push(call))
+	{
+		// The main thread is lagging behind by CALL_QUEUE_SIZE calls, wait for it to make room. Batched calls have not
+		// told it about the queued calls yet, so do that first or it would never drain them.
+		call_queue_notify_main_thread();
+		emscripten_futex_wait(&dummyZeroAddress, 0, 1);
+	}
+}
+
+static void call_queue_push(em_queued_call *call)
+{
+	call_queue_push_without_notify(call);
+	call_queue_notify_main_thread();
+}
 
 void EMSCRIPTEN_KEEPALIVE emscripten_sync_run_in_main_thread(em_queued_call *call)
 {
 	assert(call);
+	call->calleeDelete = 0; // The call is owned by the caller, usually on its stack, which waits for it below.
 	if (emscripten_is_main_runtime_thread()) {
 		_do_call(call);
 		return;
 	}
-	pthread_mutex_lock(&call_queue_lock);
-	if (!call_queue) call_queue = malloc(sizeof(em_queued_call*) * CALL_QUEUE_SIZE); // Shared data synchronized by call_queue_lock.
-	// Note: currently call_queue_length can be at most the number of pthreads that are currently running, so the queue can never get
-	// full. However if/when the queue is extended to be asynchronous for void-returning functions later, this will need to be revised.
-	assert(call_queue_length < CALL_QUEUE_SIZE);
-	call_queue[call_queue_length] = call;
-	++call_queue_length;
-	if (call_queue_length == 1) {
-		EM_ASM(postMessage({ cmd: 'processQueuedMainThreadWork' }));
-	}
-	pthread_mutex_unlock(&call_queue_lock);
+	call_queue_push(call);
 	int r;
 	do {
 		r = emscripten_futex_wait(&call->operationDone, 0, INFINITY);
 	} while(r != 0 && call->operationDone == 0);
 }
 
+void EMSCRIPTEN_KEEPALIVE emscripten_async_run_in_main_thread(em_queued_call *call)
+{
+	assert(call);
+	call->calleeDelete = 1;
+	if (emscripten_is_main_runtime_thread()) {
+		_do_call(call);
+		return;
+	}
+	call_queue_push(call);
+}
+
+// Asynchronous calls have no way to report an error back to the caller, so running out of memory for one aborts.
+static em_queued_call *em_queued_call_malloc(int function)
+{
+	em_queued_call *q = (em_queued_call *)malloc(sizeof(em_queued_call));
+	if (!q) EM_ASM(abort('Out of memory queuing a call to the main thread!'));
+	memset(q, 0, sizeof(em_queued_call));
+	q->function = function;
+	return q;
+}
+
+void EMSCRIPTEN_KEEPALIVE emscripten_async_run_in_main_thread_0(int function)
+{
+	em_queued_call *q = em_queued_call_malloc(function);
+	emscripten_async_run_in_main_thread(q);
+}
+
+void EMSCRIPTEN_KEEPALIVE emscripten_async_run_in_main_thread_1(int function, void *arg1)
+{
+	em_queued_call *q = em_queued_call_malloc(function);
+	q->args[0].vp = arg1;
+	emscripten_async_run_in_main_thread(q);
+}
+
+void EMSCRIPTEN_KEEPALIVE emscripten_async_run_in_main_thread_2(int function, void *arg1, void *arg2)
+{
+	em_queued_call *q = em_queued_call_malloc(function);
+	q->args[0].vp = arg1;
+	q->args[1].vp = arg2;
+	emscripten_async_run_in_main_thread(q);
+}
+
+void EMSCRIPTEN_KEEPALIVE emscripten_async_run_in_main_thread_3(int function, void *arg1, void *arg2, void *arg3)
+{
+	em_queued_call *q = em_queued_call_malloc(function);
+	q->args[0].vp = arg1;
+	q->args[1].vp = arg2;
+	q->args[2].vp = arg3;
+	emscripten_async_run_in_main_thread(q);
+}
+
+static void em_queued_call_read_function_ptr_args(em_queued_call *q, EM_FUNC_SIGNATURE sig, void *func_ptr, va_list args)
+{
+	int numArgs = EM_FUNC_SIG_NUM_PARAMETERS(sig);
+	assert(func_ptr);
+	assert(numArgs <= EM_QUEUED_CALL_MAX_ARGS);
+	q->function = sig;
+	q->functionPtr = func_ptr;
+	for(int i = 0; i < numArgs; ++i)
+	{
+		switch(EM_FUNC_SIG_PARAM_TYPE(sig, i))
+		{
+			case EM_FUNC_SIG_PARAM_I: q->args[i].i = va_arg(args, int); break;
+			case EM_FUNC_SIG_PARAM_F: q->args[i].f = (float)va_arg(args, double); break; // floats are promoted to double in varargs.
+			case EM_FUNC_SIG_PARAM_D: q->args[i].d = va_arg(args, double); break;
+			default: assert(0 && "Invalid parameter type in EM_FUNC_SIGNATURE!");
+		}
+	}
+}
+
+em_variant_val EMSCRIPTEN_KEEPALIVE emscripten_sync_run_in_main_runtime_thread_(EM_FUNC_SIGNATURE sig, void *func_ptr, ...)
+{
+	em_queued_call q = { 0 };
+	va_list args;
+	va_start(args, func_ptr);
+	em_queued_call_read_function_ptr_args(&q, sig, func_ptr, args);
+	va_end(args);
+	emscripten_sync_run_in_main_thread(&q);
+	return q.returnValue;
+}
+
+void EMSCRIPTEN_KEEPALIVE emscripten_async_run_in_main_runtime_thread_(EM_FUNC_SIGNATURE sig, void *func_ptr, ...)
+{
+	em_queued_call *q = em_queued_call_malloc(0);
+	va_list args;
+	va_start(args, func_ptr);
+	em_queued_call_read_function_ptr_args(q, sig, func_ptr, args);
+	va_end(args);
+	emscripten_async_run_in_main_thread(q);
+}
+
+void EMSCRIPTEN_KEEPALIVE emscripten_async_batched_run_in_main_runtime_thread_(EM_FUNC_SIGNATURE sig, void *func_ptr, ...)
+{
+	em_queued_call *q = em_queued_call_malloc(0);
+	va_list args;
+	va_start(args, func_ptr);
+	em_queued_call_read_function_ptr_args(q, sig, func_ptr, args);
+	va_end(args);
+	q->calleeDelete = 1;
+	if (emscripten_is_main_runtime_thread()) _do_call(q);
+	else call_queue_push_without_notify(q);
+}
+
+void EMSCRIPTEN_KEEPALIVE emscripten_main_runtime_thread_flush_batched_calls()
+{
+	if (!emscripten_is_main_runtime_thread()) call_queue_notify_main_thread();
+}
+
+em_queued_call * EMSCRIPTEN_KEEPALIVE emscripten_async_waitable_run_in_main_runtime_thread_(EM_FUNC_SIGNATURE sig, void *func_ptr, ...)
+{
+	em_queued_call *q = em_queued_call_malloc(0);
+	va_list args;
+	va_start(args, func_ptr);
+	em_queued_call_read_function_ptr_args(q, sig, func_ptr, args);
+	va_end(args);
+	// The caller owns the call until emscripten_async_waitable_close(), so calleeDelete stays 0.
+	if (emscripten_is_main_runtime_thread()) _do_call(q);
+	else call_queue_push(q);
+	return q;
+}
+
+int EMSCRIPTEN_KEEPALIVE emscripten_wait_for_call(em_queued_call *call, double timeoutMSecs, em_variant_val *outResult)
+{
+	assert(call);
+	double timeoutAt = emscripten_get_now() + timeoutMSecs;
+	while(!emscripten_atomic_load_u32(&call->operationDone))
+	{
+		double msecsToWait = timeoutAt - emscripten_get_now(); // Stays INFINITY when waiting indefinitely.
+		if (msecsToWait <= 0) return 0;
+		emscripten_futex_wait(&call->operationDone, 0, msecsToWait);
+	}
+	if (outResult) *outResult = call->returnValue;
+	return 1;
+}
+
+void EMSCRIPTEN_KEEPALIVE emscripten_async_waitable_close(em_queued_call *call)
+{
+	emscripten_wait_for_call(call, INFINITY, 0);
+	free(call);
+}
+
+void * EMSCRIPTEN_KEEPALIVE emscripten_sync_run_in_main_thread_0(int function)
+{
+	em_queued_call q = { function, 0 };
+	q.returnValue.vp = 0;
+	emscripten_sync_run_in_main_thread(&q);
+	return q.returnValue.vp;
+}
+
 void * EMSCRIPTEN_KEEPALIVE emscripten_sync_run_in_main_thread_1(int function, void *arg1)
 {
 	em_queued_call q = { function, 0 };
@@ -422,221 +681,136 @@ void EMSCRIPTEN_KEEPALIVE emscripten_main_thread_process_queued_calls()
 	// Therefore this scenario must explicitly be detected, and processing the queue must be avoided if we are nesting, or otherwise
 	// the same queued calls would be processed again and again.
 	if (bool_inside_nested_process_queued_calls) return;
-	// This must be before pthread_mutex_lock(), since pthread_mutex_lock() can call back to this function.
 	bool_inside_nested_process_queued_calls = 1;
-	pthread_mutex_lock(&call_queue_lock);
-	for (int i = 0; i < call_queue_length; ++i)
-		_do_call(call_queue[i]);
-	call_queue_length = 0;
+	// Clear the notification before draining, so that calls queued from here on post a new message and none are missed.
+	emscripten_atomic_store_u32(&call_queue_notified, 0);
+	em_queued_call *call;
+	while((call = call_queue_pop()))
+		_do_call(call);
 	bool_inside_nested_process_queued_calls = 0;
-	pthread_mutex_unlock(&call_queue_lock);
 }
 
-float EMSCRIPTEN_KEEPALIVE emscripten_atomic_load_f32(const void *addr)
-{
-	union {
-		float f;
-		uint32_t u;
-	} u;
-	u.u = emscripten_atomic_load_u32(addr);
-	return u.f;
-}
+static emscripten_futex_stats futex_stats;
 
-// Use an array of multiple interleaved spinlock mutexes to separate memory addresses to ease pressure when locking.
-// This is outright horrible, but enables easily porting code that does require 64-bit atomics.
-// Eventually in the long run we'd hope to have real support for 64-bit atomics in the browser, after
-// which this emulation can be removed.
-#define NUM_64BIT_LOCKS 256
-static int emulated64BitAtomicsLocks[NUM_64BIT_LOCKS] = {};
+// The main runtime thread waits in slices of this length, so that it gets to process calls proxied to it in between.
+#define MAIN_THREAD_WAIT_SLICE_MSECS 1.0
 
-uint32_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_exchange_u32(void/*uint32_t*/ *addr, uint32_t newVal)
+int __emscripten_futex_wait(volatile void *addr, int val, double maxWaitMilliseconds)
 {
-	uint32_t oldVal, oldVal2;
-	do {
-		oldVal = emscripten_atomic_load_u32(addr);
-		oldVal2 = emscripten_atomic_cas_u32(addr, oldVal, newVal);
-	} while (oldVal != oldVal2);
-	return oldVal;
+	emscripten_atomic_add_u32(&futex_stats.waits, 1);
+	int ret;
+	if (!emscripten_is_main_runtime_thread())
+	{
+		ret = emscripten_futex_wait((void*)addr, val, maxWaitMilliseconds);
+	}
+	else
+	{
+		// The thread holding what the main thread is waiting for may itself be waiting for a call it proxied to the main
+		// thread, so keep processing the queue while waiting. The main browser thread cannot block at all, and spins.
+		int canBlock = !emscripten_is_main_browser_thread();
+		double start = emscripten_get_now();
+		double end = start + maxWaitMilliseconds;
+		for(int spins = 0;; ++spins)
+		{
+			emscripten_main_thread_process_queued_calls();
+			if (emscripten_atomic_load_u32((void*)addr) != (uint32_t)val)
+			{
+				ret = spins ? 0 : -EWOULDBLOCK;
+				break;
+			}
+			double now = emscripten_get_now();
+			if (now >= end)
+			{
+				ret = -ETIMEDOUT;
+				break;
+			}
+			if (canBlock)
+			{
+				double msecs = end - now;
+				if (msecs > MAIN_THREAD_WAIT_SLICE_MSECS) msecs = MAIN_THREAD_WAIT_SLICE_MSECS;
+				ret = emscripten_futex_wait((void*)addr, val, msecs);
+				if (ret != -ETIMEDOUT) break;
+			}
+		}
+		futex_stats.mainThreadWaitMsecs += emscripten_get_now() - start;
+	}
+	if (ret == -ETIMEDOUT) emscripten_atomic_add_u32(&futex_stats.timeouts, 1);
+	return ret;
 }
 
-#define SPINLOCK_ACQUIRE(addr) do { while(emscripten_atomic_exchange_u32((void*)(addr), 1)) /*nop*/; } while(0)
-#define SPINLOCK_RELEASE(addr) emscripten_atomic_store_u32((void*)(addr), 0)
-
-uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_exchange_u64(void/*uint64_t*/ *addr, uint64_t newVal)
+int __emscripten_futex_wake(volatile void *addr, int count)
 {
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t oldValInMemory = *(uint64_t*)addr;
-	*(uint64_t*)addr = newVal;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return oldValInMemory;
+	int ret = emscripten_futex_wake((void*)addr, count);
+	if (ret > 0)
+	{
+		emscripten_atomic_add_u32(&futex_stats.wakes, 1);
+		emscripten_atomic_add_u32(&futex_stats.threadsWoken, ret);
+	}
+	return ret;
 }
 
-uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_cas_u64(void/*uint64_t*/ *addr, uint64_t oldVal, uint64_t newVal)
+int __emscripten_futex_wake_or_requeue(volatile void *addr, int count, int cmpValue, volatile void *addr2)
 {
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t oldValInMemory = *(uint64_t*)addr;
-	if (oldValInMemory == oldVal)
-		*(uint64_t*)addr = newVal;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return oldValInMemory;
+	int ret = emscripten_futex_wake_or_requeue((void*)addr, count, cmpValue, (void*)addr2);
+	if (ret >= 0)
+	{
+		emscripten_atomic_add_u32(&futex_stats.requeues, 1);
+		if (ret > 0)
+		{
+			emscripten_atomic_add_u32(&futex_stats.wakes, 1);
+			emscripten_atomic_add_u32(&futex_stats.threadsWoken, ret);
+		}
+	}
+	return ret;
 }
 
-double EMSCRIPTEN_KEEPALIVE emscripten_atomic_load_f64(const void *addr)
+void EMSCRIPTEN_KEEPALIVE emscripten_futex_get_stats(emscripten_futex_stats *stats)
 {
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	double val = *(double*)addr;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return val;
+	assert(stats);
+	stats->waits = emscripten_atomic_load_u32(&futex_stats.waits);
+	stats->timeouts = emscripten_atomic_load_u32(&futex_stats.timeouts);
+	stats->wakes = emscripten_atomic_load_u32(&futex_stats.wakes);
+	stats->threadsWoken = emscripten_atomic_load_u32(&futex_stats.threadsWoken);
+	stats->requeues = emscripten_atomic_load_u32(&futex_stats.requeues);
+	stats->mainThreadWaitMsecs = futex_stats.mainThreadWaitMsecs;
 }
 
-uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_load_u64(const void *addr)
+void EMSCRIPTEN_KEEPALIVE emscripten_futex_reset_stats()
 {
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t val = *(uint64_t*)addr;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return val;
+	emscripten_atomic_store_u32(&futex_stats.waits, 0);
+	emscripten_atomic_store_u32(&futex_stats.timeouts, 0);
+	emscripten_atomic_store_u32(&futex_stats.wakes, 0);
+	emscripten_atomic_store_u32(&futex_stats.threadsWoken, 0);
+	emscripten_atomic_store_u32(&futex_stats.requeues, 0);
+	futex_stats.mainThreadWaitMsecs = 0;
 }
 
-float EMSCRIPTEN_KEEPALIVE emscripten_atomic_store_f32(void *addr, float val)
+float EMSCRIPTEN_KEEPALIVE emscripten_atomic_load_f32(const void *addr)
 {
 	union {
 		float f;
 		uint32_t u;
 	} u;
-	u.f = val;
-	return emscripten_atomic_store_u32(addr, u.u);
-}
-
-double EMSCRIPTEN_KEEPALIVE emscripten_atomic_store_f64(void *addr, double val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	double *a = (double*)addr;
-	*a = val;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return val;
-}
-
-uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_store_u64(void *addr, uint64_t val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t *a = (uint64_t*)addr;
-	*a = val;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return val;
-}
-
-uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_add_u64(void *addr, uint64_t val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t *a = (uint64_t *)addr;
-	uint64_t newVal = *a + val;
-	*a = newVal;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return newVal;
-}
-
-// This variant is implemented for emulating GCC 64-bit __sync_fetch_and_add. Not to be called directly.
-uint64_t EMSCRIPTEN_KEEPALIVE _emscripten_atomic_fetch_and_add_u64(void *addr, uint64_t val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t oldVal = *(uint64_t *)addr;
-	*(uint64_t *)addr = oldVal + val;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return oldVal;
-}
-
-uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_sub_u64(void *addr, uint64_t val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t *a = (uint64_t *)addr;
-	uint64_t newVal = *a - val;
-	*a = newVal;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return newVal;
-}
-
-// This variant is implemented for emulating GCC 64-bit __sync_fetch_and_sub. Not to be called directly.
-uint64_t EMSCRIPTEN_KEEPALIVE _emscripten_atomic_fetch_and_sub_u64(void *addr, uint64_t val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t oldVal = *(uint64_t *)addr;
-	*(uint64_t *)addr = oldVal - val;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return oldVal;
-}
-
-uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_and_u64(void *addr, uint64_t val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t *a = (uint64_t *)addr;
-	uint64_t newVal = *a & val;
-	*a = newVal;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return newVal;
-}
-
-// This variant is implemented for emulating GCC 64-bit __sync_fetch_and_and. Not to be called directly.
-uint64_t EMSCRIPTEN_KEEPALIVE _emscripten_atomic_fetch_and_and_u64(void *addr, uint64_t val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t oldVal = *(uint64_t *)addr;
-	*(uint64_t *)addr = oldVal & val;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return oldVal;
-}
-
-uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_or_u64(void *addr, uint64_t val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t *a = (uint64_t *)addr;
-	uint64_t newVal = *a | val;
-	*a = newVal;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return newVal;
+	u.u = emscripten_atomic_load_u32(addr);
+	return u.f;
 }
 
-// This variant is implemented for emulating GCC 64-bit __sync_fetch_and_or. Not to be called directly.
-uint64_t EMSCRIPTEN_KEEPALIVE _emscripten_atomic_fetch_and_or_u64(void *addr, uint64_t val)
+uint32_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_exchange_u32(void/*uint32_t*/ *addr, uint32_t newVal)
 {
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t oldVal = *(uint64_t *)addr;
-	*(uint64_t *)addr = oldVal | val;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
+	uint32_t oldVal, oldVal2;
+	do {
+		oldVal = emscripten_atomic_load_u32(addr);
+		oldVal2 = emscripten_atomic_cas_u32(addr, oldVal, newVal);
+	} while (oldVal != oldVal2);
 	return oldVal;
 }
 
-uint64_t EMSCRIPTEN_KEEPALIVE emscripten_atomic_xor_u64(void *addr, uint64_t val)
-{
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t *a = (uint64_t *)addr;
-	uint64_t newVal = *a ^ val;
-	*a = newVal;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return newVal;
-}
-
-// This variant is implemented for emulating GCC 64-bit __sync_fetch_and_xor. Not to be called directly.
-uint64_t EMSCRIPTEN_KEEPALIVE _emscripten_atomic_fetch_and_xor_u64(void *addr, uint64_t val)
+float EMSCRIPTEN_KEEPALIVE emscripten_atomic_store_f32(void *addr, float val)
 {
-	uintptr_t m = (uintptr_t)addr >> 3;
-	SPINLOCK_ACQUIRE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	uint64_t oldVal = *(uint64_t *)addr;
-	*(uint64_t *)addr = oldVal ^ val;
-	SPINLOCK_RELEASE(&emulated64BitAtomicsLocks[m&(NUM_64BIT_LOCKS-1)]);
-	return oldVal;
+	union {
+		float f;
+		uint32_t u;
+	} u;
+	u.f = val;
+	return emscripten_atomic_store_u32(addr, u.u);
 }
@@ -0,0 +1,377 @@
+#include <pthread.h>
+#include <emscripten/threading.h>
+#include <emscripten/task_scheduler.h>
+#include <emscripten.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#define MAX_WORKERS 64
+
+// Number of tasks each worker deque can hold. Must be a power of two. When a deque is full, spawned tasks run
+// synchronously in the spawning thread.
+#define DEQUE_SIZE 256
+#define DEQUE_MASK (DEQUE_SIZE - 1)
+
+// Capacity of the queue that threads other than the scheduler workers spawn tasks to.
+#define INJECT_QUEUE_SIZE 1024
+
+// Tasks are stored by value in the queues. A task with a null func is a parallel_for range task that calls rangeFunc.
+typedef struct task
+{
+	em_task_func func;
+	em_parallel_for_func rangeFunc;
+	void *arg;
+	em_task_group *group;
+	int begin;
+	int end;
+	int grainSize;
+} task;
+
+// A Chase-Lev work-stealing deque. The owning worker pushes and pops at the bottom, other threads steal from the top.
+typedef struct worker_deque
+{
+	uint32_t top;
+	char padding[60]; // Keep the thieves off the cache line that the owner updates.
+	uint32_t bottom;
+	task tasks[DEQUE_SIZE];
+} worker_deque;
+
+typedef struct worker
+{
+	worker_deque deque;
+	pthread_t thread;
+} worker;
+
+static pthread_mutex_t scheduler_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t scheduler_running = 0;
+static uint32_t shutting_down = 0;
+static worker *workers = 0;
+static int num_workers = 0;
+static pthread_key_t current_worker_key;
+static pthread_once_t current_worker_key_once = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t inject_lock = PTHREAD_MUTEX_INITIALIZER;
+static task inject_queue[INJECT_QUEUE_SIZE];
+static int inject_head = 0;
+static uint32_t inject_count = 0; // Read without the lock to quickly skip an empty queue.
+
+// Idle workers park on wake_epoch. Spawning a task bumps the epoch, so a worker that is about to park after not
+// finding any work sees the epoch change and rechecks the queues instead of sleeping through the new task.
+static uint32_t wake_epoch = 0;
+static uint32_t num_parked = 0;
+
+static uint32_t atomic_add_fetch_u32(uint32_t *addr, uint32_t delta)
+{
+	uint32_t old;
+	do {
+		old = emscripten_atomic_load_u32(addr);
+	} while(emscripten_atomic_cas_u32(addr, old, old + delta) != old);
+	return old + delta;
+}
+
+static void create_current_worker_key()
+{
+	pthread_key_create(&current_worker_key, 0);
+}
+
+static worker *current_worker()
+{
+	return (worker*)pthread_getspecific(current_worker_key);
+}
+
+static int deque_push(worker_deque *d, const task *t)
+{
+	uint32_t b = emscripten_atomic_load_u32(&d->bottom);
+	uint32_t top = emscripten_atomic_load_u32(&d->top);
+	if ((int32_t)(b - top) >= DEQUE_SIZE) return 0;
+	d->tasks[b & DEQUE_MASK] = *t;
+	emscripten_atomic_store_u32(&d->bottom, b + 1);
+	return 1;
+}
+
+static int deque_pop(worker_deque *d, task *out)
+{
+	uint32_t b = emscripten_atomic_load_u32(&d->bottom) - 1;
+	emscripten_atomic_store_u32(&d->bottom, b);
+	uint32_t top = emscripten_atomic_load_u32(&d->top);
+	if ((int32_t)(b - top) < 0)
+	{
+		// Empty.
+		emscripten_atomic_store_u32(&d->bottom, top);
+		return 0;
+	}
+	*out = d->tasks[b & DEQUE_MASK];
+	if (b != top) return 1;
+
+	// Taking the last task races with thieves.
+	int won = emscripten_atomic_cas_u32(&d->top, top, top + 1) == top;
+	emscripten_atomic_store_u32(&d->bottom, top + 1);
+	return won;
+}
+
+static int deque_steal(worker_deque *d, task *out)
+{
+	uint32_t top = emscripten_atomic_load_u32(&d->top);
+	uint32_t b = emscripten_atomic_load_u32(&d->bottom);
+	if ((int32_t)(b - top) <= 0) return 0;
+	// The owner does not overwrite this slot before top moves past it, so the copy is only torn if the cas fails.
+	*out = d->tasks[top & DEQUE_MASK];
+	return emscripten_atomic_cas_u32(&d->top, top, top + 1) == top;
+}
+
+static int inject_push(const task *t)
+{
+	pthread_mutex_lock(&inject_lock);
+	int count = emscripten_atomic_load_u32(&inject_count);
+	int pushed = count < INJECT_QUEUE_SIZE;
+	if (pushed)
+	{
+		inject_queue[(inject_head + count) % INJECT_QUEUE_SIZE] = *t;
+		emscripten_atomic_store_u32(&inject_count, count + 1);
+	}
+	pthread_mutex_unlock(&inject_lock);
+	return pushed;
+}
+
+static int inject_pop(task *out)
+{
+	if (!emscripten_atomic_load_u32(&inject_count)) return 0;
+	pthread_mutex_lock(&inject_lock);
+	int count = emscripten_atomic_load_u32(&inject_count);
+	if (count > 0)
+	{
+		*out = inject_queue[inject_head];
+		inject_head = (inject_head + 1) % INJECT_QUEUE_SIZE;
+		emscripten_atomic_store_u32(&inject_count, count - 1);
+	}
+	pthread_mutex_unlock(&inject_lock);
+	return count > 0;
+}
+
+// Looks for a task to run: first from the own deque, then from the inject queue, and finally by stealing from the
+// other workers, starting from a different victim each time to spread out the contention.
+static int find_task(worker *self, task *out)
+{
+	if (self && deque_pop(&self->deque, out)) return 1;
+	if (inject_pop(out)) return 1;
+
+	static uint32_t next_victim = 0;
+	int n = num_workers;
+	if (n == 0) return 0;
+	int start = atomic_add_fetch_u32(&next_victim, 1) % n;
+	for(int i = 0; i < n; ++i)
+	{
+		worker *victim = &workers[(start + i) % n];
+		if (victim != self && deque_steal(&victim->deque, out)) return 1;
+	}
+	return 0;
+}
+
+static void wake_one_worker()
+{
+	atomic_add_fetch_u32(&wake_epoch, 1);
+	if (emscripten_atomic_load_u32(&num_parked) > 0)
+		emscripten_futex_wake(&wake_epoch, 1);
+}
+
+static void run_task(task *t);
+
+static void spawn(const task *t)
+{
+	worker *self = current_worker();
+	int queued = self ? deque_push(&self->deque, t) : inject_push(t);
+	if (queued)
+		wake_one_worker();
+	else
+	{
+		// Out of queue space: run the task right away instead.
+		task copy = *t;
+		run_task(&copy);
+	}
+}
+
+static void finish_task(em_task_group *group)
+{
+	uint32_t pending;
+	uint32_t old;
+	do {
+		old = emscripten_atomic_load_u32(&group->pendingTasks);
+		pending = old - 1;
+	} while(emscripten_atomic_cas_u32(&group->pendingTasks, old, pending) != old);
+	if (pending == 0)
+		emscripten_futex_wake(&group->pendingTasks, INT_MAX);
+}
+
+static void run_task(task *t)
+{
+	if (t->func)
+		t->func(t->arg);
+	else
+	{
+		// Split off the upper halves of the range for others to steal, and process what remains here.
+		int begin = t->begin;
+		int end = t->end;
+		while(end - begin > t->grainSize)
+		{
+			int mid = begin + (end - begin) / 2;
+			task upper = *t;
+			upper.begin = mid;
+			upper.end = end;
+			atomic_add_fetch_u32(&t->group->pendingTasks, 1);
+			spawn(&upper);
+			end = mid;
+		}
+		t->rangeFunc(begin, end, t->arg);
+	}
+	finish_task(t->group);
+}
+
+static void *worker_main(void *arg)
+{
+	worker *self = (worker*)arg;
+	pthread_setspecific(current_worker_key, self);
+
+	task t;
+	for(;;)
+	{
+		if (find_task(self, &t))
+		{
+			run_task(&t);
+			continue;
+		}
+
+		// Announce that we are about to park before the final check, see wake_epoch.
+		atomic_add_fetch_u32(&num_parked, 1);
+		uint32_t epoch = emscripten_atomic_load_u32(&wake_epoch);
+		if (find_task(self, &t))
+		{
+			emscripten_atomic_sub_u32(&num_parked, 1);
+			run_task(&t);
+			continue;
+		}
+		if (emscripten_atomic_load_u32(&shutting_down))
+		{
+			emscripten_atomic_sub_u32(&num_parked, 1);
+			break;
+		}
+		emscripten_futex_wait(&wake_epoch, epoch, INFINITY);
+		emscripten_atomic_sub_u32(&num_parked, 1);
+	}
+	return 0;
+}
+
+int emscripten_task_scheduler_init(int numWorkers)
+{
+	pthread_once(&current_worker_key_once, create_current_worker_key);
+	pthread_mutex_lock(&scheduler_lock);
+	if (emscripten_atomic_load_u32(&scheduler_running))
+	{
+		pthread_mutex_unlock(&scheduler_lock);
+		return EBUSY;
+	}
+
+	if (numWorkers == 0) numWorkers = emscripten_num_logical_cores() - 1;
+	if (numWorkers < 0) numWorkers = 0;
+	if (numWorkers > MAX_WORKERS) numWorkers = MAX_WORKERS;
+
+	emscripten_atomic_store_u32(&shutting_down, 0);
+	workers = numWorkers > 0 ? (worker*)calloc(numWorkers, sizeof(worker)) : 0;
+	num_workers = 0;
+	for(int i = 0; i < numWorkers; ++i)
+	{
+		// If threads cannot be created (e.g. no threading support), run with the workers created so far. Waiting
+		// threads execute the tasks themselves, so this works even without any workers.
+		if (pthread_create(&workers[i].thread, 0, worker_main, &workers[i]) != 0) break;
+		++num_workers;
+	}
+	emscripten_atomic_store_u32(&scheduler_running, 1);
+	pthread_mutex_unlock(&scheduler_lock);
+	return 0;
+}
+
+void emscripten_task_scheduler_shutdown()
+{
+	pthread_mutex_lock(&scheduler_lock);
+	if (emscripten_atomic_load_u32(&scheduler_running))
+	{
+		assert(emscripten_atomic_load_u32(&inject_count) == 0);
+		emscripten_atomic_store_u32(&shutting_down, 1);
+		atomic_add_fetch_u32(&wake_epoch, 1);
+		emscripten_futex_wake(&wake_epoch, INT_MAX);
+		for(int i = 0; i < num_workers; ++i)
+			pthread_join(workers[i].thread, 0);
+		free(workers);
+		workers = 0;
+		num_workers = 0;
+		emscripten_atomic_store_u32(&scheduler_running, 0);
+	}
+	pthread_mutex_unlock(&scheduler_lock);
+}
+
+int emscripten_task_scheduler_num_workers()
+{
+	return emscripten_atomic_load_u32(&scheduler_running) ? num_workers : 0;
+}
+
+static void ensure_scheduler_running()
+{
+	if (!emscripten_atomic_load_u32(&scheduler_running))
+		emscripten_task_scheduler_init(0); // Returns EBUSY if another thread started it first, which is fine.
+}
+
+void emscripten_task_group_init(em_task_group *group)
+{
+	group->pendingTasks = 0;
+}
+
+void emscripten_task_group_run(em_task_group *group, em_task_func func, void *arg)
+{
+	assert(func);
+	ensure_scheduler_running();
+	task t = { func, 0, arg, group, 0, 0, 0 };
+	atomic_add_fetch_u32(&group->pendingTasks, 1);
+	spawn(&t);
+}
+
+void emscripten_task_group_wait(em_task_group *group)
+{
+	worker *self = current_worker();
+	int onMainThread = emscripten_is_main_runtime_thread();
+	task t;
+	for(;;)
+	{
+		uint32_t pending = emscripten_atomic_load_u32(&group->pendingTasks);
+		if (pending == 0) break;
+		if (find_task(self, &t))
+		{
+			run_task(&t);
+			continue;
+		}
+		// The remaining tasks are running on other threads. The main thread keeps servicing proxied calls
+		// while it waits, since the tasks might be blocked on them. Wake up periodically to help with any
+		// tasks that the running ones spawn.
+		if (onMainThread) emscripten_main_thread_process_queued_calls();
+		emscripten_futex_wait(&group->pendingTasks, pending, 1);
+	}
+}
+
+void emscripten_parallel_for(int begin, int end, int grainSize, em_parallel_for_func func, void *arg)
+{
+	if (end <= begin) return;
+	ensure_scheduler_running();
+	if (grainSize <= 0)
+	{
+		// Aim at a few ranges per thread so that the load evens out by stealing.
+		grainSize = (end - begin) / (8 * (emscripten_task_scheduler_num_workers() + 1));
+		if (grainSize < 1) grainSize = 1;
+	}
+
+	em_task_group group = EM_TASK_GROUP_INITIALIZER;
+	task t = { 0, func, arg, &group, begin, end, grainSize };
+	group.pendingTasks = 1;
+	run_task(&t);
+	emscripten_task_group_wait(&group);
+}
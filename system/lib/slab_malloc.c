@@ -0,0 +1,324 @@
+/*
+   malloc/free with size-class slabs for small objects in front of dlmalloc,
+   selected with -s MALLOC="slab". dlmalloc is built with USE_DL_PREFIX and
+   serves all larger requests.
+
+   Requests of up to SLAB_MAX_SIZE bytes are rounded up to a multiple of
+   SLAB_GRANULE and served from slabs: SLAB_SIZE-aligned blocks from dlmalloc
+   that hold objects of a single size class, with a bitmap of the free objects
+   in the slab header. Slab objects have no per-object header, and small objects
+   of one size are packed together instead of fragmenting the general heap.
+
+   A pointer belongs to a slab if its SLAB_SIZE page is marked in slab_pages;
+   everything else was allocated by dlmalloc.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <malloc.h>
+
+#if __EMSCRIPTEN_PTHREADS__
+#include <pthread.h>
+#endif
+
+void* dlmalloc(size_t bytes);
+void dlfree(void* mem);
+void* dlcalloc(size_t num, size_t size);
+void* dlrealloc(void* mem, size_t bytes);
+void* dlrealloc_in_place(void* mem, size_t bytes);
+void* dlmemalign(size_t alignment, size_t bytes);
+int dlposix_memalign(void** pp, size_t alignment, size_t bytes);
+void* dlvalloc(size_t bytes);
+void* dlpvalloc(size_t bytes);
+struct mallinfo dlmallinfo(void);
+int dlmallopt(int param, int value);
+int dlmalloc_trim(size_t pad);
+void dlmalloc_stats(void);
+size_t dlmalloc_usable_size(void* mem);
+size_t dlmalloc_footprint(void);
+size_t dlmalloc_max_footprint(void);
+void** dlindependent_calloc(size_t n, size_t size, void** chunks);
+void** dlindependent_comalloc(size_t n, size_t* sizes, void** chunks);
+
+#define SLAB_SIZE_LOG2 14
+#define SLAB_SIZE (1U << SLAB_SIZE_LOG2)
+
+// Object sizes are multiples of the malloc alignment.
+#define SLAB_GRANULE 8
+#define SLAB_MAX_SIZE 128
+#define NUM_SIZE_CLASSES (SLAB_MAX_SIZE / SLAB_GRANULE)
+
+// One bit per SLAB_SIZE page of the 32-bit address space.
+#define NUM_PAGE_WORDS ((1U << (32 - SLAB_SIZE_LOG2)) / 32)
+
+typedef struct Slab {
+  struct Slab* prev; // in the list of slabs of the size class that have free objects
+  struct Slab* next;
+  uint32_t object_size;
+  uint32_t num_free;
+  uint32_t first_free_word; // bitmap words below this one have no free objects
+  char* objects;
+  uint32_t free_bits[]; // a set bit for each free object
+} Slab;
+
+typedef struct SizeClass {
+  Slab* partial; // slabs with free objects, allocations are served from the first one
+  Slab* empty; // one slab with no objects in use, kept for reuse
+  uint32_t capacity; // objects per slab, 0 until the first slab is created
+  uint32_t num_words; // bitmap words per slab
+} SizeClass;
+
+static SizeClass size_classes[NUM_SIZE_CLASSES];
+static uint32_t slab_pages[NUM_PAGE_WORDS];
+
+// Bytes of free slab objects, reported as free space by mallinfo().
+static size_t slab_free_bytes = 0;
+
+#if __EMSCRIPTEN_PTHREADS__
+static pthread_mutex_t slab_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK() pthread_mutex_lock(&slab_lock)
+#define UNLOCK() pthread_mutex_unlock(&slab_lock)
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
+
+static inline int is_slab_object(void* ptr) {
+  uint32_t page = (uintptr_t)ptr >> SLAB_SIZE_LOG2;
+  return (slab_pages[page >> 5] >> (page & 31)) & 1;
+}
+
+static inline Slab* get_slab(void* ptr) {
+  return (Slab*)((uintptr_t)ptr & ~(uintptr_t)(SLAB_SIZE - 1));
+}
+
+static void mark_page(Slab* slab, int in_use) {
+  uint32_t page = (uintptr_t)slab >> SLAB_SIZE_LOG2;
+  if (in_use) slab_pages[page >> 5] |= 1U << (page & 31);
+  else slab_pages[page >> 5] &= ~(1U << (page & 31));
+}
+
+static void init_size_class(SizeClass* c, uint32_t object_size) {
+  // Fit as many objects as possible after the header and its bitmap.
+  uint32_t capacity = (SLAB_SIZE - sizeof(Slab)) / object_size;
+  for (;;) {
+    uint32_t num_words = (capacity + 31) / 32;
+    uint32_t header = (sizeof(Slab) + num_words * 4 + SLAB_GRANULE - 1) & ~(SLAB_GRANULE - 1);
+    if (header + capacity * object_size <= SLAB_SIZE) {
+      c->capacity = capacity;
+      c->num_words = num_words;
+      return;
+    }
+    capacity--;
+  }
+}
+
+static void push_partial(SizeClass* c, Slab* slab) {
+  slab->prev = 0;
+  slab->next = c->partial;
+  if (c->partial) c->partial->prev = slab;
+  c->partial = slab;
+}
+
+static void remove_partial(SizeClass* c, Slab* slab) {
+  if (slab->prev) slab->prev->next = slab->next;
+  else c->partial = slab->next;
+  if (slab->next) slab->next->prev = slab->prev;
+}
+
+static Slab* create_slab(SizeClass* c, uint32_t object_size) {
+  if (!c->capacity) init_size_class(c, object_size);
+  Slab* slab = (Slab*)dlmemalign(SLAB_SIZE, SLAB_SIZE);
+  if (!slab) return 0;
+  slab->object_size = object_size;
+  slab->num_free = c->capacity;
+  slab->first_free_word = 0;
+  slab->objects = (char*)slab + (((sizeof(Slab) + c->num_words * 4) + SLAB_GRANULE - 1) & ~(SLAB_GRANULE - 1));
+  for (uint32_t i = 0; i < c->num_words; i++) {
+    slab->free_bits[i] = 0xFFFFFFFFU;
+  }
+  if (c->capacity & 31) {
+    slab->free_bits[c->num_words - 1] = (1U << (c->capacity & 31)) - 1;
+  }
+  mark_page(slab, 1);
+  slab_free_bytes += c->capacity * object_size;
+  return slab;
+}
+
+static void destroy_slab(SizeClass* c, Slab* slab) {
+  mark_page(slab, 0);
+  slab_free_bytes -= c->capacity * slab->object_size;
+  dlfree(slab);
+}
+
+static void* slab_malloc(size_t size) {
+  uint32_t index = size ? (size - 1) / SLAB_GRANULE : 0;
+  uint32_t object_size = (index + 1) * SLAB_GRANULE;
+  SizeClass* c = &size_classes[index];
+  LOCK();
+  Slab* slab = c->partial;
+  if (!slab) {
+    if (c->empty) {
+      slab = c->empty;
+      c->empty = 0;
+    } else {
+      slab = create_slab(c, object_size);
+      if (!slab) {
+        UNLOCK();
+        return 0;
+      }
+    }
+    push_partial(c, slab);
+  }
+  uint32_t w = slab->first_free_word;
+  while (!slab->free_bits[w]) w++;
+  uint32_t bits = slab->free_bits[w];
+  slab->free_bits[w] = bits & (bits - 1);
+  slab->first_free_word = w;
+  if (--slab->num_free == 0) remove_partial(c, slab);
+  slab_free_bytes -= object_size;
+  UNLOCK();
+  return slab->objects + (w * 32 + __builtin_ctz(bits)) * object_size;
+}
+
+static void slab_free(void* ptr) {
+  Slab* slab = get_slab(ptr);
+  SizeClass* c = &size_classes[slab->object_size / SLAB_GRANULE - 1];
+  uint32_t i = ((char*)ptr - slab->objects) / slab->object_size;
+  LOCK();
+  slab->free_bits[i >> 5] |= 1U << (i & 31);
+  if (i >> 5 < slab->first_free_word) slab->first_free_word = i >> 5;
+  slab_free_bytes += slab->object_size;
+  if (slab->num_free++ == 0) push_partial(c, slab);
+  if (slab->num_free == c->capacity && !(c->partial == slab && !slab->next)) {
+    // Keep the last slab with free objects in the list, so that a class that
+    // repeatedly allocates and frees a few objects does not cycle slabs.
+    remove_partial(c, slab);
+    if (c->empty) destroy_slab(c, slab);
+    else c->empty = slab;
+  }
+  UNLOCK();
+}
+
+void* malloc(size_t size) {
+  if (size <= SLAB_MAX_SIZE) return slab_malloc(size);
+  return dlmalloc(size);
+}
+
+void free(void* ptr) {
+  if (!ptr) return;
+  if (is_slab_object(ptr)) slab_free(ptr);
+  else dlfree(ptr);
+}
+
+void* calloc(size_t num, size_t size) {
+  size_t bytes = num * size;
+  if (num && bytes / num != size) {
+    errno = ENOMEM;
+    return 0;
+  }
+  if (bytes > SLAB_MAX_SIZE) return dlcalloc(num, size);
+  void* ret = slab_malloc(bytes);
+  if (ret) memset(ret, 0, bytes);
+  return ret;
+}
+
+void* realloc(void* ptr, size_t size) {
+  if (!ptr) return malloc(size);
+  if (!is_slab_object(ptr)) return dlrealloc(ptr, size);
+  size_t old_size = get_slab(ptr)->object_size;
+  if (size <= old_size) return ptr;
+  void* ret = malloc(size);
+  if (!ret) return 0;
+  memcpy(ret, ptr, old_size);
+  slab_free(ptr);
+  return ret;
+}
+
+void* realloc_in_place(void* ptr, size_t size) {
+  if (ptr && is_slab_object(ptr)) return size <= get_slab(ptr)->object_size ? ptr : 0;
+  return dlrealloc_in_place(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  if (alignment <= SLAB_GRANULE) return malloc(size);
+  return dlmemalign(alignment, size);
+}
+
+int posix_memalign(void** pp, size_t alignment, size_t size) {
+  if (alignment == SLAB_GRANULE) {
+    void* ret = malloc(size);
+    if (!ret) return ENOMEM;
+    *pp = ret;
+    return 0;
+  }
+  return dlposix_memalign(pp, alignment, size);
+}
+
+void* valloc(size_t size) {
+  return dlvalloc(size);
+}
+
+void* pvalloc(size_t size) {
+  return dlpvalloc(size);
+}
+
+size_t malloc_usable_size(void* ptr) {
+  if (ptr && is_slab_object(ptr)) return get_slab(ptr)->object_size;
+  return dlmalloc_usable_size(ptr);
+}
+
+struct mallinfo mallinfo(void) {
+  struct mallinfo info = dlmallinfo();
+  LOCK();
+  info.uordblks -= slab_free_bytes;
+  info.fordblks += slab_free_bytes;
+  UNLOCK();
+  return info;
+}
+
+int mallopt(int param, int value) {
+  return dlmallopt(param, value);
+}
+
+int malloc_trim(size_t pad) {
+  LOCK();
+  for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
+    SizeClass* c = &size_classes[i];
+    if (c->empty) {
+      destroy_slab(c, c->empty);
+      c->empty = 0;
+    }
+  }
+  UNLOCK();
+  return dlmalloc_trim(pad);
+}
+
+void malloc_stats(void) {
+  dlmalloc_stats();
+}
+
+size_t malloc_footprint(void) {
+  return dlmalloc_footprint();
+}
+
+size_t malloc_max_footprint(void) {
+  return dlmalloc_max_footprint();
+}
+
+void** independent_calloc(size_t n, size_t size, void** chunks) {
+  return dlindependent_calloc(n, size, chunks);
+}
+
+void** independent_comalloc(size_t n, size_t* sizes, void** chunks) {
+  return dlindependent_comalloc(n, sizes, chunks);
+}
+
+size_t bulk_free(void** array, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    free(array[i]);
+    array[i] = 0;
+  }
+  return 0;
+}
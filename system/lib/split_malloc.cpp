@@ -19,15 +19,32 @@ void* mspace_malloc(mspace space, size_t size);
 void mspace_free(mspace space, void* ptr);
 void* mspace_realloc(mspace msp, void* oldmem, size_t bytes);
 void* mspace_memalign(mspace msp, size_t alignment, size_t bytes);
+size_t mspace_usable_size(const void* mem);
 
 }
 
 #define MAX_SPACES 1000
 
+// Spaces are indexed by the log2 of their free bytes.
+#define NUM_BUCKETS 32
+
+// Empty spaces are kept for reuse until there are more than this many, and then
+// the excess is released back to JS all at once. This avoids reallocating the
+// chunk of a space that is repeatedly emptied and refilled.
+#define MAX_EMPTY_SPACES 4
+
+// dlmalloc's per-chunk overhead, counted as used bytes along with each allocation.
+#define CHUNK_OVERHEAD sizeof(size_t)
+
 static bool initialized = false;
 static size_t total_memory = 0;
 static size_t split_memory = 0;
+static size_t split_memory_shift = 0;
+static size_t split_memory_mask = 0;
 static size_t num_spaces = 0;
+static size_t num_empty_spaces = 0;
+static bool allow_memory_growth = false;
+static bool aborting_malloc = false;
 
 enum AllocateResult {
   OK = 0,
@@ -35,17 +52,47 @@ enum AllocateResult {
   ALREADY_USED = 2
 };
 
+static int log2_floor(size_t x) {
+  return 31 - __builtin_clz(x);
+}
+
+struct Space;
+static void index_space(Space* space);
+static void unindex_space(Space* space);
+
 struct Space {
   mspace space;
   bool allocated; // whether storage is allocated for this chunk, both an ArrayBuffer in JS and an mspace here
+  bool foreign; // whether other code allocated this chunk, so it cannot be used
   size_t count; // how many allocations are in the space
   size_t index; // the index of this space, it then represents memory at SPLIT_MEMORY*index
+  size_t capacity; // how many bytes the space can hold, when empty
+  size_t used; // how many bytes its allocations take, including the overhead of each
+  size_t failed; // the smallest request that failed in this space since the last free in it, or 0
+  int bucket; // the free bytes bucket this space is in, or -1
+  Space* prev; // neighbors in that bucket
+  Space* next;
 
   void init(int i) {
     space = 0;
     allocated = false;
+    foreign = false;
     count = 0;
     index = i;
+    capacity = 0;
+    used = 0;
+    failed = 0;
+    bucket = -1;
+    prev = next = 0;
+  }
+
+  size_t free_bytes() {
+    return capacity - used;
+  }
+
+  // Whether the space has room for the request, as far as we know. Fragmentation may still make it fail.
+  bool may_fit(size_t needed) {
+    return needed <= free_bytes() && (failed == 0 || needed < failed);
   }
 
   AllocateResult allocate() {
@@ -56,6 +103,7 @@ struct Space {
     if (index > 0) {
       if (int(split_memory*(index+1)) < 0) {
         // 32-bit pointer overflow. we could support more than this 2G, up to 4GB, if we made all pointer shifts >>>. likely slower though
+        allocated = false;
         return NO_MEMORY;
       }
       AllocateResult result = (AllocateResult)EM_ASM_INT({
@@ -67,7 +115,11 @@ struct Space {
           return $2; // failed to allocate
         }
       }, index, OK, NO_MEMORY, ALREADY_USED);
-      if (result != OK) return result;
+      if (result != OK) {
+        allocated = false;
+        foreign = result == ALREADY_USED;
+        return result;
+      }
       start = split_memory*index;
     } else {
       // small area in existing chunk 0
@@ -83,26 +135,77 @@ struct Space {
       }
     }
     assert(space);
+    capacity = size;
+    used = 0;
+    failed = 0;
+    num_empty_spaces++;
+    index_space(this);
     return OK;
   }
 
   void free() {
     assert(allocated);
     assert(count == 0);
+    unindex_space(this);
+    num_empty_spaces--;
     allocated = false;
     destroy_mspace((void*)(split_memory*index));
     if (index > 0) {
       EM_ASM_({ freeSplitChunk($0) }, index);
     }
   }
+
+  void* alloc(size_t size, bool malloc, size_t alignment, size_t needed) {
+    void *ret = malloc ? mspace_malloc(space, size) : mspace_memalign(space, alignment, size);
+    if (!ret) {
+      if (failed == 0 || needed < failed) failed = needed;
+      return 0;
+    }
+    if (count == 0) num_empty_spaces--;
+    count++;
+    used += mspace_usable_size(ret) + CHUNK_OVERHEAD;
+    index_space(this);
+    return ret;
+  }
 };
 
 static Space spaces[MAX_SPACES];
+static Space* buckets[NUM_BUCKETS]; // doubly linked lists of allocated spaces, by free bytes
+static unsigned nonempty_buckets = 0; // bit i is set if buckets[i] has any spaces in it
+
+static void unindex_space(Space* space) {
+  if (space->bucket < 0) return;
+  if (space->prev) space->prev->next = space->next;
+  else buckets[space->bucket] = space->next;
+  if (space->next) space->next->prev = space->prev;
+  if (!buckets[space->bucket]) nonempty_buckets &= ~(1u << space->bucket);
+  space->prev = space->next = 0;
+  space->bucket = -1;
+}
+
+// (Re)links a space into the bucket that matches its free bytes. Spaces without free bytes are not indexed.
+static void index_space(Space* space) {
+  size_t free_bytes = space->free_bytes();
+  int bucket = free_bytes > 0 ? log2_floor(free_bytes) : -1;
+  if (bucket == space->bucket) return;
+  unindex_space(space);
+  if (bucket < 0) return;
+  space->bucket = bucket;
+  space->next = buckets[bucket];
+  if (space->next) space->next->prev = space;
+  buckets[bucket] = space;
+  nonempty_buckets |= 1u << bucket;
+}
 
 static void init() {
   total_memory = EM_ASM_INT_V({ return TOTAL_MEMORY; });
   split_memory = EM_ASM_INT_V({ return SPLIT_MEMORY; });
+  assert((split_memory & (split_memory - 1)) == 0); // the JS side relies on this too
+  split_memory_shift = log2_floor(split_memory);
+  split_memory_mask = split_memory - 1;
   num_spaces = EM_ASM_INT_V({ return HEAPU8s.length; });
+  allow_memory_growth = EM_ASM_INT_V({ return ALLOW_MEMORY_GROWTH; });
+  aborting_malloc = EM_ASM_INT_V({ return ABORTING_MALLOC; });
   if (num_spaces >= MAX_SPACES) abort();
   for (int i = 0; i < num_spaces; i++) {
     spaces[i].init(i);
@@ -110,10 +213,8 @@ static void init() {
   initialized = true;
 }
 
-// TODO: optimize, these are powers of 2
-// TODO: add optional asserts in these
-#define space_index(ptr) (((unsigned)ptr) / split_memory)
-#define space_relative(ptr) (((unsigned)ptr) % split_memory)
+#define space_index(ptr) (((unsigned)ptr) >> split_memory_shift)
+#define space_relative(ptr) (((unsigned)ptr) & split_memory_mask)
 
 static mspace get_space(void* ptr) { // for a valid pointer, so the space must already exist
   int index = space_index(ptr);
@@ -123,6 +224,36 @@ static mspace get_space(void* ptr) { // for a valid pointer, so the space must a
   return space.space;
 }
 
+// Finds an allocated space, other than the one to skip, that may fit the request, preferring the ones with the fewest
+// free bytes (approximately: spaces are bucketed by log2 of their free bytes).
+// Only looks at a few spaces in the bucket of the request size, whose free bytes may be too few; all spaces in
+// higher buckets have enough.
+static Space* find_space(size_t needed, Space* skip) {
+  int bucket = log2_floor(needed);
+  int checked = 0;
+  for (Space* space = buckets[bucket]; space && checked < 8; space = space->next, checked++) {
+    if (space != skip && space->may_fit(needed)) return space;
+  }
+  unsigned candidates = bucket + 1 < NUM_BUCKETS ? nonempty_buckets & ~((2u << bucket) - 1) : 0;
+  while (candidates) {
+    bucket = __builtin_ctz(candidates);
+    for (Space* space = buckets[bucket]; space; space = space->next) {
+      if (space != skip && space->may_fit(needed)) return space;
+    }
+    candidates &= candidates - 1;
+  }
+  return 0;
+}
+
+static void release_empty_spaces() {
+  // Keep the lowest empty spaces, release the rest back to JS. Chunk 0 is never released.
+  for (int i = num_spaces - 1; i > 0 && num_empty_spaces > MAX_EMPTY_SPACES / 2; i--) {
+    if (spaces[i].allocated && spaces[i].count == 0) {
+      spaces[i].free();
+    }
+  }
+}
+
 static void* get_memory(size_t size, bool malloc=true, size_t alignment=-1, bool must_succeed=false) {
   if (!initialized) {
     init();
@@ -137,49 +268,48 @@ static void* get_memory(size_t size, bool malloc=true, size_t alignment=-1, bool
     }
     return 0;
   }
-  static int next = 0;
-  int start = next;
-  while (1) { // simple round-robin, while keeping to use the same one as long as it keeps succeeding
-    AllocateResult result = OK;
-    if (!spaces[next].allocated) {
-      result = spaces[next].allocate();
-      if (result == NO_MEMORY) return 0; // mallocation failure
+  size_t needed = size + CHUNK_OVERHEAD;
+  if (!malloc) needed += alignment;
+  // keep using the same space as long as it keeps succeeding, and when it fails, pick the one with the least
+  // room that might fit, without trying the others
+  static int current = 0;
+  Space* space = &spaces[current];
+  if (space->allocated) {
+    void* ret = space->alloc(size, malloc, alignment, needed);
+    if (ret) return ret;
+  }
+  while ((space = find_space(needed, &spaces[current]))) {
+    void* ret = space->alloc(size, malloc, alignment, needed);
+    if (ret) {
+      current = space->index;
+      return ret;
     }
-    if (result == OK) {
-      void *ret;
-      if (malloc) {
-        ret = mspace_malloc(spaces[next].space, size);
-      } else {
-        ret = mspace_memalign(spaces[next].space, alignment, size);
-      }
-      if (ret) {
-        spaces[next].count++;
-        return ret;
-      }
-      if (must_succeed) {
-        EM_ASM({ Module.printErr("failed to allocate in a new space after memory growth, perhaps increase SPLIT_MEMORY?"); });
-        abort();
-      }
-    } else {
-      assert(result == ALREADY_USED); // continue on to the next space
+  }
+  // none of the existing spaces can allocate, so start using a new one
+  for (int i = 0; i < num_spaces; i++) {
+    if (spaces[i].allocated || spaces[i].foreign) continue;
+    AllocateResult result = spaces[i].allocate();
+    if (result == NO_MEMORY) return 0; // mallocation failure
+    if (result == ALREADY_USED) continue;
+    void* ret = spaces[i].alloc(size, malloc, alignment, needed);
+    if (ret) {
+      current = i;
+      return ret;
     }
-    next++;
-    if (next == num_spaces) next = 0;
-    if (next == start) break;
-  }
-  // we cycled, so none of them can allocate
-  int returnNull = EM_ASM_INT_V({
-    if (!ABORTING_MALLOC && !ALLOW_MEMORY_GROWTH) return 1; // malloc can return 0, and we cannot grow
-    if (!ALLOW_MEMORY_GROWTH) {
-      abortOnCannotGrowMemory();
+    if (must_succeed) {
+      EM_ASM({ Module.printErr("failed to allocate in a new space after memory growth, perhaps increase SPLIT_MEMORY?"); });
+      abort();
     }
+  }
+  // all spaces are in use, so none of them can allocate
+  if (!allow_memory_growth) {
+    if (!aborting_malloc) return 0; // malloc can return 0, and we cannot grow
+    EM_ASM({ abortOnCannotGrowMemory() });
     return 0;
-  });
-  if (returnNull) return 0;
+  }
   // memory growth is on, add another chunk
   if (num_spaces + 1 >= MAX_SPACES) abort();
   spaces[num_spaces].init(num_spaces);
-  next = num_spaces;
   num_spaces++;
   return get_memory(size, malloc, alignment, true);
 }
@@ -199,17 +329,29 @@ void free(void* ptr) {
   int index = space_index(ptr);
   Space& space = spaces[index];
   assert(space.count > 0);
+  space.used -= mspace_usable_size(ptr) + CHUNK_OVERHEAD;
+  space.failed = 0;
   mspace_free(get_space(ptr), ptr);
   space.count--;
+  index_space(&space);
   if (space.count == 0) {
-    spaces[index].free();
+    num_empty_spaces++;
+    if (num_empty_spaces > MAX_EMPTY_SPACES) {
+      release_empty_spaces();
+    }
   }
 }
 
 void* realloc(void* ptr, size_t newsize) {
   if (!ptr) return malloc(newsize);
+  Space& space = spaces[space_index(ptr)];
+  size_t oldsize = mspace_usable_size(ptr);
   void* ret = mspace_realloc(get_space(ptr), ptr, newsize);
-  if (ret) return ret;
+  if (ret) {
+    space.used += mspace_usable_size(ret) - oldsize;
+    index_space(&space);
+    return ret;
+  }
   ret = malloc(newsize);
   if (!ret) return 0;
   size_t copysize = newsize;
@@ -247,4 +389,3 @@ void* sbrk(intptr_t increment) {
 }
 
 }
-
@@ -0,0 +1,93 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <emscripten.h>
+
+// Filesystem microbenchmarks: lookups of files in large and deep directory trees. Each result is printed as
+// MICROBENCHMARK {"name": ..., "callsPerSecond": ...}, see test_benchmark.py.
+
+#define NUM_DIRS 100
+#define FILES_PER_DIR 1000
+#define LOOKUPS 200000
+
+static char path[256];
+
+static const char *file_path(int dir, int file)
+{
+  sprintf(path, "/bench/dir%d/sub/file%d.dat", dir, file);
+  return path;
+}
+
+static void report(const char *name, int calls, double start)
+{
+  double msecs = emscripten_get_now() - start;
+  printf("MICROBENCHMARK {\"name\": \"%s\", \"callsPerSecond\": %d}\n", name, (int)(calls * 1000.0 / msecs));
+}
+
+int main()
+{
+  double start = emscripten_get_now();
+  mkdir("/bench", 0777);
+  for(int d = 0; d < NUM_DIRS; ++d)
+  {
+    sprintf(path, "/bench/dir%d", d);
+    mkdir(path, 0777);
+    sprintf(path, "/bench/dir%d/sub", d);
+    mkdir(path, 0777);
+    for(int f = 0; f < FILES_PER_DIR; ++f)
+    {
+      int fd = open(file_path(d, f), O_CREAT | O_WRONLY, 0666);
+      assert(fd >= 0);
+      close(fd);
+    }
+  }
+  report("create", NUM_DIRS * FILES_PER_DIR, start);
+
+  struct stat st;
+  start = emscripten_get_now();
+  for(int i = 0; i < LOOKUPS; ++i)
+  {
+    int r = stat(file_path(i % NUM_DIRS, (i * 7919) % FILES_PER_DIR), &st);
+    assert(r == 0);
+  }
+  report("stat", LOOKUPS, start);
+
+  // The same few files, as an application reopening its hot assets would.
+  start = emscripten_get_now();
+  for(int i = 0; i < LOOKUPS; ++i)
+  {
+    int fd = open(file_path(i % 4, i % 8), O_RDONLY);
+    assert(fd >= 0);
+    close(fd);
+  }
+  report("open_close_hot", LOOKUPS, start);
+
+  start = emscripten_get_now();
+  for(int i = 0; i < LOOKUPS; ++i)
+  {
+    int r = stat("/bench/dir0/sub/missing", &st);
+    assert(r == -1);
+  }
+  report("stat_missing", LOOKUPS, start);
+
+  // Renames invalidate cached paths.
+  start = emscripten_get_now();
+  for(int i = 0; i < LOOKUPS / 10; ++i)
+  {
+    char to[256];
+    sprintf(to, "/bench/dir%d/sub/renamed", i % NUM_DIRS);
+    int r = rename(file_path(i % NUM_DIRS, 0), to);
+    assert(r == 0);
+    r = stat(to, &st);
+    assert(r == 0);
+    r = rename(to, file_path(i % NUM_DIRS, 0));
+    assert(r == 0);
+  }
+  report("rename_stat", LOOKUPS / 10, start);
+
+  printf("ok.\n");
+  return 0;
+}
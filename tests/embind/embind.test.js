@@ -1235,6 +1235,39 @@ module({
             assert.deepEqual({field: [1, 2, 3, 4]}, d);
         });
 
+        test("can pass trivially copyable tuples by value", function() {
+            for (var i = 0; i < 32; ++i) {
+                var c = cm.emval_test_take_and_return_PODTuple([i, 0.5, -2]);
+                assert.deepEqual([i, 0.5, -2], c);
+            }
+        });
+
+        test("can pass trivially copyable structs by value", function() {
+            var s = {i8: -5, u16: 65535, flag: true, i32: -2147483648, u32: 4294967295, f64: 0.1};
+            assert.deepEqual(s, cm.emval_test_take_and_return_PODStruct(s));
+
+            s = {i8: 127, u16: 0, flag: false, i32: 2147483647, u32: 0, f64: -1e300};
+            assert.deepEqual(s, cm.emval_test_take_and_return_PODStruct(s));
+        });
+
+        test("trivially copyable struct fields are range checked", function() {
+            var e = assert.throws(TypeError, function() {
+                cm.emval_test_take_and_return_PODStruct({i8: 0, u16: 65536, flag: false, i32: 0, u32: 0, f64: 0});
+            });
+            assert.equal('Passing a number "65536" from JS side to C/C++ side to an argument of type "unsigned short", which is outside the valid range [0, 65535]!', e.message);
+
+            e = assert.throws(TypeError, function() {
+                cm.emval_test_take_and_return_PODStruct({i8: 0, u16: 0, flag: false, i32: 0, u32: 0});
+            });
+            assert.equal('Missing field', e.message);
+        });
+
+        test("unbound fields of trivially copyable structs keep their initial value", function() {
+            for (var i = 0; i < 32; ++i) {
+                assert.equal(42, cm.emval_test_get_unbound_field({bound: i}));
+            }
+        });
+
         test("can clone handles", function() {
             var a = new cm.ValHolder({});
             assert.equal(1, cm.count_emval_handles());
@@ -1749,6 +1782,21 @@ module({
             impl.delete();
         });
 
+        test("method names passed from reused C++ buffers are looked up again", function() {
+            var impl = cm.DynamicallyNamedMethods.implement({
+                first: function() {
+                    return "first";
+                },
+                second: function() {
+                    return "second";
+                },
+            });
+            assert.equal("first", cm.callNamedMethod(impl, "first"));
+            assert.equal("second", cm.callNamedMethod(impl, "second"));
+            assert.equal("first", cm.callNamedMethod(impl, "first"));
+            impl.delete();
+        });
+
         test("returning a cached new shared pointer from interfaces implemented in JS code does not leak", function() {
             var derived = cm.embind_test_return_smart_derived_ptr();
             var impl = cm.AbstractClass.implement({
@@ -2493,6 +2541,98 @@ module({
         });
     });
 
+    BaseFixture.extend("function registration", function() {
+        test("names can be temporaries", function() {
+            assert.equal(0, cm.generated_function_zero());
+            assert.equal(1, cm.generated_function_one());
+        });
+    });
+
+    BaseFixture.extend("batched functions", function() {
+        test("recorded calls run in order when flushed", function() {
+            var cb = new cm.CommandBuffer(1024);
+            cb.batched_append(1, 0.5, -2.25, "a");
+            cb.batched_append(-7, 3, 1e10, "b");
+            assert.equal("", cm.take_batched_log());
+            assert.equal(80, cb.getPendingBytes());
+
+            cb.flush();
+            assert.equal(0, cb.getPendingBytes());
+            assert.equal("1 0.5 -2.25 a;-7 3 1e+10 b;", cm.take_batched_log());
+            cb.delete();
+        });
+
+        test("full buffer flushes automatically", function() {
+            var counter = new cm.BatchedCounter;
+            var cb = new cm.CommandBuffer(64);
+            for (var i = 0; i < 10; ++i) {
+                cb.batched_increment(counter, i);
+            }
+            assert.equal(28, counter.getValue());
+            cb.flush();
+            assert.equal(45, counter.getValue());
+            cb.delete();
+            counter.delete();
+        });
+
+        test("delete flushes pending calls", function() {
+            var counter = new cm.BatchedCounter;
+            var cb = new cm.CommandBuffer;
+            cb.batched_increment(counter, 3);
+            cb.delete();
+            assert.equal(3, counter.getValue());
+            counter.delete();
+        });
+
+        test("recording checks arguments", function() {
+            var cb = new cm.CommandBuffer(1024);
+            var e = assert.throws(cm.BindingError, function() {
+                cb.batched_increment(1);
+            });
+            assert.equal('function batched_increment called with 1 arguments, expected 2 args!', e.message);
+
+            e = assert.throws(TypeError, function() {
+                cb.batched_append("x", 0, 0, "");
+            });
+            assert.equal('Cannot convert "x" to int', e.message);
+            cb.delete();
+        });
+
+        test("buffer must hold at least one call", function() {
+            var cb = new cm.CommandBuffer(32);
+            var e = assert.throws(cm.BindingError, function() {
+                cb.batched_append(1, 2, 3, "four");
+            });
+            assert.equal('CommandBuffer is too small to record batched_append', e.message);
+            cb.delete();
+        });
+
+        test("cannot record into a buffer while it is being flushed", function() {
+            var cb = new cm.CommandBuffer(1024);
+            var seen = [];
+            cm.batchedCallback = function(i) {
+                seen.push(i);
+                if (i === 1) {
+                    cb.batched_call_back(3);
+                }
+            };
+            cb.batched_call_back(1);
+            cb.batched_call_back(2);
+            var e = assert.throws(cm.BindingError, function() {
+                cb.flush();
+            });
+            assert.equal('Cannot record batched_call_back into a CommandBuffer while it is being flushed', e.message);
+            assert.deepEqual([1], seen);
+            assert.equal(0, cb.getPendingBytes());
+
+            cb.batched_call_back(4);
+            cb.flush();
+            assert.deepEqual([1, 4], seen);
+            delete cm.batchedCallback;
+            cb.delete();
+        });
+    });
+
     BaseFixture.extend("intrusive pointers", function() {
         test("can pass intrusive pointers", function() {
             var ic = new cm.IntrusiveClass;
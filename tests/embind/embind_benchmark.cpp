@@ -32,6 +32,11 @@ int __attribute__((noinline)) returns_input(int i)
     return i;
 }
 
+void __attribute__((noinline)) increment_counter_by(int n)
+{
+    counter += n;
+}
+
 extern void increment_counter_benchmark_js(int N);
 extern void returns_input_benchmark_js();
 extern void sum_int_benchmark_js();
@@ -70,6 +75,15 @@ public:
 
 Vec3 add(const Vec3 &lhs, const Vec3 &rhs) { return Vec3(lhs.x+rhs.x, lhs.y+rhs.y, lhs.z+rhs.z); }
 
+struct Vec4
+{
+    float x, y, z, w;
+};
+
+Vec4 __attribute__((noinline)) scale_vec4(const Vec4 &v, float s) { return Vec4{v.x*s, v.y*s, v.z*s, v.w*s}; }
+
+std::string __attribute__((noinline)) returns_string(const std::string &s) { return s; }
+
 class Transform
 {
 public:
@@ -155,6 +169,15 @@ EMSCRIPTEN_SYMBOL(call1);
 EMSCRIPTEN_SYMBOL(call_with_typed_array);
 EMSCRIPTEN_SYMBOL(call_with_memory_view);
 EMSCRIPTEN_SYMBOL(Uint8Array);
+EMSCRIPTEN_SYMBOL(x);
+
+unsigned sum_val_property(unsigned N, emscripten::val v) {
+    unsigned sum = 0;
+    for (unsigned i = 0; i < N; ++i) {
+        sum += v[x_symbol].as<unsigned>();
+    }
+    return sum;
+}
 
 class InterfaceWrapper : public emscripten::wrapper<Interface>
 {
@@ -266,12 +289,24 @@ EMSCRIPTEN_BINDINGS(benchmark)
     function("create_game_object", &create_game_object);
     function("pass_gameobject_ptr", &pass_gameobject_ptr);
     function("add", &add);
+
+    value_object<Vec4>("Vec4")
+        .field("x", &Vec4::x)
+        .field("y", &Vec4::y)
+        .field("z", &Vec4::z)
+        .field("w", &Vec4::w);
+
+    function("scale_vec4", &scale_vec4);
+    function("returns_string", &returns_string);
+    function("sum_val_property", &sum_val_property);
     
     function("get_counter", &get_counter);
     function("increment_counter", &increment_counter);
     function("returns_input", &returns_input);
     function("sum_int", &sum_int);
     function("sum_float", &sum_float);
+    function("increment_counter_by", &increment_counter_by);
+    batched_function("increment_counter_by", &increment_counter_by);
     
     class_<Foo>("Foo")
         .constructor<>()
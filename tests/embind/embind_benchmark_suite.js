@@ -0,0 +1,127 @@
+// Headless embind microbenchmark suite. Built together with
+// embind_benchmark.cpp by test_benchmark.py (test_embind_microbenchmarks)
+// and run under node. Prints one line per benchmark:
+//
+//   MICROBENCHMARK {"name": ..., "callsPerSecond": ...}
+
+function _run_embind_benchmark_suite() {
+    var REPS = 5;
+    var N = 100000;
+
+    function now() {
+        if (typeof process !== 'undefined' && process.hrtime) {
+            var t = process.hrtime();
+            return t[0] * 1e3 + t[1] / 1e6;
+        }
+        return Date.now();
+    }
+
+    // fn(n) must perform n calls of the operation being measured.
+    function measure(name, fn) {
+        fn(N / 10); // warm up the JITs
+        var best = 0;
+        for (var rep = 0; rep < REPS; ++rep) {
+            var start = now();
+            fn(N);
+            var elapsed = now() - start;
+            best = Math.max(best, N / (Math.max(elapsed, 1e-3) / 1000));
+        }
+        Module.print('MICROBENCHMARK ' + JSON.stringify({
+            name: name,
+            callsPerSecond: Math.round(best),
+        }));
+    }
+
+    measure('void call', function(n) {
+        for (var i = 0; i < n; ++i) {
+            Module['increment_counter']();
+        }
+    });
+
+    measure('int call', function(n) {
+        var r = 0;
+        for (var i = 0; i < n; ++i) {
+            r += Module['sum_int'](i, 2, 3, 4, 5, 6, 7, 8, 9);
+        }
+        return r;
+    });
+
+    measure('float call', function(n) {
+        var r = 0;
+        for (var i = 0; i < n; ++i) {
+            r += Module['sum_float'](i, 2, 3, 4, 5, 6, 7, 8, 9);
+        }
+        return r;
+    });
+
+    measure('batched int call', function(n) {
+        var commands = new Module['CommandBuffer'](64 * 1024);
+        for (var i = 0; i < n; ++i) {
+            commands['increment_counter_by'](i);
+        }
+        commands['delete']();
+    });
+
+    measure('std::string round trip', function(n) {
+        var r = 0;
+        for (var i = 0; i < n; ++i) {
+            r += Module['returns_string']('hello, embind').length;
+        }
+        return r;
+    });
+
+    measure('val round trip', function(n) {
+        var v = 1;
+        for (var i = 0; i < n; ++i) {
+            v = Module['returns_val'](v);
+        }
+        return v;
+    });
+
+    var object = { x: 1 };
+    measure('val property access', function(n) {
+        return Module['sum_val_property'](n, object);
+    });
+
+    measure('value_array conversion', function(n) {
+        var v = [0, 0, 0];
+        for (var i = 0; i < n; ++i) {
+            v = Module['add'](v, [1, 2, 3]);
+        }
+        return v;
+    });
+
+    measure('value_object conversion', function(n) {
+        var v = { x: 1, y: 2, z: 3, w: 4 };
+        for (var i = 0; i < n; ++i) {
+            v = Module['scale_vec4'](v, 1);
+        }
+        return v;
+    });
+
+    var interface0 = Module['Interface']['implement']({
+        'call0': function() {
+        },
+    });
+    measure('virtual dispatch void', function(n) {
+        Module['callInterface0'](n, interface0);
+    });
+    interface0['delete']();
+
+    var interface1 = Module['Interface']['implement']({
+        'call1': function(s1, s2) {
+            return s1 + s2;
+        },
+    });
+    measure('virtual dispatch std::wstring', function(n) {
+        // callInterface1 makes 7 calls per 7 iterations, on fixed-size strings.
+        Module['callInterface1'](n, interface1);
+    });
+    interface1['delete']();
+}
+
+if (Module['calledRun']) {
+    _run_embind_benchmark_suite();
+} else {
+    Module['postRun'] = [].concat(Module['postRun'] || [], _run_embind_benchmark_suite);
+}
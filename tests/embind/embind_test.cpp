@@ -873,6 +873,36 @@ TupleInStruct emval_test_take_and_return_TupleInStruct(TupleInStruct cs) {
     return cs;
 }
 
+struct PODTuple {
+    float x, y, z;
+};
+
+PODTuple emval_test_take_and_return_PODTuple(PODTuple t) {
+    return t;
+}
+
+struct PODStruct {
+    signed char i8;
+    unsigned short u16;
+    bool flag;
+    int i32;
+    unsigned u32;
+    double f64;
+};
+
+PODStruct emval_test_take_and_return_PODStruct(PODStruct s) {
+    return s;
+}
+
+struct PartiallyBoundPODStruct {
+    int bound;
+    int unbound = 42;
+};
+
+int emval_test_get_unbound_field(PartiallyBoundPODStruct s) {
+    return s.unbound;
+}
+
 enum Enum { ONE, TWO };
 
 Enum emval_test_take_and_return_Enum(Enum e) {
@@ -1289,6 +1319,26 @@ std::shared_ptr<PolySecondBase> passHeldAbstractClass(std::shared_ptr<HeldAbstra
     return p;
 }
 
+struct DynamicallyNamedMethods {
+    virtual ~DynamicallyNamedMethods() {}
+    virtual std::string callNamed(const std::string& name) = 0;
+};
+
+struct DynamicallyNamedMethodsWrapper : public wrapper<DynamicallyNamedMethods> {
+    EMSCRIPTEN_WRAPPER(DynamicallyNamedMethodsWrapper);
+
+    virtual std::string callNamed(const std::string& name) override {
+        // Every method name is passed from the same address.
+        static char buffer[32];
+        buffer[name.copy(buffer, sizeof(buffer) - 1)] = 0;
+        return call<std::string>(buffer);
+    }
+};
+
+std::string callNamedMethod(DynamicallyNamedMethods& o, const std::string& name) {
+    return o.callNamed(name);
+}
+
 void passShared(AbstractClass& ac) {
     auto p = std::make_shared<Derived>();
     ac.passShared(p);
@@ -1340,6 +1390,11 @@ EMSCRIPTEN_BINDINGS(interface_tests) {
         .function("method", &HeldAbstractClass::method, pure_virtual())
         ;
     function("passHeldAbstractClass", &passHeldAbstractClass);
+
+    class_<DynamicallyNamedMethods>("DynamicallyNamedMethods")
+        .allow_subclass<DynamicallyNamedMethodsWrapper>("DynamicallyNamedMethodsWrapper")
+        ;
+    function("callNamedMethod", &callNamedMethod);
 }
 
 template<typename T, size_t sizeOfArray>
@@ -1709,6 +1764,31 @@ EMSCRIPTEN_BINDINGS(tests) {
 
     function("emval_test_take_and_return_TupleInStruct", &emval_test_take_and_return_TupleInStruct);
 
+    value_array<PODTuple>("PODTuple")
+        .element(&PODTuple::x)
+        .element(&PODTuple::y)
+        .element(&PODTuple::z)
+        ;
+
+    function("emval_test_take_and_return_PODTuple", &emval_test_take_and_return_PODTuple);
+
+    value_object<PODStruct>("PODStruct")
+        .field("i8", &PODStruct::i8)
+        .field("u16", &PODStruct::u16)
+        .field("flag", &PODStruct::flag)
+        .field("i32", &PODStruct::i32)
+        .field("u32", &PODStruct::u32)
+        .field("f64", &PODStruct::f64)
+        ;
+
+    function("emval_test_take_and_return_PODStruct", &emval_test_take_and_return_PODStruct);
+
+    value_object<PartiallyBoundPODStruct>("PartiallyBoundPODStruct")
+        .field("bound", &PartiallyBoundPODStruct::bound)
+        ;
+
+    function("emval_test_get_unbound_field", &emval_test_get_unbound_field);
+
     class_<ValHolder>("ValHolder")
         .smart_ptr<std::shared_ptr<ValHolder>>("std::shared_ptr<ValHolder>")
         .constructor<val>()
@@ -2615,6 +2695,64 @@ EMSCRIPTEN_BINDINGS(val_new_) {
     function("construct_with_ints_and_float", &construct_with_ints_and_float);
 }
 
+class BatchedCounter {
+public:
+    int getValue() const {
+        return value;
+    }
+
+    int value = 0;
+};
+
+void batched_increment(BatchedCounter& counter, int amount) {
+    counter.value += amount;
+}
+
+std::string batched_log;
+
+void batched_append(int i, float f, double d, const std::string& s) {
+    char buf[64];
+    sprintf(buf, "%d %g %g %s;", i, f, d, s.c_str());
+    batched_log += buf;
+}
+
+std::string take_batched_log() {
+    std::string rv = batched_log;
+    batched_log.clear();
+    return rv;
+}
+
+void batched_call_back(int i) {
+    val::global("Module").call<void>("batchedCallback", i);
+}
+
+int generated_zero() {
+    return 0;
+}
+
+int generated_one() {
+    return 1;
+}
+
+EMSCRIPTEN_BINDINGS(generated_names) {
+    // The names are temporaries that are gone before the block ends.
+    std::string prefix = "generated_function_";
+    function((prefix + "zero").c_str(), &generated_zero);
+    function((prefix + "one").c_str(), &generated_one);
+}
+
+EMSCRIPTEN_BINDINGS(batched_functions) {
+    class_<BatchedCounter>("BatchedCounter")
+        .constructor<>()
+        .function("getValue", &BatchedCounter::getValue)
+        ;
+
+    batched_function("batched_increment", &batched_increment);
+    batched_function("batched_append", &batched_append);
+    batched_function("batched_call_back", &batched_call_back);
+    function("take_batched_log", &take_batched_log);
+}
+
 template <typename T>
 class intrusive_ptr {
 public:
@@ -0,0 +1,148 @@
+// Loads file packager output in node, with stand-ins for a local file server and for IndexedDB, so that chunked
+// packages can be tested offline. Each argument is the JS output of a package, they are loaded one after the
+// other into the same IndexedDB, and for each one a line with the downloaded URLs, the preload results, the number
+// of cached chunks, the contents of the files it created and the files whose contents changed on a write to another
+// file is printed as JSON.
+
+var fs = require('fs');
+
+// Serves requests for files under the current directory, and records them.
+var requests = [];
+function XMLHttpRequest() {}
+XMLHttpRequest.prototype = {
+  open: function(method, url) {
+    this.url = url;
+  },
+  send: function() {
+    var xhr = this;
+    requests.push(xhr.url);
+    setTimeout(function() {
+      var data = fs.readFileSync(decodeURIComponent(xhr.url));
+      xhr.response = new Uint8Array(data).buffer;
+      xhr.status = 200;
+      xhr.onprogress({ loaded: data.length, total: data.length });
+      xhr.onload({});
+    }, 0);
+  },
+  overrideMimeType: function() {},
+};
+
+// An in-memory IndexedDB. Requests succeed asynchronously, and a transaction completes once all its requests,
+// including those made from their callbacks, are done.
+var databases = {};
+function clone(value) {
+  return value instanceof ArrayBuffer ? value.slice(0) : JSON.parse(JSON.stringify(value));
+}
+function Transaction(db) {
+  this.db = db;
+  this.pending = 0;
+}
+Transaction.prototype = {
+  request: function(run) {
+    var transaction = this, request = {};
+    transaction.pending++;
+    setTimeout(function() {
+      request.result = run();
+      if (request.onsuccess) request.onsuccess({ target: request });
+      if (--transaction.pending === 0) {
+        setTimeout(function() {
+          if (transaction.pending === 0 && transaction.oncomplete) transaction.oncomplete({});
+        }, 0);
+      }
+    }, 0);
+    return request;
+  },
+  objectStore: function(name) {
+    var transaction = this, store = this.db.stores[name];
+    return {
+      get: function(key) {
+        return transaction.request(function() { return key in store ? clone(store[key]) : undefined; });
+      },
+      put: function(value, key) {
+        return transaction.request(function() { store[key] = clone(value); });
+      },
+      'delete': function(key) {
+        return transaction.request(function() { delete store[key]; });
+      },
+    };
+  },
+};
+var indexedDB = {
+  open: function(name, version) {
+    var request = {};
+    setTimeout(function() {
+      var db = databases[name] || (databases[name] = { version: 0, stores: {} });
+      db.objectStoreNames = { contains: function(store) { return store in db.stores; } };
+      db.createObjectStore = function(store) { db.stores[store] = {}; };
+      db.deleteObjectStore = function(store) { delete db.stores[store]; };
+      db.transaction = function(stores, mode) { return new Transaction(db); };
+      if (db.version < version) {
+        db.version = version;
+        request.onupgradeneeded({ target: { result: db } });
+      }
+      request.onsuccess({ target: { result: db } });
+    }, 0);
+    return request;
+  },
+};
+
+// Like MEMFS, keeps the array it is given for each file and writes to it in place, then returns the files other
+// than the written one whose contents changed.
+function changedByWrite(data, written) {
+  function contents() {
+    var ret = {};
+    for (var name in data) ret[name] = Buffer.from(data[name]).toString('base64');
+    return ret;
+  }
+  var before = contents();
+  data[written][0] ^= 0xff;
+  var after = contents();
+  data[written][0] ^= 0xff;
+  return Object.keys(data).filter(function(name) { return name !== written && after[name] !== before[name]; });
+}
+
+function loadPackage(filename, callback) {
+  var files = {}, data = {};
+  var dependencies = 0;
+  var heap = new Uint8Array(64*1024*1024), heapTop = 8;
+  var Module = {
+    preRun: [],
+    FS_createPath: function() {},
+    FS_createDataFile: function(parent, name, contents, canRead, canWrite, canOwn) {
+      var path = name ? parent.replace(/\/$/, '') + '/' + name : parent;
+      files[path] = Buffer.from(contents).toString('base64');
+      if (canOwn && contents.length) data[path] = contents;
+    },
+    addRunDependency: function() {
+      dependencies++;
+    },
+    removeRunDependency: function() {
+      if (--dependencies === 0) callback(files, data, Module.preloadResults);
+    },
+    getMemory: function(size) {
+      var ret = heapTop;
+      heapTop += size;
+      return ret;
+    },
+    HEAPU8: heap,
+    printErr: console.error,
+  };
+  var window = { indexedDB: indexedDB, location: { pathname: '/index.html' }, encodeURIComponent: encodeURIComponent };
+  var quiet = { log: function() {}, info: function() {}, error: console.error };
+  new Function('Module', 'window', 'XMLHttpRequest', 'console', fs.readFileSync(filename, 'utf8'))(Module, window, XMLHttpRequest, quiet);
+  Module.preRun.forEach(function(func) { func(); });
+}
+
+var packages = process.argv.slice(2);
+(function next() {
+  if (!packages.length) return;
+  requests = [];
+  loadPackage(packages.shift(), function(files, data, preloadResults) {
+    var db = databases['EM_PRELOAD_CACHE'];
+    var cachedChunks = db ? Object.keys(db.stores['CHUNKS']).length : 0;
+    var changed = {};
+    for (var name in data) changed[name] = changedByWrite(data, name);
+    console.log(JSON.stringify({ requests: requests, preloadResults: preloadResults, cachedChunks: cachedChunks, files: files, changed: changed }));
+    next();
+  });
+})();
@@ -2,6 +2,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <emscripten.h>
 
@@ -11,6 +13,40 @@ double before_it_all;
 
 extern "C" {
 
+#if LOAD_MANUALLY
+#define STREAM_FIRST_CHUNK 400
+#define STREAM_CHUNKS 40
+
+int stream_fd;
+int stream_chunk = 0;
+
+// Reads one chunk of file2 per call, returning to the event loop in between like a streaming reader would, so that
+// read-ahead gets to run.
+void stream_step(void *arg) {
+  char buffer[2048];
+  int num = read(stream_fd, buffer, sizeof(buffer));
+  assert(num == sizeof(buffer));
+  for (int i = 0; i < sizeof(buffer); i++) assert(buffer[i] == "0123456789"[(i + 1 + (STREAM_FIRST_CHUNK + stream_chunk) * 2048) % 10]);
+  if (++stream_chunk < STREAM_CHUNKS) {
+    emscripten_async_call(stream_step, 0, 0);
+    return;
+  }
+  close(stream_fd);
+  EM_ASM_({
+    // The first two chunks are decompressed by the reads, and the second one starts the read-ahead. Reads of
+    // read-ahead chunks keep it going, so all the others are decompressed in the background. When that happens in a
+    // worker its timing is not predictable, so this is only checked without one.
+    if (!LZ4.worker) {
+      assert(LZ4.stats.misses == 2, ['seeing', LZ4.stats.misses, 'misses']);
+      assert(LZ4.stats.readAheadHits == $0 - 2, ['seeing', LZ4.stats.readAheadHits, 'read-ahead hits']);
+    }
+  }, STREAM_CHUNKS);
+  printf("streaming test ok\n");
+  int result = 1;
+  REPORT_RESULT();
+}
+#endif
+
 void EMSCRIPTEN_KEEPALIVE finish() {
   // load some file data, SYNCHRONOUSLY :)
   char buffer[100];
@@ -71,8 +107,8 @@ void EMSCRIPTEN_KEEPALIVE finish() {
   EM_ASM({
     assert(!Module['decompressedChunks']);
     Module.compressedData.debug = true;
-    console.log('last cached indexes ' + Module.compressedData.cachedIndexes);
-    assert(Module.compressedData.cachedIndexes.indexOf(0) < 0); // 0 is not cached
+    assert(Module.compressedData.cache.slotOf[0] < 0); // 0 is not cached
+    LZ4.resetStats();
   });
   printf("multiple reads of same byte\n");
   for (int i = 0; i < 100; i++) {
@@ -83,6 +119,7 @@ void EMSCRIPTEN_KEEPALIVE finish() {
   }
   EM_ASM({
     assert(Module['decompressedChunks'] == 1, ['seeing', Module['decompressedChunks'], 'decompressed chunks']);
+    assert(LZ4.stats.misses == 1 && LZ4.stats.hits >= 99, ['seeing', LZ4.stats.hits, LZ4.stats.misses, 'hits and misses']);
   });
   printf("multiple reads of adjoining byte\n");
   for (int i = 0; i < 100; i++) {
@@ -103,6 +140,27 @@ void EMSCRIPTEN_KEEPALIVE finish() {
   }
   EM_ASM({
     assert(Module['decompressedChunks'] == 2, ['seeing', Module['decompressedChunks'], 'decompressed chunks']);
+    assert(LZ4.stats.misses == 2, ['seeing', LZ4.stats.misses, 'misses']);
+  });
+  printf("reads of other chunks do not evict recently used ones\n");
+  for (int i = 0; i < 8; i++) {
+    ret = fseek(f2, i*50*2048, SEEK_SET); // each at the start of a separate chunk
+    assert(ret == 0);
+    num = fread(buffer, 1, 1, f2);
+    assert(num == 1);
+  }
+  ret = fseek(f1, 0, SEEK_SET); assert(ret == 0);
+  num = fread(buffer, 1, 1, f1); assert(num == 1);
+  EM_ASM({
+    assert(Module['decompressedChunks'] == 10, ['seeing', Module['decompressedChunks'], 'decompressed chunks']);
+  });
+  printf("large reads decompress whole chunks directly\n");
+  static char big[10*2048];
+  ret = fseek(f2, 20*2048, SEEK_SET); assert(ret == 0);
+  num = fread(big, 1, sizeof(big), f2); assert(num == sizeof(big));
+  for (int i = 0; i < sizeof(big); i++) assert(big[i] == "0123456789"[(i + 1) % 10]);
+  EM_ASM({
+    assert(LZ4.stats.bulkChunks > 0, 'bulk reads bypass the cache');
   });
   printf("caching test ok\n");
 #endif
@@ -111,6 +169,19 @@ void EMSCRIPTEN_KEEPALIVE finish() {
   fclose(f2);
   fclose(f3);
 
+#if LOAD_MANUALLY
+  printf("sequential reads stay behind the read-ahead\n");
+  stream_fd = open("subdir/file2.txt", O_RDONLY);
+  assert(stream_fd >= 0);
+  off_t pos = lseek(stream_fd, STREAM_FIRST_CHUNK*2048, SEEK_SET);
+  assert(pos == STREAM_FIRST_CHUNK*2048);
+  EM_ASM({
+    LZ4.resetStats();
+  });
+  emscripten_async_call(stream_step, 0, 0);
+  return;
+#endif
+
   // all done
   int result;
 #if LOAD_MANUALLY
@@ -0,0 +1,90 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <emscripten.h>
+
+// Built with a small MEMFS_PAGE_SIZE, so that files are split into many pages.
+
+static unsigned char expected(int i)
+{
+  return (unsigned char)(i * 7 + 3);
+}
+
+int main()
+{
+  int fd = open("/paged", O_CREAT | O_RDWR | O_APPEND, 0666);
+  assert(fd >= 0);
+
+  // Many small appends, which land across page boundaries.
+  unsigned char data[37];
+  int size = 0;
+  for(int i = 0; i < 100; ++i)
+  {
+    for(int j = 0; j < sizeof(data); ++j) data[j] = expected(size + j);
+    assert(write(fd, data, sizeof(data)) == sizeof(data));
+    size += sizeof(data);
+  }
+  close(fd);
+
+  struct stat st;
+  assert(stat("/paged", &st) == 0);
+  assert(st.st_size == size);
+
+  fd = open("/paged", O_RDWR);
+  unsigned char buf[1000];
+  assert(pread(fd, buf, sizeof(buf), 50) == sizeof(buf));
+  for(int i = 0; i < sizeof(buf); ++i) assert(buf[i] == expected(50 + i));
+
+  // Overwrite in the middle, spanning several pages.
+  memset(buf, 0xAB, 200);
+  assert(pwrite(fd, buf, 200, 1000) == 200);
+  assert(pread(fd, buf, 300, 950) == 300);
+  for(int i = 0; i < 300; ++i) assert(buf[i] == ((i >= 50 && i < 250) ? 0xAB : expected(950 + i)));
+
+  // Writing far past the end leaves a hole that reads as zeros.
+  int holeEnd = size + 1000;
+  assert(pwrite(fd, "end", 3, holeEnd) == 3);
+  assert(pread(fd, buf, 1003, size) == 1003);
+  for(int i = 0; i < 1000; ++i) assert(buf[i] == 0);
+  assert(!memcmp(buf + 1000, "end", 3));
+
+  // Shrinking and growing again zero fills the end.
+  assert(ftruncate(fd, 100) == 0);
+  assert(ftruncate(fd, 300) == 0);
+  assert(pread(fd, buf, 300, 0) == 300);
+  for(int i = 0; i < 100; ++i) assert(buf[i] == expected(i));
+  for(int i = 100; i < 300; ++i) assert(buf[i] == 0);
+
+  // Map a range that starts and ends in the middle of pages.
+  unsigned char *mapped = (unsigned char *)mmap(0, 150, PROT_READ, MAP_PRIVATE, fd, 0);
+  assert(mapped != MAP_FAILED);
+  for(int i = 0; i < 100; ++i) assert(mapped[i] == expected(i));
+  munmap(mapped, 150);
+  close(fd);
+
+  // A paged file has no contents array, but is loaded all the same, for example for dlopen().
+  int loaded = EM_ASM_INT_V({
+    var node = FS.lookupPath('/paged').node;
+    return node.pages && !node.contents && FS.forceLoadFile(node);
+  });
+  assert(loaded);
+
+  // The file data can still be gathered in one piece, for example for IndexedDB, and keeps working after that.
+  int length = EM_ASM_INT_V({
+    var node = FS.lookupPath('/paged').node;
+    return MEMFS.getFileDataAsTypedArray(node).length;
+  });
+  assert(length == 300);
+  fd = open("/paged", O_RDWR | O_APPEND);
+  assert(write(fd, "more", 4) == 4);
+  assert(pread(fd, buf, 304, 0) == 304);
+  assert(buf[99] == expected(99) && buf[100] == 0 && !memcmp(buf + 300, "more", 4));
+  close(fd);
+
+  puts("success");
+  return 0;
+}
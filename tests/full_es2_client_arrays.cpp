@@ -0,0 +1,121 @@
+#include "SDL/SDL_opengl.h"
+#include "SDL/SDL.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <emscripten.h>
+
+// Draws a client side vertex array in several pieces, modifying it in between, which exercises the reuse of
+// uploaded vertex data across draw calls under FULL_ES2.
+
+struct Vertex
+{
+    GLfloat pos[2];
+    GLubyte color[4];
+};
+
+#define NUM_STRIPS 4
+
+Vertex vertices[NUM_STRIPS*6];
+
+void SetStrip(int strip, GLubyte r, GLubyte g, GLubyte b)
+{
+    const float y0 = -1.f + strip * 2.f / NUM_STRIPS, y1 = y0 + 2.f / NUM_STRIPS;
+    const float corners[6][2] = { { -1, y0 }, { 1, y0 }, { -1, y1 }, { -1, y1 }, { 1, y0 }, { 1, y1 } };
+    for(int i = 0; i < 6; ++i)
+    {
+        Vertex &v = vertices[strip*6 + i];
+        v.pos[0] = corners[i][0];
+        v.pos[1] = corners[i][1];
+        v.color[0] = r;
+        v.color[1] = g;
+        v.color[2] = b;
+        v.color[3] = 255;
+    }
+}
+
+void CheckStrip(int strip, GLubyte r, GLubyte g, GLubyte b)
+{
+    unsigned char pixel[4];
+    glReadPixels(320, (480 / NUM_STRIPS) * strip + 480 / NUM_STRIPS / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    printf("strip %d: %d,%d,%d,%d\n", strip, pixel[0], pixel[1], pixel[2], pixel[3]);
+    assert(pixel[0] == r);
+    assert(pixel[1] == g);
+    assert(pixel[2] == b);
+}
+
+int main(int argc, char *argv[])
+{
+    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+    {
+        printf("Unable to initialize SDL: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Surface *screen = SDL_SetVideoMode(640, 480, 16, SDL_OPENGL);
+    assert(screen);
+
+    const char *vsCode = "#version 100\n"
+        "attribute vec4 pos; attribute vec4 color; varying vec4 vColor;\n"
+        "void main() { gl_Position = pos; vColor = color; }";
+    const char *psCode = "#version 100\n"
+        "precision lowp float; varying vec4 vColor;\n"
+        "void main() { gl_FragColor = vColor; }";
+
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vs, 1, &vsCode, NULL);
+    glCompileShader(vs);
+    GLuint ps = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(ps, 1, &psCode, NULL);
+    glCompileShader(ps);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, ps);
+    glBindAttribLocation(program, 0, "pos");
+    glBindAttribLocation(program, 1, "color");
+    glLinkProgram(program);
+    glUseProgram(program);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), vertices[0].pos);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), vertices[0].color);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    for(int i = 0; i < NUM_STRIPS; ++i)
+        SetStrip(i, 255, 0, 0);
+
+    // Each draw reads the vertices of the previous one and a few more.
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glDrawArrays(GL_TRIANGLES, 6, 6);
+    // The vertices of strip 2 change before it is drawn, and those of strip 0 after it was drawn.
+    SetStrip(2, 0, 255, 0);
+    SetStrip(0, 0, 0, 255);
+    glDrawArrays(GL_TRIANGLES, 12, 6);
+    glDrawArrays(GL_TRIANGLES, 18, 6);
+    // Draw the whole array again, with the same data as the previous draw call.
+    SetStrip(0, 255, 0, 0);
+    glDrawArrays(GL_TRIANGLES, 0, NUM_STRIPS*6);
+
+    CheckStrip(0, 255, 0, 0);
+    CheckStrip(1, 255, 0, 0);
+    CheckStrip(2, 0, 255, 0);
+    CheckStrip(3, 255, 0, 0);
+
+    // A draw call that reads less than before.
+    SetStrip(1, 0, 0, 255);
+    glDrawArrays(GL_TRIANGLES, 6, 6);
+    CheckStrip(1, 0, 0, 255);
+
+    assert(glGetError() == GL_NO_ERROR);
+
+#ifdef REPORT_RESULT
+    int result = 1;
+    REPORT_RESULT();
+#endif
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <emscripten.h>
+#include <emscripten/html5.h>
+#include <emscripten/gl_profile.h>
+#include <GLES2/gl2.h>
+
+#define MAX_ENTRIES 64
+
+static emscripten_gl_profile_entry entries[MAX_ENTRIES];
+
+static const emscripten_gl_profile_entry *find(int n, const char *name)
+{
+  for(int i = 0; i < n; ++i)
+    if (!strcmp(entries[i].name, name)) return &entries[i];
+  return 0;
+}
+
+static void check_histogram(const emscripten_gl_profile_entry *e)
+{
+  uint32_t sum = 0;
+  for(int i = 0; i < EMSCRIPTEN_GL_PROFILE_HISTOGRAM_BUCKETS; ++i)
+    sum += e->histogram[i];
+  assert(sum == e->calls);
+}
+
+int main()
+{
+  EmscriptenWebGLContextAttributes attrs;
+  emscripten_webgl_init_context_attributes(&attrs);
+  attrs.enableExtensionsByDefault = 0;
+  EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context = emscripten_webgl_create_context(0, &attrs);
+  assert(context > 0);
+  emscripten_webgl_make_context_current(context);
+
+  // Nothing has been recorded before the first frame ends.
+  assert(emscripten_gl_profile_get_frame(entries, MAX_ENTRIES) == 0);
+
+  static char data[1000];
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(data), data, GL_STATIC_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 100, 200, data);
+  glBufferSubData(GL_ARRAY_BUFFER, 300, 50, data);
+  for(int i = 0; i < 10; ++i)
+    glClear(GL_COLOR_BUFFER_BIT);
+  emscripten_gl_profile_end_frame();
+
+  int n = emscripten_gl_profile_get_frame(entries, MAX_ENTRIES);
+  assert(n > 0);
+  for(int i = 0; i < n; ++i)
+  {
+    printf("%s: %u calls, %f msecs, %f bytes\n", entries[i].name, entries[i].calls, entries[i].msecs, entries[i].bytesUploaded);
+    check_histogram(&entries[i]);
+    if (i > 0) assert(entries[i-1].msecs >= entries[i].msecs);
+  }
+
+  const emscripten_gl_profile_entry *e = find(n, "glClear");
+  assert(e && e->calls == 10 && e->bytesUploaded == 0);
+  e = find(n, "glBufferData");
+  assert(e && e->calls == 1 && e->bytesUploaded == sizeof(data));
+  e = find(n, "glBufferSubData");
+  assert(e && e->calls == 2 && e->bytesUploaded == 250);
+  assert(find(n, "glDrawArrays") == 0);
+
+  // Only the entries with the most time are returned when there is no room for all of them.
+  assert(emscripten_gl_profile_get_frame(entries, 1) == 1);
+
+  // The next frame starts from zero.
+  glClear(GL_COLOR_BUFFER_BIT);
+  emscripten_gl_profile_end_frame();
+  n = emscripten_gl_profile_get_frame(entries, MAX_ENTRIES);
+  assert(n == 1);
+  assert(!strcmp(entries[0].name, "glClear") && entries[0].calls == 1);
+
+  emscripten_gl_profile_reset();
+  assert(emscripten_gl_profile_get_frame(entries, MAX_ENTRIES) == 0);
+
+  printf("success\n");
+  return 0;
+}
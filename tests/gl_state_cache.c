@@ -0,0 +1,99 @@
+#include <assert.h>
+#include <stdio.h>
+#include <emscripten.h>
+#include <emscripten/html5.h>
+#include <GLES2/gl2.h>
+
+static void expect_stats(EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context, int issued, int filtered)
+{
+  EmscriptenWebGLStateCacheStats stats;
+  EMSCRIPTEN_RESULT res = emscripten_webgl_get_state_cache_stats(context, &stats);
+  assert(res == EMSCRIPTEN_RESULT_SUCCESS);
+  printf("issued: %d, filtered: %d\n", stats.issuedThisFrame, stats.filteredThisFrame);
+  assert(stats.issuedThisFrame == issued);
+  assert(stats.filteredThisFrame == filtered);
+  assert(stats.totalIssued == issued);
+  assert(stats.totalFiltered == filtered);
+}
+
+// The headless canvas counts the calls that reach the WebGL context.
+static int context_calls(const char *name)
+{
+  return EM_ASM_INT({
+    return Module.ctx.calls[Pointer_stringify($0)] | 0;
+  }, name);
+}
+
+int main()
+{
+  EmscriptenWebGLContextAttributes attrs;
+  emscripten_webgl_init_context_attributes(&attrs);
+  attrs.enableExtensionsByDefault = 0;
+  EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context = emscripten_webgl_create_context(0, &attrs);
+  assert(context > 0);
+  emscripten_webgl_make_context_current(context);
+
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_DEPTH_TEST);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_DEPTH_TEST);
+  expect_stats(context, 3, 3);
+  assert(context_calls("enable") + context_calls("disable") == 3);
+
+  GLuint buffers[2];
+  glGenBuffers(2, buffers);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+  glDeleteBuffers(1, &buffers[1]);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // The deletion already unbound it.
+  expect_stats(context, 5, 5);
+  assert(context_calls("bindBuffer") == 2);
+
+  GLuint program = glCreateProgram();
+  glLinkProgram(program);
+  glUseProgram(program);
+  glUseProgram(program);
+  glUseProgram(program);
+  expect_stats(context, 6, 7);
+  assert(context_calls("useProgram") == 1);
+
+  GLint ivec3 = glGetUniformLocation(program, "activeUniform0");
+  GLint mat4 = glGetUniformLocation(program, "activeUniform1");
+  GLint scalar = glGetUniformLocation(program, "activeUniform2");
+  glUniform3i(ivec3, 1, 2, 3);
+  glUniform3i(ivec3, 1, 2, 3);
+  glUniform3i(ivec3, 1, 2, 4);
+  float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+  glUniformMatrix4fv(mat4, 1, GL_FALSE, identity);
+  glUniformMatrix4fv(mat4, 1, GL_FALSE, identity);
+  identity[15] = 2;
+  glUniformMatrix4fv(mat4, 1, GL_FALSE, identity);
+  glUniform1f(scalar, 0.5f);
+  glUniform1f(scalar, 0.5f);
+  expect_stats(context, 11, 10);
+  assert(context_calls("uniform") == 5);
+
+  // The same values transposed, or set through a function of another type, are different state.
+  glUniformMatrix4fv(mat4, 1, GL_TRUE, identity);
+  glUniformMatrix4fv(mat4, 1, GL_TRUE, identity);
+  glUniform1f(scalar, 1.0f);
+  glUniform1i(scalar, 1);
+  glUniform1i(scalar, 1);
+  expect_stats(context, 14, 12);
+  assert(context_calls("uniform") == 8);
+
+  // After invalidation, every kind of state change is forwarded once more.
+  emscripten_webgl_invalidate_state_cache(context);
+  glEnable(GL_DEPTH_TEST);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glUseProgram(program);
+  glUniform1f(scalar, 0.5f);
+  expect_stats(context, 18, 12);
+  assert(context_calls("enable") + context_calls("disable") == 4);
+
+  printf("success\n");
+  return 0;
+}
@@ -0,0 +1,56 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define SIZE 9000
+
+int main() {
+  char expected[SIZE];
+  int fd = open("data.dat", O_RDONLY);
+  assert(fd >= 0);
+  assert(read(fd, expected, SIZE) == SIZE);
+
+  // Read only private mappings of a file in the heap point directly at its data.
+  char *a = (char*)mmap(NULL, SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+  char *b = (char*)mmap(NULL, SIZE - 4096, PROT_READ, MAP_PRIVATE, fd, 4096);
+  assert(a != MAP_FAILED && b != MAP_FAILED);
+  assert(!memcmp(a, expected, SIZE));
+  assert(!memcmp(b, expected + 4096, SIZE - 4096));
+  assert((long)a % 8 == 0);
+#ifdef HEAP_COPY
+  assert(b == a + 4096);
+#endif
+  munmap(a, SIZE);
+  munmap(b, SIZE - 4096);
+  close(fd);
+
+  // Writable private mappings get their own copy, so the file does not change.
+  fd = open("data.dat", O_RDWR);
+  char *c = (char*)mmap(NULL, SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  assert(c != MAP_FAILED);
+  c[0] = '!';
+  munmap(c, SIZE);
+  char first;
+  assert(pread(fd, &first, 1, 0) == 1 && first == expected[0]);
+
+  // Shared mappings write through to the file, also at an offset.
+  char *d = (char*)mmap(NULL, SIZE - 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 4096);
+  assert(d != MAP_FAILED);
+  assert(!memcmp(d, expected + 4096, SIZE - 4096));
+  d[0] = '!';
+  msync(d, SIZE - 4096, MS_SYNC);
+  munmap(d, SIZE - 4096);
+  assert(pread(fd, &first, 1, 4096) == 1 && first == '!');
+  assert(pread(fd, &first, 1, 0) == 1 && first == expected[0]);
+  close(fd);
+
+  printf("success\n");
+#ifdef REPORT_RESULT
+  int result = 1;
+  REPORT_RESULT();
+#endif
+  return 0;
+}
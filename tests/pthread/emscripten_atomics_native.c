@@ -0,0 +1,34 @@
+// The parts of the Emscripten runtime that system/lib/pthread/atomic_u64.c and the 64-bit atomics tests use, for
+// building them as native executables. The 32-bit atomics map directly to the compiler builtins.
+
+#include <time.h>
+#include <emscripten/threading.h>
+
+int emscripten_has_threading_support()
+{
+	return 1;
+}
+
+double emscripten_get_now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+uint32_t emscripten_atomic_load_u32(const void *addr)
+{
+	return __atomic_load_n((uint32_t*)addr, __ATOMIC_SEQ_CST);
+}
+
+uint32_t emscripten_atomic_store_u32(void *addr, uint32_t val)
+{
+	__atomic_store_n((uint32_t*)addr, val, __ATOMIC_SEQ_CST);
+	return val;
+}
+
+uint32_t emscripten_atomic_cas_u32(void *addr, uint32_t oldVal, uint32_t newVal)
+{
+	__atomic_compare_exchange_n((uint32_t*)addr, &oldVal, newVal, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return oldVal;
+}
@@ -0,0 +1,135 @@
+// Measures the throughput of the 64-bit atomics under contention, compared to the previous emulation that guarded
+// every operation, loads included, with one of 256 hashed spinlocks. Prints one line per benchmark:
+//
+//   MICROBENCHMARK {"name": ..., "callsPerSecond": ...}
+//
+// test_benchmark.test_pthread_64bit_atomics_microbenchmarks also builds it natively together with
+// system/lib/pthread/atomic_u64.c and emscripten_atomics_native.c, with and without EMSCRIPTEN_NATIVE_64BIT_ATOMICS.
+
+#include <stdio.h>
+#include <pthread.h>
+#include <emscripten/threading.h>
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+extern "C" double emscripten_get_now();
+#endif
+#include <assert.h>
+
+#define NUM_THREADS 4
+#define OPS_PER_THREAD 200000
+
+// The previous emulation, for reference.
+#define NUM_SPINLOCKS 256
+static uint32_t spinlocks[NUM_SPINLOCKS] = {};
+
+static uint32_t *spinlock_acquire(void *addr)
+{
+	uint32_t *lock = &spinlocks[((uintptr_t)addr >> 3) & (NUM_SPINLOCKS-1)];
+	while(emscripten_atomic_cas_u32(lock, 0, 1) != 0)
+		/*nop*/;
+	return lock;
+}
+
+static uint64_t spinlock_load_u64(void *addr)
+{
+	uint32_t *lock = spinlock_acquire(addr);
+	uint64_t val = *(volatile uint64_t*)addr;
+	emscripten_atomic_store_u32(lock, 0);
+	return val;
+}
+
+static uint64_t spinlock_add_u64(void *addr, uint64_t val)
+{
+	uint32_t *lock = spinlock_acquire(addr);
+	uint64_t newVal = *(volatile uint64_t*)addr + val;
+	*(volatile uint64_t*)addr = newVal;
+	emscripten_atomic_store_u32(lock, 0);
+	return newVal;
+}
+
+struct Benchmark
+{
+	const char *name;
+	uint64_t (*load)(void *addr);
+	uint64_t (*add)(void *addr, uint64_t val);
+	int writeEvery; // Every writeEvery'th operation is an add, the rest are loads.
+	int sharedCounter; // All threads hit the same counter instead of one counter each.
+};
+
+static uint64_t atomic_load_u64(void *addr) { return emscripten_atomic_load_u64(addr); }
+static uint64_t atomic_add_u64(void *addr, uint64_t val) { return emscripten_atomic_add_u64(addr, val); }
+
+#ifdef EMSCRIPTEN_NATIVE_64BIT_ATOMICS
+#define ATOMICS_NAME "native"
+#else
+#define ATOMICS_NAME "seqlock"
+#endif
+
+static Benchmark benchmarks[] = {
+	{ "spinlock u64 load-mostly shared", spinlock_load_u64, spinlock_add_u64, 16, 1 },
+	{ ATOMICS_NAME " u64 load-mostly shared", atomic_load_u64, atomic_add_u64, 16, 1 },
+	{ "spinlock u64 add shared", spinlock_load_u64, spinlock_add_u64, 1, 1 },
+	{ ATOMICS_NAME " u64 add shared", atomic_load_u64, atomic_add_u64, 1, 1 },
+	{ "spinlock u64 add private", spinlock_load_u64, spinlock_add_u64, 1, 0 },
+	{ ATOMICS_NAME " u64 add private", atomic_load_u64, atomic_add_u64, 1, 0 },
+};
+
+static Benchmark *currentBenchmark;
+static uint64_t counters[NUM_THREADS] = {};
+
+static void *ThreadMain(void *arg)
+{
+	int id = (int)(long)arg;
+	Benchmark *b = currentBenchmark;
+	uint64_t *counter = b->sharedCounter ? &counters[0] : &counters[id];
+	uint64_t sum = 0;
+	for(int i = 0; i < OPS_PER_THREAD; ++i)
+	{
+		if (i % b->writeEvery == 0) b->add(counter, 1);
+		else sum += b->load(counter);
+	}
+	pthread_exit((void*)(long)(sum & 1));
+}
+
+int main()
+{
+	int result = 0;
+	if (!emscripten_has_threading_support())
+	{
+#ifdef REPORT_RESULT
+		REPORT_RESULT();
+#endif
+		printf("Skipped: Threading is not supported.\n");
+		return 0;
+	}
+
+	for(int i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i)
+	{
+		currentBenchmark = &benchmarks[i];
+		for(int j = 0; j < NUM_THREADS; ++j)
+			counters[j] = 0;
+
+		pthread_t threads[NUM_THREADS];
+		double t0 = emscripten_get_now();
+		for(int j = 0; j < NUM_THREADS; ++j)
+			pthread_create(&threads[j], NULL, ThreadMain, (void*)(long)j);
+		for(int j = 0; j < NUM_THREADS; ++j)
+			pthread_join(threads[j], NULL);
+		double msecs = emscripten_get_now() - t0;
+
+		// Check that no adds were lost.
+		uint64_t adds = 0;
+		for(int j = 0; j < NUM_THREADS; ++j)
+			adds += counters[j];
+		uint64_t expectedAdds = (uint64_t)NUM_THREADS * ((OPS_PER_THREAD + benchmarks[i].writeEvery - 1) / benchmarks[i].writeEvery);
+		if (adds != expectedAdds) ++result;
+
+		printf("MICROBENCHMARK {\"name\": \"%s\", \"callsPerSecond\": %d}\n", benchmarks[i].name, (int)(NUM_THREADS * OPS_PER_THREAD / (msecs / 1000.0)));
+	}
+
+#ifdef REPORT_RESULT
+	REPORT_RESULT();
+#endif
+	return result;
+}
@@ -0,0 +1,92 @@
+// Runs the 64-bit atomics from system/lib/pthread/atomic_u64.c on native threads, built together with
+// emscripten_atomics_native.c. Build with -DEMSCRIPTEN_NATIVE_64BIT_ATOMICS to test the native path, which the asm.js
+// backend cannot use, or without it to test the seqlock emulation on real hardware threads.
+
+#include <stdio.h>
+#include <pthread.h>
+#include <emscripten/threading.h>
+
+#define NUM_THREADS 8
+#define ITERATIONS 100000
+#define N 4
+
+// Implements GCC's 64-bit __sync_fetch_and_sub; not declared in <emscripten/threading.h>.
+uint64_t _emscripten_atomic_fetch_and_sub_u64(void *addr, uint64_t val);
+
+static uint64_t counters[N];
+static uint64_t bits[N]; // Each thread owns bit 32 + its id, and toggles it an even number of times.
+static uint64_t pattern; // Only ever holds values whose two 32-bit halves are equal.
+static uint64_t casTotal;
+static volatile int tornReads;
+
+static void *ThreadMain(void *arg)
+{
+	uint64_t id = (uint64_t)(long)arg;
+	for(int i = 0; i < ITERATIONS; ++i)
+	{
+		emscripten_atomic_add_u64(&counters[i % N], 0x100000001ull);
+		_emscripten_atomic_fetch_and_sub_u64(&counters[(i + 1) % N], 1);
+		emscripten_atomic_xor_u64(&bits[i % N], 1ull << (32 + id));
+		emscripten_atomic_or_u64(&bits[(i + 1) % N], 1);
+		emscripten_atomic_and_u64(&bits[(i + 2) % N], ~1ull);
+
+		uint64_t half = id * ITERATIONS + i;
+		emscripten_atomic_store_u64(&pattern, (half << 32) | half);
+		uint64_t seen = emscripten_atomic_load_u64(&pattern);
+		if ((uint32_t)seen != (uint32_t)(seen >> 32)) tornReads = 1;
+		seen = emscripten_atomic_exchange_u64(&pattern, (half << 32) | half);
+		if ((uint32_t)seen != (uint32_t)(seen >> 32)) tornReads = 1;
+
+		uint64_t old;
+		do {
+			old = emscripten_atomic_load_u64(&casTotal);
+		} while(emscripten_atomic_cas_u64(&casTotal, old, old + 0x100000000ull + 1) != old);
+	}
+	return 0;
+}
+
+int main()
+{
+	pthread_t threads[NUM_THREADS];
+	for(int i = 0; i < NUM_THREADS; ++i)
+		pthread_create(&threads[i], NULL, ThreadMain, (void*)(long)i);
+	for(int i = 0; i < NUM_THREADS; ++i)
+		pthread_join(threads[i], NULL);
+
+	int failed = tornReads;
+	if (tornReads) printf("torn 64-bit read\n");
+
+	// Each thread adds 0x100000001 and subtracts 1 ITERATIONS / N times on every counter, and toggles its bit in each
+	// of bits[] an even number of times.
+	uint64_t expected = (uint64_t)NUM_THREADS * (ITERATIONS / N) * 0x100000000ull;
+	for(int i = 0; i < N; ++i)
+	{
+		if (counters[i] != expected)
+		{
+			printf("counter %d: %llx != %llx\n", i, (unsigned long long)counters[i], (unsigned long long)expected);
+			failed = 1;
+		}
+		if ((bits[i] >> 32) != 0)
+		{
+			printf("bits %d: %llx\n", i, (unsigned long long)bits[i]);
+			failed = 1;
+		}
+	}
+
+	uint64_t expectedCas = (uint64_t)NUM_THREADS * ITERATIONS * (0x100000000ull + 1);
+	if (casTotal != expectedCas)
+	{
+		printf("cas total: %llx != %llx\n", (unsigned long long)casTotal, (unsigned long long)expectedCas);
+		failed = 1;
+	}
+
+	emscripten_atomic_store_f64(&pattern, 0.5);
+	if (emscripten_atomic_load_f64(&pattern) != 0.5)
+	{
+		printf("f64 load/store failed\n");
+		failed = 1;
+	}
+
+	printf(failed ? "failed\n" : "ok\n");
+	return failed;
+}
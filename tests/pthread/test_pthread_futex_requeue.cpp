@@ -0,0 +1,111 @@
+#include <pthread.h>
+#include <emscripten.h>
+#include <emscripten/threading.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define NUM_THREADS 6
+#define NUM_ROUNDS 20
+
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+int currentRound = 0; // Protected by mutex.
+int numWaiting = 0; // Protected by mutex.
+int numWoken = 0; // Protected by mutex.
+
+static void *waiter(void *arg)
+{
+  pthread_mutex_lock(&mutex);
+  for(int r = 1; r <= NUM_ROUNDS; ++r)
+  {
+    ++numWaiting;
+    while(currentRound < r)
+      pthread_cond_wait(&cond, &mutex);
+    ++numWoken;
+  }
+  pthread_mutex_unlock(&mutex);
+  pthread_exit(0);
+}
+
+static int mainThreadCallsRun = 0;
+
+static int main_thread_call(int x)
+{
+  assert(emscripten_is_main_runtime_thread());
+  ++mainThreadCallsRun;
+  return x + 1;
+}
+
+static uint32_t holderHasLock = 0;
+
+static void *holder(void *arg)
+{
+  pthread_mutex_lock(&mutex);
+  emscripten_atomic_store_u32(&holderHasLock, 1);
+  // The main thread is now blocked on the mutex, and must keep running proxied calls for this thread to release it.
+  for(int i = 0; i < 10; ++i)
+    assert(emscripten_sync_run_in_main_runtime_thread(EM_FUNC_SIG_II, main_thread_call, i).i == i + 1);
+  pthread_mutex_unlock(&mutex);
+  pthread_exit(0);
+}
+
+int main()
+{
+  if (!emscripten_has_threading_support())
+  {
+#ifdef REPORT_RESULT
+    int result = 0;
+    REPORT_RESULT();
+#endif
+    printf("Skipped: Threading is not supported.\n");
+    return 0;
+  }
+
+  emscripten_futex_reset_stats();
+
+  // Broadcasts wake all waiters of each round, which then reacquire the mutex one at a time.
+  pthread_t threads[NUM_THREADS];
+  for(int i = 0; i < NUM_THREADS; ++i)
+    pthread_create(&threads[i], 0, waiter, 0);
+  for(int r = 1; r <= NUM_ROUNDS; ++r)
+  {
+    for(;;)
+    {
+      pthread_mutex_lock(&mutex);
+      if (numWaiting == NUM_THREADS * r) break;
+      pthread_mutex_unlock(&mutex);
+    }
+    currentRound = r;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+  }
+  for(int i = 0; i < NUM_THREADS; ++i)
+    pthread_join(threads[i], 0);
+  assert(numWoken == NUM_THREADS * NUM_ROUNDS);
+
+  emscripten_futex_stats stats;
+  emscripten_futex_get_stats(&stats);
+  printf("waits: %u, timeouts: %u, wakes: %u, threads woken: %u, requeues: %u, main thread wait: %f msecs\n",
+    stats.waits, stats.timeouts, stats.wakes, stats.threadsWoken, stats.requeues, stats.mainThreadWaitMsecs);
+  // Each broadcast wakes at most one waiter and requeues the rest onto the mutex, whose unlocks wake them one by one.
+  assert(stats.requeues == NUM_ROUNDS);
+  assert(stats.threadsWoken <= stats.waits);
+
+  // The main thread waits for a mutex held by a thread that is waiting for the main thread in turn.
+  pthread_t thread;
+  pthread_create(&thread, 0, holder, 0);
+  while(!emscripten_atomic_load_u32(&holderHasLock))
+    emscripten_main_thread_process_queued_calls();
+  pthread_mutex_lock(&mutex);
+  assert(mainThreadCallsRun == 10);
+  pthread_mutex_unlock(&mutex);
+  pthread_join(thread, 0);
+
+  emscripten_futex_get_stats(&stats);
+  assert(stats.waits > 0);
+
+#ifdef REPORT_RESULT
+  int result = 0;
+  REPORT_RESULT();
+#endif
+}
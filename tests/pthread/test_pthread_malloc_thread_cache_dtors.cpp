@@ -0,0 +1,60 @@
+#include <pthread.h>
+#include <emscripten.h>
+#include <emscripten/threading.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Destructors of thread-specific data that run after the one of the malloc thread cache must not bring the cache
+// back, which would leak it, or destroy it twice.
+
+#define NUM_THREADS 32
+
+static pthread_key_t key;
+
+static void allocating_destructor(void *arg)
+{
+  for(int i = 0; i < 100; ++i)
+    free(malloc(i));
+  free(arg);
+}
+
+static void *thread_start(void *arg)
+{
+  for(int i = 0; i < 100; ++i)
+    free(malloc(i));
+  pthread_setspecific(key, malloc(16));
+  pthread_exit(0);
+}
+
+int main()
+{
+  int result = 0;
+  if (!emscripten_has_threading_support()) {
+#ifdef REPORT_RESULT
+    REPORT_RESULT();
+#endif
+    printf("Skipped: threading support is not available!\n");
+    return 0;
+  }
+
+  // The first malloc creates the key of the thread cache, so that its destructor runs before allocating_destructor.
+  free(malloc(1));
+  pthread_key_create(&key, allocating_destructor);
+
+  int inUse = mallinfo().uordblks;
+  for(int i = 0; i < NUM_THREADS; ++i) {
+    pthread_t thr;
+    pthread_create(&thr, NULL, thread_start, 0);
+    pthread_join(thr, 0);
+  }
+  // Chunks the main thread frees for the runtime stay in its cache, and count as in use. A leaked cache holds a batch
+  // of chunks for each of the sizes the destructor allocates, over 20 kB per thread.
+  int leaked = mallinfo().uordblks - inUse;
+  printf("Bytes still in use after the threads exited: %d\n", leaked);
+  if (leaked > 64*1024) result = 1;
+
+#ifdef REPORT_RESULT
+  REPORT_RESULT();
+#endif
+}
@@ -0,0 +1,86 @@
+#include <pthread.h>
+#include <emscripten.h>
+#include <emscripten/threading.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define NUM_THREADS 4
+
+static void *thread_main(void *arg)
+{
+  return (void*)((long)arg * 2);
+}
+
+static void report(int result)
+{
+#ifdef REPORT_RESULT
+  REPORT_RESULT();
+#endif
+}
+
+static void check_finished(void *arg)
+{
+  emscripten_pthread_pool_stats stats;
+  emscripten_pthread_pool_get_stats(&stats);
+  if (stats.threadsStarted < NUM_THREADS || stats.numRunningWorkers > 0)
+  {
+    // The workers report back asynchronously, when this thread is not busy.
+    emscripten_async_call(check_finished, 0, 10);
+    return;
+  }
+  printf("hits: %u, misses: %u, workers created: %u, average start latency: %f msecs, max: %f msecs\n",
+    stats.hits, stats.misses, stats.workersCreated, stats.averageStartLatencyMsecs, stats.maxStartLatencyMsecs);
+  assert(stats.threadsStarted == NUM_THREADS);
+  assert(stats.averageStartLatencyMsecs <= stats.maxStartLatencyMsecs);
+
+  // All threads have finished, and their workers are back in the pool.
+  assert(stats.numUnusedWorkers == NUM_THREADS);
+  assert(emscripten_pthread_pool_shrink(1) == NUM_THREADS - 1);
+  emscripten_pthread_pool_get_stats(&stats);
+  assert(stats.numUnusedWorkers == 1);
+  report(0);
+}
+
+static void pool_ready(void *userData)
+{
+  assert((long)userData == 42);
+  emscripten_pthread_pool_stats stats;
+  emscripten_pthread_pool_get_stats(&stats);
+  assert(stats.numLoadingWorkers == 0);
+  assert(stats.numUnusedWorkers == NUM_THREADS);
+
+  pthread_t threads[NUM_THREADS];
+  for(long i = 0; i < NUM_THREADS; ++i)
+  {
+    int rc = pthread_create(&threads[i], 0, thread_main, (void*)i);
+    assert(rc == 0);
+  }
+  for(long i = 0; i < NUM_THREADS; ++i)
+  {
+    void *result;
+    pthread_join(threads[i], &result);
+    assert((long)result == i * 2);
+  }
+
+  // Every thread started on a worker that had already loaded.
+  emscripten_pthread_pool_get_stats(&stats);
+  assert(stats.hits == NUM_THREADS);
+  assert(stats.misses == 0);
+  assert(stats.workersCreated == NUM_THREADS);
+  check_finished(0);
+}
+
+int main()
+{
+  if (!emscripten_has_threading_support())
+  {
+    assert(emscripten_pthread_pool_prewarm(NUM_THREADS) == 0);
+    report(0);
+    printf("Skipped: Threading is not supported.\n");
+    return 0;
+  }
+
+  assert(emscripten_pthread_pool_prewarm(NUM_THREADS) == NUM_THREADS);
+  emscripten_pthread_pool_when_ready(pool_ready, (void*)42);
+  return 0;
+}
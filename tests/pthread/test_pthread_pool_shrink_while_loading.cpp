@@ -0,0 +1,37 @@
+#include <pthread.h>
+#include <emscripten.h>
+#include <emscripten/threading.h>
+#include <assert.h>
+#include <stdio.h>
+
+// Built with -s PTHREAD_POOL_SIZE=4 and a pre-js that shrinks the pool to 2 workers while they are still loading.
+// The startup batch must still finish, or main() would never run.
+
+static void *thread_main(void *arg)
+{
+  return (void*)((long)arg + 1);
+}
+
+int main()
+{
+  int result = 0;
+  if (emscripten_has_threading_support())
+  {
+    emscripten_pthread_pool_stats stats;
+    emscripten_pthread_pool_get_stats(&stats);
+    assert(stats.numLoadingWorkers == 0);
+    assert(stats.numUnusedWorkers == 2);
+
+    pthread_t thread;
+    int rc = pthread_create(&thread, 0, thread_main, (void*)41);
+    assert(rc == 0);
+    void *ret;
+    pthread_join(thread, &ret);
+    assert((long)ret == 42);
+  }
+  else printf("Skipped: Threading is not supported.\n");
+#ifdef REPORT_RESULT
+  REPORT_RESULT();
+#endif
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include <pthread.h>
+#include <emscripten.h>
+#include <emscripten/threading.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_THREADS 8
+#define NUM_CALLS 1000 // More than fit in the main thread call queue at once.
+
+static const char *names[NUM_THREADS] = { "T0", "T1", "T2", "T3", "T4", "T5", "T6", "T7" };
+static const char *values[] = { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+
+static void *thread_start(void *arg)
+{
+  int id = (int)(long)arg;
+  // Fire-and-forget calls from one thread must run in order, so the last value set wins.
+  for(int i = 0; i < NUM_CALLS; ++i)
+    emscripten_async_run_in_main_thread_3(EM_PROXIED_SETENV, (void*)names[id], (void*)values[i % 10], (void*)1);
+  // A synchronous call queued after them observes their effects.
+  char *value = (char*)emscripten_sync_run_in_main_thread_1(EM_PROXIED_GETENV, (void*)names[id]);
+  assert(value);
+  assert(!strcmp(value, values[(NUM_CALLS-1) % 10]));
+  pthread_exit(0);
+}
+
+int main()
+{
+  int result = 0;
+  if (!emscripten_has_threading_support())
+  {
+#ifdef REPORT_RESULT
+    REPORT_RESULT();
+#endif
+    printf("Skipped: Threading is not supported.\n");
+    return 0;
+  }
+
+  pthread_t threads[NUM_THREADS];
+  for(int i = 0; i < NUM_THREADS; ++i)
+    pthread_create(&threads[i], NULL, thread_start, (void*)(long)i);
+  for(int i = 0; i < NUM_THREADS; ++i)
+    pthread_join(threads[i], 0);
+
+  for(int i = 0; i < NUM_THREADS; ++i)
+  {
+    const char *value = getenv(names[i]);
+    if (!value || strcmp(value, values[(NUM_CALLS-1) % 10])) ++result;
+  }
+
+#ifdef REPORT_RESULT
+  REPORT_RESULT();
+#endif
+}
@@ -0,0 +1,91 @@
+#include <pthread.h>
+#include <emscripten.h>
+#include <emscripten/threading.h>
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+static int sum = 0; // Only accessed on the main thread.
+static float lastColor[4];
+
+static int add(int a, int b)
+{
+  assert(emscripten_is_main_runtime_thread());
+  return a + b;
+}
+
+static void accumulate(int x)
+{
+  assert(emscripten_is_main_runtime_thread());
+  sum += x;
+}
+
+static void set_color(float r, float g, float b, float a)
+{
+  assert(emscripten_is_main_runtime_thread());
+  lastColor[0] = r; lastColor[1] = g; lastColor[2] = b; lastColor[3] = a;
+}
+
+static double scale(int x)
+{
+  assert(emscripten_is_main_runtime_thread());
+  return x * 0.5;
+}
+
+static int get_sum()
+{
+  assert(emscripten_is_main_runtime_thread());
+  return sum;
+}
+
+static void *thread_start(void *arg)
+{
+  assert(emscripten_sync_run_in_main_runtime_thread(EM_FUNC_SIG_III, add, 40, 2).i == 42);
+
+  for(int i = 1; i <= 100; ++i)
+    emscripten_async_run_in_main_runtime_thread(EM_FUNC_SIG_VI, accumulate, i);
+
+  // More calls than fit in the main thread's call queue, so some of them must run before the flush.
+  for(int i = 1; i <= 1000; ++i)
+    emscripten_async_batched_run_in_main_runtime_thread(EM_FUNC_SIG_VI, accumulate, i);
+  emscripten_async_batched_run_in_main_runtime_thread(EM_FUNC_SIG_VFFFF, set_color, 0.25f, 0.5f, 0.75f, 1.0f);
+  emscripten_main_runtime_thread_flush_batched_calls();
+
+  em_queued_call *call = emscripten_async_waitable_run_in_main_runtime_thread(EM_FUNC_SIG_DI, scale, 5);
+  em_variant_val result;
+  int finished = emscripten_wait_for_call(call, INFINITY, &result);
+  assert(finished);
+  assert(result.d == 2.5);
+  emscripten_async_waitable_close(call);
+
+  // Calls from one thread run in order, so all the calls above have run by now.
+  assert(emscripten_sync_run_in_main_runtime_thread(EM_FUNC_SIG_I, get_sum).i == 5050 + 500500);
+  pthread_exit(0);
+}
+
+int main()
+{
+  int result = 0;
+  if (!emscripten_has_threading_support())
+  {
+#ifdef REPORT_RESULT
+    REPORT_RESULT();
+#endif
+    printf("Skipped: Threading is not supported.\n");
+    return 0;
+  }
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, thread_start, 0);
+  pthread_join(thread, 0);
+
+  if (sum != 5050 + 500500) ++result;
+  if (lastColor[0] != 0.25f || lastColor[3] != 1.0f) ++result;
+
+  // On the main thread itself the calls run immediately.
+  if (emscripten_sync_run_in_main_runtime_thread(EM_FUNC_SIG_III, add, 1, 2).i != 3) ++result;
+
+#ifdef REPORT_RESULT
+  REPORT_RESULT();
+#endif
+}
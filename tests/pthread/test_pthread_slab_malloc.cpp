@@ -0,0 +1,119 @@
+#include <pthread.h>
+#include <emscripten.h>
+#include <emscripten/threading.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" int malloc_trim(size_t pad);
+
+// Stress test for MALLOC="slab": threads allocate small and large objects, and free objects allocated by other threads.
+// This churns slab_lock, and creates and destroys slabs, which sets and clears their bits in the page bitmap while
+// other threads look pointers up in it.
+
+#define NUM_THREADS 8
+#define ITERATIONS 20000
+#define NUM_SLOTS 256
+
+struct Header
+{
+  unsigned size;
+  unsigned seed;
+};
+
+// Objects handed from one thread to another. A slot is taken by swapping in 0.
+static void *slots[NUM_SLOTS];
+
+static unsigned next_random(unsigned *state)
+{
+  *state = *state * 1103515245 + 12345;
+  return *state >> 8;
+}
+
+static void *allocate(unsigned size, unsigned seed)
+{
+  if (size < sizeof(Header)) size = sizeof(Header);
+  unsigned char *p = (unsigned char*)malloc(size);
+  if (!p) return 0;
+  Header h = { size, seed };
+  memcpy(p, &h, sizeof(h));
+  for(unsigned i = sizeof(h); i < size; ++i)
+    p[i] = (unsigned char)(seed + i);
+  return p;
+}
+
+// Returns 0 if the object was corrupted.
+static int release(void *mem)
+{
+  unsigned char *p = (unsigned char*)mem;
+  Header h;
+  memcpy(&h, p, sizeof(h));
+  for(unsigned i = sizeof(h); i < h.size; ++i)
+    if (p[i] != (unsigned char)(h.seed + i))
+      return 0;
+  free(p);
+  return 1;
+}
+
+static void *thread_start(void *arg)
+{
+  unsigned state = (unsigned)(long)arg;
+  void *own[16] = {};
+  long corrupted = 0;
+  for(int i = 0; i < ITERATIONS; ++i)
+  {
+    unsigned r = next_random(&state);
+    // Mostly slab sized objects, with some that go to dlmalloc.
+    unsigned size = (r & 15) == 0 ? 129 + (r >> 4) % 20000 : 1 + (r >> 4) % 128;
+    void *mem = allocate(size, r);
+    if (!mem) return (void*)1;
+
+    unsigned k = (r >> 12) % 16;
+    if (own[k] && !release(own[k])) ++corrupted;
+    own[k] = mem;
+
+    // Hand an object over to whichever thread picks the slot up next.
+    if (r & 1)
+    {
+      unsigned s = (r >> 16) % NUM_SLOTS;
+      void *other = (void*)emscripten_atomic_exchange_u32(&slots[s], (uint32_t)own[k]);
+      own[k] = other;
+    }
+  }
+  for(int k = 0; k < 16; ++k)
+    if (own[k] && !release(own[k])) ++corrupted;
+  return (void*)corrupted;
+}
+
+int main()
+{
+  int result = 0;
+  if (!emscripten_has_threading_support()) {
+#ifdef REPORT_RESULT
+    REPORT_RESULT();
+#endif
+    printf("Skipped: threading support is not available!\n");
+    return 0;
+  }
+
+  pthread_t thr[NUM_THREADS];
+  for(int i = 0; i < NUM_THREADS; ++i)
+    pthread_create(&thr[i], NULL, thread_start, (void*)(long)(i + 1));
+  for(int i = 0; i < NUM_THREADS; ++i) {
+    long res = 0;
+    pthread_join(thr[i], (void**)&res);
+    result += res;
+  }
+  for(int i = 0; i < NUM_SLOTS; ++i)
+    if (slots[i] && !release(slots[i])) ++result;
+
+  // All slabs are empty now, and trimming must release them without touching live objects.
+  malloc_trim(0);
+  void *p = allocate(64, 1);
+  if (!p || !release(p)) ++result;
+
+  printf("Test finished with result %d\n", result);
+#ifdef REPORT_RESULT
+  REPORT_RESULT();
+#endif
+}
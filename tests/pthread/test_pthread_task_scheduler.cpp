@@ -0,0 +1,78 @@
+#include <pthread.h>
+#include <emscripten.h>
+#include <emscripten/threading.h>
+#include <emscripten/task_scheduler.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N 100000
+
+static int values[N];
+
+static void square_range(int begin, int end, void *arg)
+{
+  int *out = (int*)arg;
+  for(int i = begin; i < end; ++i)
+    out[i] = i * i;
+}
+
+static int fib(int n)
+{
+  if (n < 2) return n;
+  int a, b;
+  {
+    // Spawn one half and compute the other on this thread, so the tree of tasks gets stolen all over.
+    emscripten::task_group group;
+    group.run([&a, n]() { a = fib(n-1); });
+    b = fib(n-2);
+  }
+  return a + b;
+}
+
+static int count_errors()
+{
+  int errors = 0;
+
+  memset(values, 0, sizeof(values));
+  emscripten_parallel_for(0, N, 0, square_range, values);
+  for(int i = 0; i < N; ++i)
+    if (values[i] != i * i) ++errors;
+
+  unsigned int sum = 0;
+  emscripten::parallel_for(0, N, [&sum](int i) { emscripten_atomic_add_u32(&sum, i); }, 100);
+  if (sum != (unsigned int)((long long)N * (N-1) / 2)) ++errors;
+
+  if (fib(20) != 6765) ++errors;
+  return errors;
+}
+
+int main()
+{
+  int result = 0;
+  if (!emscripten_has_threading_support())
+  {
+#ifdef REPORT_RESULT
+    REPORT_RESULT();
+#endif
+    printf("Skipped: Threading is not supported.\n");
+    return 0;
+  }
+
+  // Without workers, waiting threads run all the tasks themselves.
+  emscripten_task_scheduler_init(-1);
+  assert(emscripten_task_scheduler_num_workers() == 0);
+  result += count_errors();
+  emscripten_task_scheduler_shutdown();
+
+  emscripten_task_scheduler_init(4);
+  if (emscripten_task_scheduler_init(4) != EBUSY) ++result;
+  result += count_errors();
+  emscripten_task_scheduler_shutdown();
+
+  printf("Errors: %d\n", result);
+#ifdef REPORT_RESULT
+  REPORT_RESULT();
+#endif
+}
@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <string.h>
+
+int main() {
+  // Many lines in a single write.
+  static char buf[64 * 1000];
+  int len = 0;
+  for (int i = 0; i < 1000; i++) {
+    len += sprintf(buf + len, "line %d: ünïcödé 日本語\n", i);
+  }
+  fwrite(buf, 1, len, stdout);
+  fflush(stdout);
+
+  // A line split across writes, in the middle of a multibyte character.
+  const char *split = "split 😀 line\n";
+  fwrite(split, 1, 8, stdout);
+  fflush(stdout);
+  fwrite(split + 8, 1, strlen(split) - 8, stdout);
+  fflush(stdout);
+
+  // A line without a newline at the end is printed once it is complete.
+  printf("no newline yet, ");
+  fflush(stdout);
+  printf("now there is\n");
+
+  // Invalid UTF-8 is decoded the same way as by UTF8ToString, here an overlong '/'.
+  printf("overlong \xc0\xaf slash\n");
+
+  fprintf(stderr, "to stderr\n");
+  printf("done\n");
+  return 0;
+}
@@ -1,4 +1,4 @@
-import math, os, shutil, subprocess
+import json, math, os, shutil, subprocess
 import runner
 from runner import RunnerCore, path_from_root
 from tools.shared import *
@@ -16,6 +16,33 @@ TEST_REPS = 3
 
 CORE_BENCHMARKS = True # core benchmarks vs full regression suite
 
+# Microbenchmarks (see do_microbenchmark) report throughput, higher is better.
+# Their results are written as JSON to EM_BENCHMARK_RESULTS (default:
+# microbenchmarks.json in the directory the runner was started from, since each
+# test runs in a temporary directory). If EM_BENCHMARK_BASELINE names the
+# results file of an earlier run, any result that dropped by more than
+# EM_BENCHMARK_TOLERANCE (a fraction, default 0.1) fails the test.
+# EM_BENCHMARK_UPDATE_BASELINE=1 stores the new results in the baseline file,
+# creating it if needed (default: microbenchmarks_baseline.json next to the
+# results).
+MICROBENCHMARK_PREFIX = 'MICROBENCHMARK '
+MICROBENCHMARK_DIR = os.getcwd()
+
+def parse_microbenchmark_output(output):
+  results = {}
+  for line in output.split('\n'):
+    if line.startswith(MICROBENCHMARK_PREFIX):
+      result = json.loads(line[len(MICROBENCHMARK_PREFIX):])
+      results[result['name']] = result['callsPerSecond']
+  return results
+
+def find_microbenchmark_regressions(results, baseline, tolerance):
+  regressions = []
+  for name in sorted(results):
+    if name in baseline and results[name] < baseline[name] * (1 - tolerance):
+      regressions.append('%s: %d/s, baseline %d/s (%.1f%% slower)' % (name, results[name], baseline[name], 100 * (1 - float(results[name]) / baseline[name])))
+  return regressions
+
 class Benchmarker:
   def __init__(self, name):
     self.name = name
@@ -209,6 +236,30 @@ class benchmark(RunnerCore):
       b.bench(args, output_parser, reps)
       b.display(benchmarkers[0])
 
+  def do_microbenchmark(self, suite, results):
+    print
+    for name in sorted(results):
+      print '   %40s: %12d calls/s' % (name, results[name])
+
+    results_file = os.environ.get('EM_BENCHMARK_RESULTS') or os.path.join(MICROBENCHMARK_DIR, 'microbenchmarks.json')
+    all_results = json.load(open(results_file)) if os.path.exists(results_file) else {}
+    all_results[suite] = results
+    json.dump(all_results, open(results_file, 'w'), indent=2, sort_keys=True)
+    print '   results written to %s' % results_file
+
+    update_baseline = os.environ.get('EM_BENCHMARK_UPDATE_BASELINE')
+    baseline_file = os.environ.get('EM_BENCHMARK_BASELINE')
+    if not baseline_file:
+      if not update_baseline:
+        return
+      baseline_file = os.path.join(os.path.dirname(os.path.abspath(results_file)), 'microbenchmarks_baseline.json')
+    baseline = json.load(open(baseline_file)) if os.path.exists(baseline_file) else {}
+    regressions = find_microbenchmark_regressions(results, baseline.get(suite, {}), float(os.environ.get('EM_BENCHMARK_TOLERANCE') or '0.1'))
+    if update_baseline:
+      baseline[suite] = results
+      json.dump(baseline, open(baseline_file, 'w'), indent=2, sort_keys=True)
+    assert not regressions, 'microbenchmark regressions in %s:\n  %s' % (suite, '\n  '.join(regressions))
+
   def test_primes(self):
     src = r'''
       #include<stdio.h>
@@ -278,6 +329,55 @@ class benchmark(RunnerCore):
     '''
     self.do_benchmark('memops', src, 'final:')
 
+  def small_allocs(self, name, emcc_args=[]):
+    src = r'''
+      #include <stdio.h>
+      #include <map>
+      #include <list>
+      #include <string>
+      int main(int argc, char **argv) {
+        int N, M;
+        int arg = argc > 1 ? argv[1][0] - '0' : 3;
+        switch(arg) {
+          case 0: return 0; break;
+          case 1: N = 10000; M = 5; break;
+          case 2: N = 10000; M = 50; break;
+          case 3: N = 10000; M = 100; break;
+          case 4: N = 10000; M = 500; break;
+          case 5: N = 10000; M = 1000; break;
+          default: printf("error: %d\n", arg); return -1;
+        }
+
+        unsigned final = 0;
+        std::map<int, int> map;
+        std::list<std::string> list;
+        for (int t = 0; t < M; t++) {
+          for (int i = 0; i < N; i++) {
+            map[(i * 7919 + t) % (N * 2)] = i;
+            list.push_back(std::string(1 + (i + t) % 40, 'x'));
+          }
+          for (int i = 0; i < N; i += 2) {
+            map.erase((i * 104729 + t) % (N * 2));
+            list.pop_front();
+          }
+          final = (final + map.size() + list.size() + list.back().size()) % 1000;
+          if (t % 10 == 9) {
+            map.clear();
+            list.clear();
+          }
+        }
+        printf("final: %d.\n", final);
+        return 0;
+      }
+    '''
+    self.do_benchmark(name, src, 'final:', emcc_args=emcc_args)
+
+  def test_small_allocs(self):
+    self.small_allocs('small_allocs')
+
+  def test_small_allocs_slab(self):
+    self.small_allocs('small_allocs_slab', ['-s', 'MALLOC="slab"'])
+
   def zzztest_files(self):
     src = r'''
       #include<stdio.h>
@@ -558,6 +658,61 @@ class benchmark(RunnerCore):
       return 100.0/float(re.search('Unrolled Single  Precision +([\d\.]+) Mflops', output).group(1))
     self.do_benchmark('linpack_float', open(path_from_root('tests', 'linpack.c')).read(), '''Unrolled Single  Precision''', force_c=True, output_parser=output_parser, shared_args=['-DSP'])
 
+  def test_embind_microbenchmarks(self):
+    results = {}
+    for opts in [['-O2'], ['-O3']]:
+      final = os.path.join(self.get_dir(), 'embind_benchmark%s.js' % ''.join(opts))
+      try_delete(final)
+      output = Popen([PYTHON, EMCC, path_from_root('tests', 'embind', 'embind_benchmark.cpp'),
+                      '--bind', '-std=c++11', '--memory-init-file', '0', '-s', 'INVOKE_RUN=0',
+                      '--post-js', path_from_root('tests', 'embind', 'embind.benchmark.js'),
+                      '--post-js', path_from_root('tests', 'embind', 'embind_benchmark_suite.js'),
+                      '-o', final] + opts, stdout=PIPE, stderr=PIPE).communicate()
+      assert os.path.exists(final), 'Failed to compile file: ' + output[1]
+      output = run_js(final, engine=NODE_JS, stderr=PIPE, full_output=True)
+      suite_results = parse_microbenchmark_output(output)
+      assert suite_results, 'no microbenchmark results in output: ' + output
+      for name, value in suite_results.iteritems():
+        results[' '.join(opts) + ' ' + name] = value
+    self.do_microbenchmark('embind', results)
+
+  def test_fs_microbenchmarks(self):
+    results = {}
+    for opts in [['-O2'], ['-O3']]:
+      final = os.path.join(self.get_dir(), 'benchmark_fs%s.js' % ''.join(opts))
+      try_delete(final)
+      output = Popen([PYTHON, EMCC, path_from_root('tests', 'benchmark_fs.c'), '--memory-init-file', '0', '-o', final] + opts, stdout=PIPE, stderr=PIPE).communicate()
+      assert os.path.exists(final), 'Failed to compile file: ' + output[1]
+      output = run_js(final, engine=NODE_JS, stderr=PIPE, full_output=True)
+      assert 'ok.' in output, output
+      suite_results = parse_microbenchmark_output(output)
+      assert suite_results, 'no microbenchmark results in output: ' + output
+      for name, value in suite_results.iteritems():
+        results[' '.join(opts) + ' ' + name] = value
+    self.do_microbenchmark('fs', results)
+
+  def test_pthread_64bit_atomics_microbenchmarks(self):
+    # The shells cannot run pthreads builds, so this runs native builds of the emulated and native 64-bit atomics; the
+    # browser runs the pthreads build in test_browser.test_zzz_pthread_64bit_atomics_benchmark.
+    results = {}
+    for mode, args in [('seqlock', []), ('native', ['-DEMSCRIPTEN_NATIVE_64BIT_ATOMICS'])]:
+      final = os.path.join(self.get_dir(), 'atomics_benchmark_%s' % mode)
+      try_delete(final)
+      objs = []
+      for src in [path_from_root('system', 'lib', 'pthread', 'atomic_u64.c'), path_from_root('tests', 'pthread', 'emscripten_atomics_native.c')]:
+        obj = os.path.join(self.get_dir(), '%s_%s.o' % (os.path.basename(src), mode))
+        Popen([CLANG_CC, '-c', src, '-O2', '-I' + path_from_root('system', 'include'), '-o', obj] + args + get_clang_native_args(), env=get_clang_native_env()).communicate()
+        objs.append(obj)
+      output = Popen([CLANG_CPP, path_from_root('tests', 'pthread', 'test_pthread_64bit_atomics_benchmark.cpp'), '-O2', '-I' + path_from_root('system', 'include'), '-pthread', '-o', final] + objs + args + get_clang_native_args(), env=get_clang_native_env(), stdout=PIPE, stderr=PIPE).communicate()
+      assert os.path.exists(final), 'Failed to compile file: ' + output[1]
+      output = Popen([final], stdout=PIPE, stderr=PIPE).communicate()[0]
+      suite_results = parse_microbenchmark_output(output)
+      assert suite_results, 'no microbenchmark results in output: ' + output
+      for name, value in suite_results.iteritems():
+        if mode == 'seqlock' or not name.startswith('spinlock'): # Both builds run the same spinlock reference.
+          results[name] = value
+    self.do_microbenchmark('atomics', results)
+
   def test_zzz_java_nbody(self): # tests xmlvm compiled java, including bitcasts of doubles, i64 math, etc.
     if CORE_BENCHMARKS: return
     args = [path_from_root('tests', 'nbody-java', x) for x in os.listdir(path_from_root('tests', 'nbody-java')) if x.endswith('.c')] + \
@@ -990,6 +990,8 @@ keydown(100);keyup(100); // trigger the end
     self.btest(os.path.join('fs', 'test_lz4fs.cpp'), '1', args=['-DLOAD_MANUALLY', '-s', 'LZ4=1', '-O2'], timeout=60)
     print '    opts+closure'
     self.btest(os.path.join('fs', 'test_lz4fs.cpp'), '1', args=['-DLOAD_MANUALLY', '-s', 'LZ4=1', '-O2', '--closure', '1', '-g1'], timeout=60)
+    print '    worker read-ahead'
+    self.btest(os.path.join('fs', 'test_lz4fs.cpp'), '1', args=['-DLOAD_MANUALLY', '-s', 'LZ4=1', '-s', 'LZ4_WORKER=1', '-O2', '--closure', '1', '-g1'], timeout=60)
 
     '''# non-lz4 for comparison
     try:
@@ -1406,6 +1408,9 @@ keydown(100);keyup(100); // trigger the end
   def test_gles2_uniform_arrays(self):
     self.btest('gles2_uniform_arrays.cpp', args=['-s', 'GL_ASSERTIONS=1'], expected=['1'], also_proxied=True)
 
+  def test_full_es2_client_arrays(self):
+    self.btest('full_es2_client_arrays.cpp', args=['-s', 'FULL_ES2=1', '-s', 'GL_ASSERTIONS=1'], expected=['1'])
+
   def test_gles2_conformance(self):
     self.btest('gles2_conformance.cpp', args=['-s', 'GL_ASSERTIONS=1'], expected=['1'])
 
@@ -1829,6 +1834,13 @@ void *getBindBuffer() {
     for extra_args in [[], ['--no-heap-copy']]:
       self.btest(path_from_root('tests', 'mmap_file.c'), expected='1', args=['--preload-file', 'data.dat'] + extra_args)
 
+  def test_mmap_preloaded(self):
+    # odd.dat comes first in the package, so data.dat is only aligned if the packager pads it
+    open(self.in_dir('odd.dat'), 'w').write('odd')
+    open(self.in_dir('data.dat'), 'w').write(''.join(chr(ord('a') + i % 26) for i in range(9000)))
+    for extra_args in [['-DHEAP_COPY'], ['--no-heap-copy']]:
+      self.btest(path_from_root('tests', 'mmap_preloaded.c'), expected='1', args=['--preload-file', 'odd.dat', '--preload-file', 'data.dat'] + extra_args)
+
   def test_emrun_info(self):
     result = subprocess.check_output([PYTHON, path_from_root('emrun'), '--system_info', '--browser_info'])
     assert 'CPU' in result
@@ -2624,6 +2636,10 @@ window.close = function() {
   def test_zzz_pthread_64bit_atomics(self):
     self.btest(path_from_root('tests', 'pthread', 'test_pthread_64bit_atomics.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8'], timeout=30)
 
+  # Benchmark 64-bit atomics under contention against the old spinlock emulation.
+  def test_zzz_pthread_64bit_atomics_benchmark(self):
+    self.btest(path_from_root('tests', 'pthread', 'test_pthread_64bit_atomics_benchmark.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=4'], timeout=60)
+
   # Test the old GCC atomic __sync_fetch_and_op builtin operations.
   def test_zzz_pthread_gcc_atomic_fetch_and_op(self):
     # We need to resort to using regexes to optimize out SharedArrayBuffer when pthreads are not supported, which is brittle!
@@ -2699,6 +2715,20 @@ window.close = function() {
   def test_zzz_pthread_malloc_free(self):
     self.btest(path_from_root('tests', 'pthread', 'test_pthread_malloc_free.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8', '-s', 'TOTAL_MEMORY=268435456'], timeout=30)
 
+  # Test memory allocation across threads with per-thread malloc caches.
+  def test_zzz_pthread_malloc_thread_cache(self):
+    for test in ['test_pthread_malloc.cpp', 'test_pthread_malloc_free.cpp']:
+      self.btest(path_from_root('tests', 'pthread', test), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8', '-s', 'TOTAL_MEMORY=268435456', '-s', 'MALLOC_THREAD_CACHE=1'], timeout=30)
+
+  # Test memory allocation across threads with MALLOC="slab", and stress its lock and page bitmap.
+  def test_zzz_pthread_slab_malloc(self):
+    for test in ['test_pthread_malloc.cpp', 'test_pthread_malloc_free.cpp', 'test_pthread_slab_malloc.cpp']:
+      self.btest(path_from_root('tests', 'pthread', test), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8', '-s', 'TOTAL_MEMORY=268435456', '-s', 'MALLOC="slab"'], timeout=30)
+
+  # Test that thread-specific data destructors that allocate do not leak or reuse the thread's malloc cache.
+  def test_zzz_pthread_malloc_thread_cache_dtors(self):
+    self.btest(path_from_root('tests', 'pthread', 'test_pthread_malloc_thread_cache_dtors.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8', '-s', 'MALLOC_THREAD_CACHE=1'], timeout=30)
+
   # Test that the pthread_barrier API works ok.
   def test_zzz_pthread_barrier(self):
     self.btest(path_from_root('tests', 'pthread', 'test_pthread_barrier.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8'], timeout=30)
@@ -2725,6 +2755,23 @@ window.close = function() {
   def test_zzz_pthread_condition_variable(self):
     self.btest(path_from_root('tests', 'pthread', 'test_pthread_condition_variable.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8'], timeout=30)
 
+  # Test requeueing condition variable broadcasts, the futex statistics, and the main thread processing proxied calls while it waits for a mutex.
+  def test_zzz_pthread_futex_requeue(self):
+    self.btest(path_from_root('tests', 'pthread', 'test_pthread_futex_requeue.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8'], timeout=30)
+
+  # Test prewarming and shrinking the pool of pthread workers at runtime, and the pool statistics.
+  def test_zzz_pthread_pool_prewarm(self):
+    self.btest(path_from_root('tests', 'pthread', 'test_pthread_pool_prewarm.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm'], timeout=30)
+
+  # Test shrinking the pool while the startup PTHREAD_POOL_SIZE workers are still loading.
+  def test_zzz_pthread_pool_shrink_while_loading(self):
+    open(os.path.join(self.get_dir(), 'pre.js'), 'w').write('''
+      Module.preRun = function() {
+        setTimeout(function() { _emscripten_pthread_pool_shrink(2); }, 0);
+      };
+    ''')
+    self.btest(path_from_root('tests', 'pthread', 'test_pthread_pool_shrink_while_loading.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=4', '--pre-js', 'pre.js'], timeout=30)
+
   # Test that pthreads are able to do printf.
   def test_zzz_pthread_printf(self):
     self.btest(path_from_root('tests', 'pthread', 'test_pthread_printf.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=1'], timeout=30)
@@ -2745,6 +2792,18 @@ window.close = function() {
   def test_zzz_pthread_file_io(self):
     self.btest(path_from_root('tests', 'pthread', 'test_pthread_file_io.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=1'], timeout=30)
 
+  # Test synchronous and fire-and-forget calls proxied from pthreads to the main thread, including overflowing the call queue.
+  def test_zzz_pthread_run_in_main_thread(self):
+    self.btest(path_from_root('tests', 'pthread', 'test_pthread_run_in_main_thread.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8'], timeout=30)
+
+  # Test proxying calls to arbitrary function pointers from pthreads to the main thread.
+  def test_zzz_pthread_run_on_main_thread_function_ptr(self):
+    self.btest(path_from_root('tests', 'pthread', 'test_pthread_run_on_main_thread_function_ptr.cpp'), expected='0', args=['-O3', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=1'], timeout=30)
+
+  # Test the work-stealing task scheduler library: parallel_for and nested task groups, with and without worker threads.
+  def test_zzz_pthread_task_scheduler(self):
+    self.btest(path_from_root('tests', 'pthread', 'test_pthread_task_scheduler.cpp'), expected='0', args=['-O3', '-std=c++11', '-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=4'], timeout=30)
+
   # Test that the pthread_create() function operates benignly in the case that threading is not supported.
   def test_zzz_pthread_supported(self):
     for args in [[], ['-s', 'USE_PTHREADS=2', '--separate-asm', '-s', 'PTHREAD_POOL_SIZE=8']]:
@@ -5200,6 +5200,11 @@ def process(filename):
     src = open(path_from_root('tests', 'fs', 'test_append.c'), 'r').read()
     self.do_run(src, 'success', force_c=True)
 
+  def test_fs_memfs_paged(self):
+    self.emcc_args += ['-s', 'MEMFS_PAGE_SIZE=64']
+    src = open(path_from_root('tests', 'fs', 'test_memfs_paged.c'), 'r').read()
+    self.do_run(src, 'success', force_c=True)
+
   def test_fs_mmap(self):
     orig_compiler_opts = Building.COMPILER_TEST_OPTS[:]
     for fs in ['MEMFS']:
@@ -5645,6 +5650,38 @@ return malloc(size);
 
     self.do_run_from_file(src, output)
 
+  def test_malloc_api(self):
+    test_path = path_from_root('tests', 'core', 'test_malloc_api')
+    src, output = (test_path + s for s in ('.in', '.out'))
+
+    self.do_run_from_file(src, output)
+
+  def test_slab_malloc(self):
+    self.banned_js_engines = [NODE_JS] # dlmalloc_test is slower there, see test_dlmalloc
+    Settings.MALLOC = 'slab'
+
+    test_path = path_from_root('tests', 'core', 'test_malloc_api')
+    src, output = (test_path + s for s in ('.in', '.out'))
+    self.do_run_from_file(src, output)
+
+    # dlmalloc_test checks that dlmalloc hands out the first freed block again, which does not hold when it mixes slab
+    # and dlmalloc sizes; just check that the allocations succeed and the program completes.
+    Settings.TOTAL_MEMORY = 128*1024*1024
+    src = open(path_from_root('tests', 'dlmalloc_test.c'), 'r').read()
+    self.do_run(src, '*\n', ['200', '1'])
+    self.do_run(src, '*\n', ['400', '400'], no_build=True)
+
+    # With one size per run, slabs also hand out the first freed object again.
+    src = open(path_from_root('tests', 'new.cpp')).read()
+    for new, delete in [
+      ('malloc(100)', 'free'),
+      ('new char[100]', 'delete[]'),
+      ('new Structy', 'delete'),
+      ('new int', 'delete'),
+      ('new Structy[10]', 'delete[]'),
+    ]:
+      self.do_run(src.replace('{{{ NEW }}}', new).replace('{{{ DELETE }}}', delete), '*1,0*')
+
   def test_libcxx(self):
     self.do_run(open(path_from_root('tests', 'hashtest.cpp')).read(),
                  'june -> 30\nPrevious (in alphabetical order) is july\nNext (in alphabetical order) is march')
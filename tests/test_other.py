@@ -2134,14 +2134,49 @@ seeked= file.
     f.close
     assert len(metadata['files']) == 2
     assert metadata['files'][0]['start'] == 0 and metadata['files'][0]['end'] == len('data1') and metadata['files'][0]['filename'] == '/data1.txt'
-    assert metadata['files'][1]['start'] == len('data1') and metadata['files'][1]['end'] == len('data1') + len('data2') and metadata['files'][1]['filename'] == '/subdir/data2.txt'
-    assert metadata['remote_package_size'] == len('data1') + len('data2')
+    # files in the heap copy start at 8-byte alignment
+    assert metadata['files'][1]['start'] == 8 and metadata['files'][1]['end'] == 8 + len('data2') and metadata['files'][1]['filename'] == '/subdir/data2.txt'
+    assert metadata['remote_package_size'] == 8 + len('data2')
     import uuid
     try:
       uuid = uuid.UUID(metadata['package_uuid'], version = 4) # can only assert the uuid format is correct, the uuid's value is expected to differ in between invocation
     except ValueError:
       assert False
 
+  def test_file_packager_chunks(self):
+    import json, base64, hashlib
+    open('big.dat', 'wb').write(os.urandom(20000))
+    shutil.copyfile('big.dat', 'copy.dat')
+    for i in range(20):
+      open('small%d.txt' % i, 'w').write('small file %d ' % i * (i + 1))
+    files = ['big.dat', 'copy.dat'] + ['small%d.txt' % i for i in range(20)]
+    def package(output):
+      Popen([PYTHON, FILE_PACKAGER, 'test.data', '--preload'] + files + ['--chunks=4096', '--use-preload-cache', '--js-output=' + output]).communicate()
+    package('v1.js')
+    # chunks are named after their contents, and files with the same contents are stored once
+    chunks = glob.glob('test.data.*')
+    for chunk in chunks:
+      assert chunk == 'test.data.' + hashlib.sha256(open(chunk, 'rb').read()).hexdigest()
+    assert not os.path.exists('test.data')
+    assert sum(os.path.getsize(chunk) for chunk in chunks) <= sum(os.path.getsize(f) for f in files if f != 'copy.dat') + 8 * len(files)
+    # after a change to one file, only its chunk is new
+    contents = dict((f, open(f, 'rb').read()) for f in files)
+    open('small7.txt', 'a').write('more')
+    package('v2.js')
+    assert len(glob.glob('test.data.*')) == len(chunks) + 1
+    results = [json.loads(line) for line in run_js(path_from_root('tests', 'file_packager_chunks.js'), engine=NODE_JS, args=['v1.js', 'v2.js', 'v2.js']).strip().split('\n')]
+    for result in results:
+      assert len(result['files']) == len(files)
+      for f in files:
+        assert base64.b64decode(result['files']['/' + f]) == (contents[f] if result is results[0] else open(f, 'rb').read()), f
+      # files with the same contents are stored once, but writing to one of them does not change the other
+      assert result['changed']['/copy.dat'] == [] and not any(result['changed'].values()), result['changed']
+    assert len(results[0]['requests']) == len(chunks) and not results[0]['preloadResults']['test.data']['fromCache']
+    assert results[1]['requests'] == [c for c in glob.glob('test.data.*') if c not in chunks]
+    assert results[2]['requests'] == [] and results[2]['preloadResults']['test.data']['fromCache']
+    # the chunk that only the first version used was removed from the cache
+    assert results[2]['cachedChunks'] == results[0]['cachedChunks']
+
   def test_crunch(self):
     try:
       print 'Crunch is located at ' + CRUNCH
@@ -2179,6 +2214,24 @@ SDL_Quit called (and ignored)
 done.
 ''' in output, output
 
+  def test_gl_state_cache(self):
+    # the state cache is exercised against the headless canvas, which records the calls that reach the WebGL context
+    open('pre.js', 'w').write(open(path_from_root('src', 'headlessCanvas.js')).read() + '''
+Module['canvas'] = headlessCanvas();
+''')
+    Popen([PYTHON, EMCC, path_from_root('tests', 'gl_state_cache.c'), '--pre-js', 'pre.js', '-s', 'GL_STATE_CACHE=1']).communicate()
+    output = run_js('a.out.js', engine=NODE_JS, stderr=PIPE)
+    self.assertContained('success', output)
+
+  def test_gl_profile(self):
+    # the profiler wraps every GL function, and must work with the headless canvas
+    open('pre.js', 'w').write(open(path_from_root('src', 'headlessCanvas.js')).read() + '''
+Module['canvas'] = headlessCanvas();
+''')
+    Popen([PYTHON, EMCC, path_from_root('tests', 'gl_profile.c'), '--pre-js', 'pre.js', '-s', 'GL_PROFILE=1']).communicate()
+    output = run_js('a.out.js', engine=NODE_JS, stderr=PIPE)
+    self.assertContained('success', output)
+
   def test_preprocess(self):
     self.clear()
 
@@ -4160,6 +4213,22 @@ main(const int argc, const char * const * const argv)
     print 'yes fs, no fs:', yes_size, no_size
     assert yes_size - no_size > 100000 # 100K of FS code is removed
 
+  def test_stdio_bulk_output(self):
+    for opts in [[], ['-s', 'NO_FILESYSTEM=1'], ['-s', 'NODE_STDIO_PASSTHROUGH=1'], ['-s', 'NO_FILESYSTEM=1', '-s', 'NODE_STDIO_PASSTHROUGH=1']]:
+      print opts
+      check_execute([PYTHON, EMCC, path_from_root('tests', 'stdio_bulk.c')] + opts)
+      out = run_js('a.out.js', engine=NODE_JS, stderr=PIPE, full_output=True)
+      for i in [0, 1, 500, 999]:
+        self.assertContained('line %d: \xc3\xbcn\xc3\xafc\xc3\xb6d\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\n' % i, out)
+      self.assertContained('split \xf0\x9f\x98\x80 line\n', out)
+      self.assertContained('no newline yet, now there is\n', out)
+      if 'NODE_STDIO_PASSTHROUGH=1' in opts:
+        self.assertContained('overlong \xc0\xaf slash\n', out) # the bytes themselves
+      else:
+        self.assertContained('overlong / slash\n', out)
+      self.assertContained('to stderr\n', out)
+      self.assertContained('done\n', out)
+
   def test_no_nuthin(self):
     def test(opts, ratio, absolute):
       print 'opts, ratio, absolute:', opts, ratio, absolute
@@ -5690,3 +5759,74 @@ int main() {
     process = Popen([PYTHON, EMCC] + '-l m -l c -I'.split() + [path_from_root('tests', 'include_test'), path_from_root('tests', 'lib_include_flags.c')], stdout=PIPE, stderr=PIPE)
     process.communicate()
     assert process.returncode is 0, 'Empty -l/-L/-I flags should read the next arg as a param'
+
+  def test_heap_profiler(self):
+    open('src.c', 'w').write(r'''
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emscripten/trace.h>
+void* realloc_in_place(void* p, size_t n);
+void* keep[1000];
+void* resized[1000];
+void __attribute__((noinline)) allocate_kept(int i) {
+  keep[i] = malloc(1000);
+}
+void __attribute__((noinline)) allocate_temporary() {
+  free(malloc(1000));
+}
+void __attribute__((noinline)) shrink_in_place(int i) {
+  if (!realloc_in_place(resized[i], 500)) abort();
+}
+int main() {
+  emscripten_heap_profiler_set_sample_interval(4096);
+  for (int i = 0; i < 1000; i++) {
+    allocate_kept(i);
+    allocate_temporary();
+    resized[i] = malloc(1000);
+    shrink_in_place(i);
+  }
+  size_t size = emscripten_heap_profiler_dump(NULL, 0);
+  char* profile = (char*)malloc(size);
+  emscripten_heap_profiler_dump(profile, size);
+  puts(profile);
+  return 0;
+}
+''')
+    for opts in [0, 2]:
+      print opts
+      check_execute([PYTHON, EMCC, 'src.c', '-s', 'HEAP_PROFILER=1', '--profiling-funcs', '-O' + str(opts)])
+      out = run_js('a.out.js')
+      self.assertContained('--- symbol\n', out)
+      self.assertContained('--- heap\nheap profile: ', out)
+      self.assertContained('@ heap_v2/4096\n', out)
+      symbols = dict(line.split(' ', 1) for line in out.split('--- symbol\n')[1].split('---\n')[0].strip().split('\n'))
+      kept = [address for address, name in symbols.iteritems() if name == '_allocate_kept']
+      temporary = [address for address, name in symbols.iteritems() if name == '_allocate_temporary']
+      shrunk = [address for address, name in symbols.iteritems() if name == '_shrink_in_place']
+      assert kept and temporary and shrunk, symbols
+      # Kept allocations stay in use, temporary ones do not. Chunks resized in place are sampled again.
+      shrunk_live = 0
+      for line in out.split('heap profile: ')[1].split('\n')[1:]:
+        if not line: continue
+        counts, stack = line.split(' @ ')
+        live = int(counts.split(':')[0])
+        innermost = stack.split(' ')[0]
+        if innermost in kept: assert live > 0, line
+        if innermost in temporary: assert live == 0, line
+        if innermost in shrunk: shrunk_live += live
+      assert shrunk_live > 0, out
+
+  def test_pthread_64bit_atomics_native(self):
+    # The asm.js backend lowers 64-bit atomics to calls to the functions in atomic_u64.c, so neither its native path nor
+    # the seqlocks under real hardware threads can be tested there. Build them as native executables instead.
+    for args in [[], ['-DEMSCRIPTEN_NATIVE_64BIT_ATOMICS']]:
+      print args
+      try_delete('atomics')
+      Popen([CLANG_CC, path_from_root('tests', 'pthread', 'test_pthread_64bit_atomics_native.c'),
+             path_from_root('system', 'lib', 'pthread', 'atomic_u64.c'),
+             path_from_root('tests', 'pthread', 'emscripten_atomics_native.c'),
+             '-O2', '-std=gnu99', '-I' + path_from_root('system', 'include'), '-pthread', '-o', 'atomics'] + args + get_clang_native_args(), env=get_clang_native_env()).communicate()
+      assert os.path.exists('atomics')
+      out = Popen([os.path.abspath('atomics')], stdout=PIPE).communicate()[0]
+      self.assertContained('ok\n', out)
@@ -11,7 +11,7 @@ data downloads.
 
 Usage:
 
-  file_packager.py TARGET [--preload A [B..]] [--embed C [D..]] [--exclude E [F..]] [--crunch[=X]] [--js-output=OUTPUT.js] [--no-force] [--use-preload-cache] [--no-heap-copy] [--separate-metadata] [--lz4] [--use-preload-plugins]
+  file_packager.py TARGET [--preload A [B..]] [--embed C [D..]] [--exclude E [F..]] [--crunch[=X]] [--js-output=OUTPUT.js] [--no-force] [--use-preload-cache] [--no-heap-copy] [--separate-metadata] [--lz4] [--use-preload-plugins] [--chunks[=SIZE]]
 
   --preload  ,
   --embed    See emcc --help for more details on those options.
@@ -36,6 +36,7 @@ Usage:
 
   --no-heap-copy If specified, the preloaded filesystem is not copied inside the Emscripten HEAP, but kept in a separate typed array outside it.
                  The default, if this is not specified, is to embed the VFS inside the HEAP, so that mmap()ing files in it is a no-op.
+                 This includes read only MAP_PRIVATE mappings, for which each file in the HEAP is 8-byte aligned.
                  Passing this flag optimizes for fread() usage, omitting it optimizes for mmap() usage.
 
   --separate-metadata Stores package metadata separately. Only applicable when preloading and js-output file is specified.
@@ -46,6 +47,12 @@ Usage:
   --use-preload-plugins Tells the file packager to run preload plugins on the files as they are loaded. This performs tasks like decoding images
                         and audio using the browser's codecs.
 
+  --chunks[=SIZE] Splits the package into chunks of about SIZE bytes (1MB by default), each in a file named after the SHA-256 hash of its
+                  contents (TARGET.HASH), instead of writing one TARGET file. Files with identical contents are stored only once. Large
+                  files are split at fixed offsets from their start, and small ones are grouped at boundaries picked by their contents,
+                  so changing some files leaves the chunks of the others as they were. With --use-preload-cache, chunks are cached in
+                  IndexedDB by their hash, and only chunks that are not there yet are downloaded. Cannot be used with --lz4.
+
 Notes:
 
   * The file packager generates unix-style file paths. So if you are on windows and a file is accessed at
@@ -55,7 +62,7 @@ TODO:        You can also provide .crn files yourself, pre-crunched. With this o
              to dds files in the browser, exactly the same as if this tool compressed them.
 '''
 
-import os, sys, shutil, random, uuid, ctypes
+import os, sys, shutil, random, uuid, ctypes, hashlib
 import posixpath
 import shared
 from shared import execute, suffix, unsuffixed
@@ -63,6 +70,7 @@ from jsrun import run_js
 from subprocess import Popen, PIPE, STDOUT
 import fnmatch
 import json
+from cStringIO import StringIO
 
 if len(sys.argv) == 1:
   print '''Usage: file_packager.py TARGET [--preload A...] [--embed B...] [--exclude C...] [--no-closure] [--crunch[=X]] [--js-output=OUTPUT.js] [--no-force] [--use-preload-cache] [--no-heap-copy] [--separate-metadata]
@@ -104,6 +112,8 @@ no_heap_copy = True
 separate_metadata  = False
 lz4 = False
 use_preload_plugins = False
+# If nonzero, the package is split into content addressed chunks of about this size, see --chunks.
+chunk_size = 0
 
 for arg in sys.argv[2:]:
   if arg == '--preload':
@@ -131,6 +141,10 @@ for arg in sys.argv[2:]:
   elif arg == '--use-preload-plugins':
     use_preload_plugins = True
     leading = ''
+  elif arg.startswith('--chunks'):
+    chunk_size = int(arg.split('=')[1]) if '=' in arg else 1024*1024
+    assert chunk_size > 0, 'chunk size must be positive'
+    leading = ''
   elif arg.startswith('--js-output'):
     jsoutput = arg.split('=')[1] if '=' in arg else None
     leading = ''
@@ -171,6 +185,7 @@ if (not force) and len(data_files) == 0:
   has_preloaded = False
 if not has_preloaded or jsoutput == None:
   assert not separate_metadata, 'cannot separate-metadata without both --preloaded files and a specified --js-output'
+assert not (chunk_size and lz4), 'cannot use --chunks with --lz4'
 
 ret = '''
 var Module;
@@ -377,18 +392,69 @@ for file_ in data_files:
         code += '''Module['FS_createPath']('/%s', '%s', true, true);\n''' % ('/'.join(parts[:i]), parts[i])
         partial_dirs.append(partial)
 
+# Splits a package into chunks for --chunks, returning their (start, end) offsets. unique_files are the (start, end, hash)
+# of the file contents in the package, where end includes any padding after the file. Files of at least chunk_size bytes
+# are split at fixed offsets from their start. Smaller files are grouped, and a group ends after a file whose hash picks
+# it, with a probability proportional to its size so that groups average chunk_size bytes. That choice depends only on
+# the file itself, so changing a file moves at most the boundaries of its own group.
+def split_into_chunks(unique_files, total):
+  boundaries = [0]
+  def cut(offset):
+    offset = min(offset, total)
+    if offset > boundaries[-1]:
+      boundaries.append(offset)
+  for start, end, digest in unique_files:
+    if end - start >= chunk_size:
+      cut(start)
+      for offset in range(start + chunk_size, end, chunk_size):
+        cut(offset)
+      cut(end)
+    elif int(digest[:8], 16) < (end - start) * 0x100000000 / chunk_size or end - boundaries[-1] >= 2 * chunk_size:
+      cut(end)
+  cut(total)
+  return zip(boundaries[:-1], boundaries[1:])
+
 if has_preloaded:
   # Bundle all datafiles into one archive. Avoids doing lots of simultaneous XHRs which has overhead.
-  data = open(data_target, 'wb')
+  data = open(data_target, 'wb') if not chunk_size else StringIO()
   start = 0
+  stored = {} # contents hash => (start, end) in the package, with --chunks files with the same contents are stored once
+  unique_files = []
   for file_ in data_files:
-    file_['data_start'] = start
     curr = open(file_['srcpath'], 'rb').read()
+    if chunk_size:
+      digest = hashlib.sha256(curr).hexdigest()
+      if digest in stored:
+        file_['data_start'], file_['data_end'] = stored[digest]
+        file_['duplicate'] = True
+        continue
+    if no_heap_copy and not lz4:
+      # files in the heap copy start at malloc alignment, so that read only mmap()s of them can point directly at them
+      padding = (-start) % 8
+      data.write('\x00' * padding)
+      start += padding
+    file_['data_start'] = start
     file_['data_end'] = start + len(curr)
+    if chunk_size:
+      stored[digest] = (file_['data_start'], file_['data_end'])
+      padded_end = file_['data_end'] + ((-file_['data_end']) % 8 if no_heap_copy else 0) # keep the padding before the next file out of its chunk
+      unique_files.append((file_['data_start'], padded_end, digest))
     if AV_WORKAROUND: curr += '\x00'
     #print >> sys.stderr, 'bundling', file_['srcpath'], file_['dstpath'], file_['data_start'], file_['data_end']
     start += len(curr)
     data.write(curr)
+  package_size = start
+  if chunk_size:
+    # Write each chunk to a file named by its hash. Files that already exist are left alone, they have the same contents.
+    package_data = data.getvalue()
+    metadata['chunks'] = []
+    for chunk_start, chunk_end in split_into_chunks(unique_files, package_size):
+      chunk = package_data[chunk_start:chunk_end]
+      digest = hashlib.sha256(chunk).hexdigest()
+      chunk_name = data_target + '.' + digest
+      if not os.path.exists(chunk_name):
+        open(chunk_name, 'wb').write(chunk)
+      metadata['chunks'].append({ 'hash': digest, 'start': chunk_start, 'end': chunk_end })
   data.close()
   # TODO: sha256sum on data_target
   if start > 256*1024*1024:
@@ -412,11 +478,12 @@ if has_preloaded:
 
   # Data requests - for getting a block of data out of the big archive - have a similar API to XHRs
   code += '''
-    function DataRequest(start, end, crunched, audio) {
+    function DataRequest(start, end, crunched, audio, duplicate) {
       this.start = start;
       this.end = end;
       this.crunched = crunched;
       this.audio = audio;
+      this.duplicate = duplicate;
     }
     DataRequest.prototype = {
       requests: {},
@@ -428,6 +495,9 @@ if has_preloaded:
       send: function() {},
       onload: function() {
         var byteArray = this.byteArray.subarray(this.start, this.end);
+        // The filesystem owns the data it is given, and writes to the file go to it. Files with the same contents as
+        // an earlier one share its data in the package, so they get a copy of their own.
+        if (this.duplicate) byteArray = new Uint8Array(byteArray);
 %s
           this.finish(byteArray);
 %s
@@ -455,7 +525,7 @@ if has_preloaded:
 ''', create_preloaded if use_preload_plugins else create_data, '''
         var files = metadata.files;
         for (i = 0; i < files.length; ++i) {
-          new DataRequest(files[i].start, files[i].end, files[i].crunched, files[i].audio).open('GET', files[i].filename);
+          new DataRequest(files[i].start, files[i].end, files[i].crunched, files[i].audio, files[i].duplicate).open('GET', files[i].filename);
         }
 ''' if not lz4 else '')
 
@@ -489,6 +559,8 @@ for file_ in data_files:
       'crunched': 1 if crunch and filename.endswith(CRUNCH_INPUT_SUFFIX) else 0,
       'audio': 1 if filename[-4:] in AUDIO_SUFFIXES else 0,
     })
+    if file_.get('duplicate'):
+      metadata['files'][-1]['duplicate'] = 1
   else:
     assert 0
 
@@ -533,8 +605,11 @@ if has_preloaded:
 
   package_uuid = uuid.uuid4();
   package_name = data_target
-  statinfo = os.stat(package_name)
-  remote_package_size = statinfo.st_size
+  if chunk_size:
+    remote_package_size = package_size
+  else:
+    statinfo = os.stat(package_name)
+    remote_package_size = statinfo.st_size
   remote_package_name = os.path.basename(package_name)
   ret += r'''
     var PACKAGE_PATH;
@@ -569,9 +644,10 @@ if has_preloaded:
       var IDB_RO = "readonly";
       var IDB_RW = "readwrite";
       var DB_NAME = 'EM_PRELOAD_CACHE';
-      var DB_VERSION = 1;
+      var DB_VERSION = 2;
       var METADATA_STORE_NAME = 'METADATA';
       var PACKAGE_STORE_NAME = 'PACKAGES';
+      var CHUNK_STORE_NAME = 'CHUNKS';
       function openDatabase(callback, errback) {
         try {
           var openRequest = indexedDB.open(DB_NAME, DB_VERSION);
@@ -590,6 +666,11 @@ if has_preloaded:
             db.deleteObjectStore(METADATA_STORE_NAME);
           }
           var metadata = db.createObjectStore(METADATA_STORE_NAME);
+
+          if(db.objectStoreNames.contains(CHUNK_STORE_NAME)) {
+            db.deleteObjectStore(CHUNK_STORE_NAME);
+          }
+          var chunks = db.createObjectStore(CHUNK_STORE_NAME);
         };
         openRequest.onsuccess = function(event) {
           var db = event.target.result;
@@ -654,6 +735,60 @@ if has_preloaded:
       };
     '''
 
+  if use_preload_cache and chunk_size:
+    code += r'''
+      /* Get the chunks of the package that are cached, by hash */
+      function fetchCachedChunks(db, callback, errback) {
+        var transaction = db.transaction([CHUNK_STORE_NAME], IDB_RO);
+        var chunks = transaction.objectStore(CHUNK_STORE_NAME);
+        var cachedChunks = {};
+
+        PACKAGE_CHUNKS.forEach(function(chunk) {
+          var getRequest = chunks.get(chunk.hash);
+          getRequest.onsuccess = function(event) {
+            var result = event.target.result;
+            if (result) cachedChunks[chunk.hash] = result;
+          };
+        });
+        transaction.oncomplete = function(event) {
+          callback(cachedChunks);
+        };
+        transaction.onerror = function(error) {
+          errback(error);
+        };
+      };
+
+      /* Store the downloaded chunks, and remove those that the previous version of the package used and this one does not */
+      function cacheRemoteChunks(db, packageName, fetchedChunks, callback, errback) {
+        var transaction = db.transaction([CHUNK_STORE_NAME, METADATA_STORE_NAME], IDB_RW);
+        var chunks = transaction.objectStore(CHUNK_STORE_NAME);
+        var metadata = transaction.objectStore(METADATA_STORE_NAME);
+        var hashes = PACKAGE_CHUNKS.map(function(chunk) {
+          return chunk.hash;
+        });
+
+        for (var hash in fetchedChunks) {
+          chunks.put(fetchedChunks[hash], hash);
+        }
+        var getRequest = metadata.get(packageName);
+        getRequest.onsuccess = function(event) {
+          var previous = event.target.result;
+          if (previous && previous.chunks) {
+            previous.chunks.forEach(function(hash) {
+              if (hashes.indexOf(hash) < 0) chunks['delete'](hash);
+            });
+          }
+          metadata.put({uuid: PACKAGE_UUID, chunks: hashes}, packageName);
+        };
+        transaction.oncomplete = function(event) {
+          callback();
+        };
+        transaction.onerror = function(error) {
+          errback(error);
+        };
+      };
+    '''
+
   ret += r'''
     function fetchRemotePackage(packageName, packageSize, callback, errback) {
       var xhr = new XMLHttpRequest();
@@ -701,6 +836,58 @@ if has_preloaded:
     };
   '''
 
+  if chunk_size:
+    ret += r'''
+    var PACKAGE_CHUNKS = metadata.chunks;
+
+    function remoteChunkName(hash) {
+      var name = REMOTE_PACKAGE_BASE + '.' + hash;
+      return typeof Module['locateFile'] === 'function' ? Module['locateFile'](name) : ((Module['filePackagePrefixURL'] || '') + name);
+    };
+
+    // Assemble the package from its chunks, using those in cachedChunks and downloading the others. Calls back with
+    // the package data and the downloaded chunks, both by hash.
+    function fetchRemoteChunks(cachedChunks, callback, errback) {
+      var packageData = new Uint8Array(REMOTE_PACKAGE_SIZE);
+      var chunksByHash = {};
+      PACKAGE_CHUNKS.forEach(function(chunk) {
+        if (!chunksByHash[chunk.hash]) chunksByHash[chunk.hash] = [];
+        chunksByHash[chunk.hash].push(chunk);
+      });
+      var hashes = Object.keys(chunksByHash);
+      var fetchedChunks = {};
+      var remaining = hashes.length;
+      var downloads = hashes.filter(function(hash) {
+        return !cachedChunks[hash];
+      }).length;
+      var failed = false;
+      if (downloads > 1) Module.expectedDataFileDownloads += downloads - 1;
+      function addChunk(hash, chunkData) {
+        chunksByHash[hash].forEach(function(chunk) {
+          packageData.set(new Uint8Array(chunkData), chunk.start);
+        });
+        if (--remaining === 0) {
+          if (downloads > 1) Module.finishedDataFileDownloads += downloads - 1;
+          callback(packageData.buffer, fetchedChunks);
+        }
+      }
+      if (!remaining) return callback(packageData.buffer, fetchedChunks);
+      hashes.forEach(function(hash) {
+        if (cachedChunks[hash]) return addChunk(hash, cachedChunks[hash]);
+        var size = chunksByHash[hash][0].end - chunksByHash[hash][0].start;
+        fetchRemotePackage(remoteChunkName(hash), size, function(chunkData) {
+          if (failed) return;
+          if (chunkData.byteLength !== size) {
+            failed = true;
+            return errback('package chunk ' + hash + ' has size ' + chunkData.byteLength + ' instead of ' + size);
+          }
+          fetchedChunks[hash] = chunkData;
+          addChunk(hash, chunkData);
+        }, errback);
+      });
+    };
+  '''
+
   code += r'''
     function processPackageData(arrayBuffer) {
       Module.finishedDataFileDownloads++;
@@ -717,7 +904,41 @@ if has_preloaded:
     if (!Module.preloadResults) Module.preloadResults = {};
   '''
 
-  if use_preload_cache:
+  if use_preload_cache and chunk_size:
+    code += r'''
+      function preloadFallback(error) {
+        console.error(error);
+        console.error('falling back to default preload behavior');
+        fetchRemoteChunks({}, processPackageData, handleError);
+      };
+
+      openDatabase(
+        function(db) {
+          fetchCachedChunks(db,
+            function(cachedChunks) {
+              fetchRemoteChunks(cachedChunks,
+                function(packageData, fetchedChunks) {
+                  var downloaded = Object.keys(fetchedChunks).length;
+                  Module.preloadResults[PACKAGE_NAME] = {fromCache: !downloaded, chunksFetched: downloaded};
+                  console.info('loading ' + PACKAGE_NAME + ' from cache, with ' + downloaded + ' chunks from remote');
+                  cacheRemoteChunks(db, PACKAGE_PATH + PACKAGE_NAME, fetchedChunks,
+                    function() {
+                      processPackageData(packageData);
+                    },
+                    function(error) {
+                      console.error(error);
+                      processPackageData(packageData);
+                    });
+                }
+              , handleError);
+            }
+          , preloadFallback);
+        }
+      , preloadFallback);
+
+      if (Module['setStatus']) Module['setStatus']('Downloading...');
+    '''
+  elif use_preload_cache:
     code += r'''
       function preloadFallback(error) {
         console.error(error);
@@ -757,7 +978,7 @@ if has_preloaded:
     # Only tricky bit is the fetch is async, but also when runWithFS is called is async, so we handle both orderings.
     ret += r'''
       var fetched = null, fetchedCallback = null;
-      fetchRemotePackage(REMOTE_PACKAGE_NAME, REMOTE_PACKAGE_SIZE, function(data) {
+      %s function(data) {
         if (fetchedCallback) {
           fetchedCallback(data);
           fetchedCallback = null;
@@ -765,7 +986,7 @@ if has_preloaded:
           fetched = data;
         }
       }, handleError);
-    '''
+    ''' % ('fetchRemoteChunks({},' if chunk_size else 'fetchRemotePackage(REMOTE_PACKAGE_NAME, REMOTE_PACKAGE_SIZE,')
 
     code += r'''
       Module.preloadResults[PACKAGE_NAME] = {fromCache: false};
@@ -48,6 +48,7 @@ def calculate(temp_files, in_temp, stdout_, stderr_, forced=[]):
   libcxxabi_symbols = read_symbols(shared.path_from_root('system', 'lib', 'libcxxabi', 'symbols'), exclude=libc_symbols)
   gl_symbols = read_symbols(shared.path_from_root('system', 'lib', 'gl.symbols'))
   pthreads_symbols = read_symbols(shared.path_from_root('system', 'lib', 'pthreads.symbols'))
+  tasks_symbols = read_symbols(shared.path_from_root('system', 'lib', 'tasks.symbols'))
 
   # XXX we should disable EMCC_DEBUG when building libs, just like in the relooper
 
@@ -120,10 +121,16 @@ def calculate(temp_files, in_temp, stdout_, stderr_, forced=[]):
 
   def create_pthreads(libname):
     # Add pthread files.
-    pthreads_files = [os.path.join('pthread', 'library_pthread.c')]
+    pthreads_files = [os.path.join('pthread', 'library_pthread.c'), os.path.join('pthread', 'atomic_u64.c')]
     pthreads_files += [shared.path_from_root('system', 'lib', 'libc', 'musl', 'src', 'thread', x) for x in ('pthread_attr_destroy.c', 'pthread_condattr_setpshared.c', 'pthread_mutex_lock.c', 'pthread_spin_destroy.c', 'pthread_attr_get.c', 'pthread_cond_broadcast.c', 'pthread_mutex_setprioceiling.c', 'pthread_spin_init.c', 'pthread_attr_init.c', 'pthread_cond_destroy.c', 'pthread_mutex_timedlock.c', 'pthread_spin_lock.c', 'pthread_attr_setdetachstate.c', 'pthread_cond_init.c', 'pthread_mutex_trylock.c', 'pthread_spin_trylock.c', 'pthread_attr_setguardsize.c', 'pthread_cond_signal.c', 'pthread_mutex_unlock.c', 'pthread_spin_unlock.c', 'pthread_attr_setinheritsched.c', 'pthread_cond_timedwait.c', 'pthread_once.c', 'sem_destroy.c', 'pthread_attr_setschedparam.c', 'pthread_cond_wait.c', 'pthread_rwlockattr_destroy.c', 'sem_getvalue.c', 'pthread_attr_setschedpolicy.c', 'pthread_equal.c', 'pthread_rwlockattr_init.c', 'sem_init.c', 'pthread_attr_setscope.c', 'pthread_getspecific.c', 'pthread_rwlockattr_setpshared.c', 'sem_open.c', 'pthread_attr_setstack.c', 'pthread_key_create.c', 'pthread_rwlock_destroy.c', 'sem_post.c', 'pthread_attr_setstacksize.c', 'pthread_mutexattr_destroy.c', 'pthread_rwlock_init.c', 'sem_timedwait.c', 'pthread_barrierattr_destroy.c', 'pthread_mutexattr_init.c', 'pthread_rwlock_rdlock.c', 'sem_trywait.c', 'pthread_barrierattr_init.c', 'pthread_mutexattr_setprotocol.c', 'pthread_rwlock_timedrdlock.c', 'sem_unlink.c', 'pthread_barrierattr_setpshared.c', 'pthread_mutexattr_setpshared.c', 'pthread_rwlock_timedwrlock.c', 'sem_wait.c', 'pthread_barrier_destroy.c', 'pthread_mutexattr_setrobust.c', 'pthread_rwlock_tryrdlock.c', '__timedwait.c', 'pthread_barrier_init.c', 'pthread_mutexattr_settype.c', 'pthread_rwlock_trywrlock.c', 'vmlock.c', 'pthread_barrier_wait.c', 'pthread_mutex_consistent.c', 'pthread_rwlock_unlock.c', '__wait.c', 'pthread_condattr_destroy.c', 'pthread_mutex_destroy.c', 'pthread_rwlock_wrlock.c', 'pthread_condattr_init.c', 'pthread_mutex_getprioceiling.c', 'pthread_setcanceltype.c', 'pthread_condattr_setclock.c', 'pthread_mutex_init.c', 'pthread_setspecific.c')]
     return build_libc(libname, pthreads_files, ['-O2', '-s', 'USE_PTHREADS=1'])
 
+  # work-stealing task scheduler
+  def create_tasks(libname):
+    o = in_temp(libname)
+    check_call([shared.PYTHON, shared.EMCC, shared.path_from_root('system', 'lib', 'pthread', 'task_scheduler.c'), '-o', o, '-O2', '-s', 'USE_PTHREADS=1'])
+    return o
+
   # libcxx
   def create_libcxx(libname):
     logging.debug('building libcxx for cache')
@@ -195,6 +202,30 @@ def calculate(temp_files, in_temp, stdout_, stderr_, forced=[]):
   def create_dlmalloc_multithreaded_tracing(libname):
     return create_dlmalloc(libname, ['-O2', '-s', 'USE_PTHREADS=1', '--tracing'])
 
+  def create_dlmalloc_multithreaded_thread_cache(libname):
+    return create_dlmalloc(libname, ['-O2', '-s', 'USE_PTHREADS=1', '-DTHREAD_CACHE=1'])
+
+  def create_dlmalloc_singlethreaded_heap_profiler(libname):
+    return create_dlmalloc(libname, ['-O2', '-DHEAP_PROFILER=1'])
+
+  def create_dlmalloc_multithreaded_heap_profiler(libname):
+    return create_dlmalloc(libname, ['-O2', '-s', 'USE_PTHREADS=1', '-DHEAP_PROFILER=1'])
+
+  def create_slab_malloc(libname, clflags):
+    dlmalloc_o = in_temp('dl' + libname)
+    check_call([shared.PYTHON, shared.EMCC, shared.path_from_root('system', 'lib', 'dlmalloc.c'), '-o', dlmalloc_o, '-O2', '-DUSE_DL_PREFIX'] + clflags)
+    slab_malloc_o = in_temp('slab' + libname)
+    check_call([shared.PYTHON, shared.EMCC, shared.path_from_root('system', 'lib', 'slab_malloc.c'), '-o', slab_malloc_o, '-O2'] + clflags)
+    lib = in_temp(libname)
+    shared.Building.link([dlmalloc_o, slab_malloc_o], lib)
+    return lib
+
+  def create_slab_malloc_singlethreaded(libname):
+    return create_slab_malloc(libname, [])
+
+  def create_slab_malloc_multithreaded(libname):
+    return create_slab_malloc(libname, ['-s', 'USE_PTHREADS=1'])
+
   def create_dlmalloc_split(libname):
     dlmalloc_o = in_temp('dl' + libname)
     check_call([shared.PYTHON, shared.EMCC, shared.path_from_root('system', 'lib', 'dlmalloc.c'), '-o', dlmalloc_o, '-O2', '-DMSPACES', '-DONLY_MSPACES'])
@@ -275,16 +306,36 @@ def calculate(temp_files, in_temp, stdout_, stderr_, forced=[]):
                  ('libcxxabi', 'bc', create_libcxxabi, libcxxabi_symbols, ['libc'],      False),
                  ('gl',        'bc', create_gl,        gl_symbols,        ['libc'],      False)]
 
+  assert shared.Settings.MALLOC in ('dlmalloc', 'slab'), 'invalid MALLOC setting: %s' % shared.Settings.MALLOC
+  use_heap_profiler = shared.Settings.HEAP_PROFILER and not shared.Settings.EMSCRIPTEN_TRACING
+  if use_heap_profiler and shared.Settings.SPLIT_MEMORY:
+    logging.warning('HEAP_PROFILER is not supported with SPLIT_MEMORY, ignoring it')
+    use_heap_profiler = False
+  use_slab_malloc = shared.Settings.MALLOC == 'slab' and not shared.Settings.EMSCRIPTEN_TRACING and not use_heap_profiler
+  if use_slab_malloc and shared.Settings.SPLIT_MEMORY:
+    logging.warning('MALLOC="slab" is not supported with SPLIT_MEMORY, using dlmalloc')
+    use_slab_malloc = False
+
   # malloc dependency is force-added, so when using pthreads, it must be force-added
   # as well, since malloc needs to be thread-safe, so it depends on mutexes.
   if shared.Settings.USE_PTHREADS:
     system_libs += [('libc-mt',                     'bc', create_libc,                           libc_symbols,     [],       False),
                     ('pthreads',                    'bc', create_pthreads,                       pthreads_symbols, ['libc'], False),
+                    ('tasks',                       'bc', create_tasks,                          tasks_symbols,    ['libc'], False),
                     ('dlmalloc_threadsafe',         'bc', create_dlmalloc_multithreaded,         [],               [],       False),
-                    ('dlmalloc_threadsafe_tracing', 'bc', create_dlmalloc_multithreaded_tracing, [],               [],       False)]
+                    ('dlmalloc_threadsafe_tracing', 'bc', create_dlmalloc_multithreaded_tracing, [],               [],       False),
+                    ('dlmalloc_threadsafe_cached',  'bc', create_dlmalloc_multithreaded_thread_cache, [],          [],       False),
+                    ('slab_malloc_threadsafe',      'bc', create_slab_malloc_multithreaded,      [],               [],       False),
+                    ('dlmalloc_threadsafe_heap_profiler', 'bc', create_dlmalloc_multithreaded_heap_profiler, [],   [],       False)]
     force.add('pthreads')
     if shared.Settings.EMSCRIPTEN_TRACING:
       force.add('dlmalloc_threadsafe_tracing')
+    elif use_heap_profiler:
+      force.add('dlmalloc_threadsafe_heap_profiler')
+    elif use_slab_malloc:
+      force.add('slab_malloc_threadsafe')
+    elif shared.Settings.MALLOC_THREAD_CACHE:
+      force.add('dlmalloc_threadsafe_cached')
     else:
       force.add('dlmalloc_threadsafe')
   else:
@@ -293,6 +344,12 @@ def calculate(temp_files, in_temp, stdout_, stderr_, forced=[]):
     if shared.Settings.EMSCRIPTEN_TRACING:
       system_libs += [('dlmalloc_tracing', 'bc', create_dlmalloc_singlethreaded_tracing, [], [], False)]
       force.add('dlmalloc_tracing')
+    elif use_heap_profiler:
+      system_libs += [('dlmalloc_heap_profiler', 'bc', create_dlmalloc_singlethreaded_heap_profiler, [], [], False)]
+      force.add('dlmalloc_heap_profiler')
+    elif use_slab_malloc:
+      system_libs += [('slab_malloc', 'bc', create_slab_malloc_singlethreaded, [], [], False)]
+      force.add('slab_malloc')
     else:
       if shared.Settings.SPLIT_MEMORY:
         system_libs += [('dlmalloc_split', 'bc', create_dlmalloc_split, [], [], False)]